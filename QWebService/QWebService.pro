@@ -25,6 +25,15 @@ SOURCES  += \
     sources/qwebservicemethod.cpp \
     sources/qwsdl.cpp \
     sources/qwebservice.cpp \
+    sources/qwebnetworkpool.cpp \
+    sources/qwebmethodcall.cpp \
+    sources/qwebreplyparser.cpp \
+    sources/qwebcompression.cpp \
+    sources/qwebbatch.cpp \
+    sources/qwebscheduler.cpp \
+    sources/qwebretrypolicy.cpp \
+    sources/qwebmetrics.cpp \
+    sources/qwebmethodinternals.cpp \
 
 HEADERS  += headers/QWebService_global.h \
     headers/QWebService \
@@ -32,12 +41,29 @@ HEADERS  += headers/QWebService_global.h \
     headers/qwebservicemethod.h \
     headers/qwsdl.h \
     headers/qwebservice.h \
+    headers/qwebnetworkpool.h \
+    headers/qwebscheduler.h \
+    headers/qwebretrypolicy.h \
+    headers/qwebmetrics.h \
+    headers/qwebmethodcall.h \
+    headers/qwebcoroutine.h \
+    headers/qwebbatch.h \
+    headers/qwebbatch_p.h \
     headers/qwebmethod_p.h \
+    headers/qwebmethodinternals_p.h \
+    headers/qwebmethodcall_p.h \
+    headers/qwebreplyparser_p.h \
+    headers/qwebcompression_p.h \
+    headers/qwebmetrics_p.h \
     headers/qwebservicemethod_p.h \
     headers/qwebservice_p.h \
     headers/qwsdl_p.h \
     headers/QtWebServiceQml.h
 
+# Request and reply compression (see QWebMethod::setCompressionEnabled()).
+win32: LIBS += -lzlib
+else: LIBS += -lz
+
 symbian {
     #Symbian specific definitions
     MMP_RULES += EXPORTUNFROZEN
@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBBATCH_H
+#define QWEBBATCH_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qpair.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qvariant.h>
+#include "QWebService_global.h"
+#include "qwebmethodcall.h"
+
+class QWebService;
+class QWebBatchPrivate;
+
+class QWEBSERVICESHARED_EXPORT QWebBatch : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef QPair<QString, QMap<QString, QVariant> > Item;
+
+    QWebBatch(QWebService *service, const QList<Item> &items, int maxInFlight = 6,
+              QObject *parent = 0);
+    ~QWebBatch();
+
+    int count() const;
+    int maxInFlight() const;
+    int inFlightCount() const;
+    int finishedCount() const;
+    int errorCount() const;
+    bool isFinished() const;
+    bool waitForFinished(int msecs = 30000);
+
+    QWebMethodCall call(int index) const;
+    QList<QWebMethodCall> results() const;
+
+public slots:
+    void start();
+
+signals:
+    void itemFinished(int index, const QWebMethodCall &call);
+    void finished();
+
+protected:
+    QWebBatchPrivate *d_ptr;
+
+private:
+    Q_DECLARE_PRIVATE(QWebBatch)
+};
+
+#endif // QWEBBATCH_H
@@ -0,0 +1,49 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBBATCH_P_H
+#define QWEBBATCH_P_H
+
+#include <QtCore/qpointer.h>
+#include "qwebbatch.h"
+#include "qwebservice.h"
+
+class QWebBatchPrivate
+{
+    Q_DECLARE_PUBLIC(QWebBatch)
+
+public:
+    QWebBatchPrivate(QWebBatch *q) : q_ptr(q), maxInFlight(6), next(0), inFlight(0),
+        finishedCount(0), errorCount(0), started(false) {}
+    QWebBatch *q_ptr;
+
+    void startNext();
+    void callFinished(int index, const QWebMethodCall &call);
+    void reportItem(int index, const QWebMethodCall &call);
+
+    QPointer<QWebService> service;
+    QList<QWebBatch::Item> items;
+    QList<QWebMethodCall> calls;
+    int maxInFlight;
+    int next;
+    int inFlight;
+    int finishedCount;
+    int errorCount;
+    bool started;
+};
+
+#endif // QWEBBATCH_P_H
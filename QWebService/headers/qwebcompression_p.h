@@ -0,0 +1,51 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBCOMPRESSION_P_H
+#define QWEBCOMPRESSION_P_H
+
+#include <QtCore/qbytearray.h>
+#include "QWebService_global.h"
+
+struct z_stream_s;
+
+class QWEBSERVICESHARED_EXPORT QWebCompressor
+{
+public:
+    static QByteArray gzip(const QByteArray &data, int level = 6);
+};
+
+class QWEBSERVICESHARED_EXPORT QWebDecompressor
+{
+public:
+    QWebDecompressor();
+    ~QWebDecompressor();
+
+    QByteArray decompress(const QByteArray &data);
+    bool hasError() const;
+
+private:
+    Q_DISABLE_COPY(QWebDecompressor)
+
+    z_stream_s *stream;
+    bool initialized;
+    bool rawDeflate;
+    bool error;
+    QByteArray firstBytes;
+};
+
+#endif // QWEBCOMPRESSION_P_H
@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBCOROUTINE_H
+#define QWEBCOROUTINE_H
+
+#include "qwebmethodcall.h"
+
+/*
+  Coroutine support needs C++20 (CONFIG += c++2a, or -std=c++20) - with
+  older standards, this header is empty. QWEBSERVICE_HAS_COROUTINES
+  is defined when it is available.
+  */
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define QWEBSERVICE_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+
+/*!
+    \class QWebMethodCallAwaiter
+    \brief Makes QWebMethodCall awaitable in C++20 coroutines.
+
+    Returned by co_await on a QWebMethodCall. The coroutine is suspended
+    until the call is finished (successfully, with an error, or because it
+    was aborted), and then resumed in the thread of the web method, right
+    after QWebMethod::callFinished() is emitted. co_await gives back
+    the finished call:
+    \code
+    QWebTask fetchBands(QWebService *service)
+    {
+        QWebMethodCall call = co_await service->invoke("getBands");
+        if (call.isErrorState())
+            co_return;
+        ...
+    }
+    \endcode
+
+    Waiting is a continuation stored in the call (see QWebMethodCall::then()),
+    no QObject is created per call.
+  */
+class QWebMethodCallAwaiter
+{
+public:
+    explicit QWebMethodCallAwaiter(const QWebMethodCall &call) : m_call(call) {}
+
+    bool await_ready() const
+    {
+        return (!m_call.isValid() || m_call.isFinished());
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        m_call.then([handle](const QWebMethodCall &) { handle.resume(); });
+    }
+
+    QWebMethodCall await_resume() const
+    {
+        return m_call;
+    }
+
+private:
+    QWebMethodCall m_call;
+};
+
+inline QWebMethodCallAwaiter operator co_await(const QWebMethodCall &call)
+{
+    return QWebMethodCallAwaiter(call);
+}
+
+/*!
+    \class QWebTask
+    \brief Return type of coroutines awaiting web method calls.
+
+    Minimal, fire-and-forget coroutine type: the coroutine starts
+    running at once, and its frame is destroyed when it ends. Exceptions
+    escaping the coroutine terminate the application.
+  */
+class QWebTask
+{
+public:
+    struct promise_type
+    {
+        QWebTask get_return_object() { return QWebTask(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+#endif // __has_include(<coroutine>)
+#endif // __cpp_impl_coroutine
+
+#endif // QWEBCOROUTINE_H
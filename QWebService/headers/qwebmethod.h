@@ -30,7 +30,12 @@
 #include <QtCore/qbytearray.h>
 #include <QtCore/qdatetime.h>
 #include <QtCore/qcoreapplication.h>
+#include <QtCore/qiodevice.h>
+#include <QtCore/qjsondocument.h>
+#include <functional>
 #include "QWebService_global.h"
+#include "qwebmethodcall.h"
+#include "qwebretrypolicy.h"
 
 class QWebMethodPrivate;
 
@@ -38,7 +43,7 @@ class QWEBSERVICESHARED_EXPORT QWebMethod : public QObject
 {
     Q_OBJECT
     Q_FLAGS(Protocols)
-    Q_ENUMS(HttpMethod)
+    Q_ENUMS(HttpMethod HttpTransport Priority)
 
     Q_PROPERTY(QString host READ host WRITE setHost NOTIFY hostChanged)
     Q_PROPERTY(QUrl hostUrl READ hostUrl WRITE setHost NOTIFY hostUrlChanged)
@@ -47,6 +52,8 @@ class QWEBSERVICESHARED_EXPORT QWebMethod : public QObject
     Q_PROPERTY(QStringList parameterNames READ parameterNames NOTIFY parameterNamesChanged)
     Q_PROPERTY(QString protocol READ protocolString WRITE setProtocol NOTIFY protocolChanged)
     Q_PROPERTY(QString httpMethod READ httpMethodString WRITE setHttpMethod NOTIFY httpMethodChanged)
+    Q_PROPERTY(bool incrementalParsing READ isIncrementalParsing WRITE setIncrementalParsing NOTIFY incrementalParsingChanged)
+    Q_PROPERTY(int timeout READ timeout WRITE setTimeout NOTIFY timeoutChanged)
 
 public:
     enum Protocol
@@ -61,6 +68,8 @@ public:
     };
     Q_DECLARE_FLAGS(Protocols, Protocol)
 
+    typedef std::function<QByteArray ()> RequestGenerator;
+
     enum HttpMethod
     {
         Post    = 0x1,
@@ -69,6 +78,19 @@ public:
         Delete  = 0x8
     };
 
+    enum HttpTransport
+    {
+        Http1,
+        Http2,
+        Http2Direct
+    };
+
+    enum Priority
+    {
+        Interactive,
+        Bulk
+    };
+
     explicit QWebMethod(QObject *parent = 0,
                         Protocol protocol = Soap12,
                         HttpMethod httpMethod = Post);
@@ -115,8 +137,58 @@ public:
     void setHttpMethod(HttpMethod method);
     bool setHttpMethod(const QString &newMethod);
 
+    bool isNetworkManagerShared() const;
+    void setNetworkManagerShared(bool shared);
+
+    bool isIncrementalParsing() const;
+    void setIncrementalParsing(bool incremental);
+
+    HttpTransport httpTransport() const;
+    void setHttpTransport(HttpTransport transport);
+    Priority priority() const;
+    void setPriority(Priority priority);
+    bool isIdempotent() const;
+    void setIdempotent(bool idempotent);
+    QWebRetryPolicy retryPolicy() const;
+    void setRetryPolicy(const QWebRetryPolicy &policy);
+    int hedgingDelay() const;
+    void setHedgingDelay(int msecs);
+    int hedgingBudget() const;
+    void setHedgingBudget(int percent);
+    QList<QUrl> hedgingEndpoints() const;
+    void setHedgingEndpoints(const QList<QUrl> &endpoints);
+    quint64 hedgedCallCount() const;
+    quint64 hedgeWinCount() const;
+    bool isCoalescing() const;
+    void setCoalescing(bool coalescing);
+    quint64 coalescedCallCount() const;
+    int timeout() const;
+    void setTimeout(int msecs);
+
+    bool isCompressionEnabled() const;
+    void setCompressionEnabled(bool enabled);
+    int compressionThreshold() const;
+    void setCompressionThreshold(int bytes);
+    qint64 bytesSent() const;
+    qint64 uncompressedBytesSent() const;
+    qint64 bytesReceived() const;
+    qint64 uncompressedBytesReceived() const;
+    void resetByteCounters();
+
+    QWebMethodCall invoke(const QByteArray &requestData = QByteArray());
+    QWebMethodCall invoke(QIODevice *requestBody, qint64 size = -1);
+    QWebMethodCall invoke(const RequestGenerator &generator, qint64 size = -1);
+    QWebMethodCall invokeAndWait(int msecs = 30000,
+                                 const QByteArray &requestData = QByteArray());
+    QFuture<QWebMethodCall> invokeFuture(const QByteArray &requestData = QByteArray());
     Q_INVOKABLE bool invokeMethod(const QByteArray &requestData = QByteArray());
-    QVariant replyReadParsed();
+    Q_INVOKABLE bool invokeMethodFor(QObject *owner,
+                                     const QByteArray &requestData = QByteArray());
+    Q_INVOKABLE int pendingCallCount() const;
+    Q_INVOKABLE void cancelPendingCalls();
+    Q_INVOKABLE QVariant replyReadParsed();
+    QJsonDocument replyReadJson();
+    Q_INVOKABLE QVariant replyValue(const QString &jsonPointer);
     QByteArray replyReadRaw();
     Q_INVOKABLE QString replyRead();
 
@@ -126,6 +198,9 @@ public:
 
 signals:
     void replyReady(const QByteArray &reply);
+    void callFinished(const QWebMethodCall &call);
+    void replyItemReceived(const QWebMethodCall &call, const QString &name,
+                           const QVariant &value);
     void errorEncountered(const QString &errMessage);
 
     // For QObject properties:
@@ -136,11 +211,19 @@ signals:
     void parameterNamesChanged();
     void protocolChanged();
     void httpMethodChanged();
+    void incrementalParsingChanged();
+    void timeoutChanged();
 
 protected slots:
+    void networkReplyFinished();
+    void networkReplyReadyRead();
+    void networkReplyMetaDataChanged();
+    void networkReplyEncrypted();
     void replyFinished(QNetworkReply *reply);
     void authReplyFinished(QNetworkReply *reply);
     void authenticationSlot(QNetworkReply *reply, QAuthenticator *authenticator);
+    void deadlineTimeout();
+    void callOwnerDestroyed(QObject *owner);
 
 protected:
     QWebMethod(QWebMethodPrivate &d,
@@ -150,6 +233,9 @@ protected:
 
 private:
     Q_DECLARE_PRIVATE(QWebMethod)
+    friend class QWebMethodCall;
+    friend class QWebServicePrivate;
+    friend class QWebMethodInternals;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QWebMethod::Protocols)
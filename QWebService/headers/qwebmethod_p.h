@@ -28,7 +28,16 @@
 #include <QtCore/qvariant.h>
 #include <QtCore/qmap.h>
 #include <QtCore/qbytearray.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qxmlstream.h>
+#include <QtCore/qjsondocument.h>
 #include "qwebmethod.h"
+#include "qwebmethodcall_p.h"
+#include "qwebnetworkpool.h"
+#include "qwebscheduler.h"
+#include "qwebmetrics_p.h"
 
 class QWebMethodPrivate
 {
@@ -40,7 +49,56 @@ public:
     QWebMethod *q_ptr;
 
     void init();
+    void releaseManager();
+    static void completeDroppedCalls(const QList<QWebMethodCall> &droppedCalls);
+    void waitForAuthentication();
+    QWebMethodCallPrivate *newCallData();
+    QWebMethodCall createCall(const QByteArray &requestData,
+                              QIODevice *requestDevice = 0, qint64 requestSize = -1);
+    QWebMethodCall cachedCall(const QByteArray &requestData, const QByteArray &replyData);
+    QByteArray flightKey(const QByteArray &requestData) const;
+    QWebMethodCall joinFlight(const QByteArray &requestData);
+    void finishFlight(const QWebMethodCall &flight, bool replied);
+    QNetworkRequest prepareRequest();
+    void sendCall(const QWebMethodCall &call);
+    void finishCall(const QWebMethodCall &call, QNetworkReply *netReply);
+    void scheduleCall(const QWebMethodCall &call);
+    bool dispatchCall(const QWebMethodCall &call);
+    QNetworkReply *sendRequest(const QWebMethodCall &call, const QNetworkRequest &request);
+    void sendHedge(const QWebMethodCall &call, QNetworkReply *primary);
+    bool dispatchHedge(const QWebMethodCall &call, QNetworkReply *primary,
+                       const QNetworkRequest &request);
+    static void releaseHedge(QWebMethodCallPrivate *callData);
+    bool settleHedge(const QWebMethodCall &call, QNetworkReply *netReply);
+    bool isRetryable(const QWebMethodCall &call, QNetworkReply *netReply) const;
+    bool retryCall(const QWebMethodCall &call, QNetworkReply *netReply);
+    static QString soapFaultCode(const QByteArray &replyData);
+    void setCallDeadline(const QWebMethodCall &call, qint64 deadline);
+    void clearCallDeadline(const QWebMethodCall &call);
+    void startDeadlineTimer();
+    void cancelCall(const QWebMethodCall &call);
+    QList<QWebMethodCall> unfinishedCalls() const;
+    QList<QWebMethodCall> waitingCalls() const;
+    void abortCall(const QWebMethodCall &call, bool timedOut);
+    void failQueuedCall(const QWebMethodCall &call, const QString &errorMessage);
+    void recordMetrics(const QWebMethodCall &call);
+    static QWebMethodCall failedCall(const QString &methodName, const QString &errorMessage);
+    void readReplyData(const QWebMethodCall &call, QNetworkReply *netReply);
+    void emitReplyItems(const QWebMethodCall &call);
+    void prepareEnvelope();
+    static void writeXmlValue(QXmlStreamWriter &writer, const QString &name,
+                              const QVariant &value);
+    void writeRequestData(QIODevice *device, const QMap<QString, QVariant> &params);
+    QByteArray serializeRequest(const QMap<QString, QVariant> &params);
     void prepareRequestData();
+    static QVariant convertXmlText(const QString &text, int type);
+    static QVariant readXmlValue(QXmlStreamReader &reader, int type);
+    static QVariant decodeXmlReply(const QByteArray &replyData,
+                                   const QMap<QString, QVariant> &returnValue,
+                                   QString *errorMessage);
+    static QVariant decodeReply(const QByteArray &replyData, int protocol,
+                                const QMap<QString, QVariant> &returnValue,
+                                QString *errorMessage);
     QString convertReplyToUtf(const QString &textToConvert);
     bool enterErrorState(const QString &errMessage = QString());
 
@@ -60,8 +118,74 @@ public:
     QByteArray reply;
     QMap<QString, QVariant> parameters;
     QMap<QString, QVariant> returnValue;
+    QVariant parsedReply;
+    bool parsedReplyCached;
+    QJsonDocument jsonReply;
+    bool jsonReplyCached;
     QNetworkAccessManager *manager;
+    bool sharedManager;
+    bool incrementalParsing;
+    QWebMethod::HttpTransport httpTransport;
+    QWebMethod::Priority priority;
+    bool idempotent;
+    QWebRetryPolicy retryPolicy;
+    int hedgingDelay;
+    int hedgingBudget;
+    QList<QUrl> hedgingEndpoints;
+    int nextHedgingEndpoint;
+    quint64 hedgeEligibleCount;
+    quint64 hedgedCallCount;
+    quint64 hedgeWinCount;
+    bool coalescing;
+    quint64 coalescedCallCount;
+    // Unfinished flights of coalesced calls, by flightKey().
+    QHash<QByteArray, QWebMethodCall> flights;
+    int timeout;
+    // Calls with a deadline, by deadline. One timer serves all of them.
+    QElapsedTimer deadlineClock;
+    QMultiMap<qint64, QWebMethodCall> deadlines;
+    QTimer *deadlineTimer;
+    // Calls waiting in QWebScheduler, by call ID.
+    QHash<quint64, QWebMethodCall> queuedCalls;
+    bool compressionEnabled;
+    int compressionThreshold;
+    qint64 bytesSent;
+    qint64 uncompressedBytesSent;
+    qint64 bytesReceived;
+    qint64 uncompressedBytesReceived;
+    QNetworkReply *authReply;
+    QHash<QNetworkReply *, QWebMethodCall> pendingCalls;
     QByteArray data;
+
+    // Cached SOAP envelope, see prepareEnvelope().
+    QWebMethod::Protocol envelopeProtocol;
+    QString envelopeMethodName;
+    QString envelopeNamespace;
+    QByteArray envelopePrefix;
+    QByteArray envelopeSuffix;
+    int lastRequestSize;
+};
+
+class QWebRequestGeneratorDevice : public QIODevice
+{
+public:
+    QWebRequestGeneratorDevice(const QWebMethod::RequestGenerator &generator);
+
+    bool isSequential() const;
+    bool atEnd() const;
+    qint64 bytesAvailable() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+    void fetchChunk();
+
+    QWebMethod::RequestGenerator generator;
+    QByteArray chunk;
+    int position;
+    bool finished;
 };
 
 #endif // QWEBMETHOD_P_H
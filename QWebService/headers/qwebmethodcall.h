@@ -0,0 +1,115 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBMETHODCALL_H
+#define QWEBMETHODCALL_H
+
+#include <QtCore/qshareddata.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qfuture.h>
+#include <functional>
+#include "QWebService_global.h"
+
+class QWebMethodCallPrivate;
+class QObject;
+
+class QWEBSERVICESHARED_EXPORT QWebCallTiming
+{
+public:
+    QWebCallTiming();
+
+    qint64 serializeTime() const;
+    qint64 retryTime() const;
+    qint64 queueTime() const;
+    qint64 connectTime() const;
+    qint64 serverTime() const;
+    qint64 timeToFirstByte() const;
+    qint64 downloadTime() const;
+    qint64 parseTime() const;
+    qint64 totalTime() const;
+
+private:
+    friend class QWebMethodPrivate;
+    friend class QWebMethodCallPrivate;
+    friend class QWebMethod;
+
+    // Microseconds since the call was invoked, or -1.
+    qint64 serialized;
+    // Last attempt entered QWebScheduler's queue (-1 for the first one).
+    qint64 queued;
+    qint64 dispatched;
+    qint64 encrypted;
+    qint64 headersReceived;
+    qint64 firstByte;
+    qint64 finished;
+    // Duration, in microseconds, or -1.
+    qint64 parsed;
+};
+
+class QWEBSERVICESHARED_EXPORT QWebMethodCall
+{
+public:
+    QWebMethodCall();
+    QWebMethodCall(const QWebMethodCall &other);
+    ~QWebMethodCall();
+    QWebMethodCall &operator=(const QWebMethodCall &other);
+
+    bool operator==(const QWebMethodCall &other) const;
+    bool operator!=(const QWebMethodCall &other) const;
+
+    bool isValid() const;
+    quint64 id() const;
+    QString methodName() const;
+
+    bool isFinished() const;
+    bool isErrorState() const;
+    QString errorInfo() const;
+    int httpStatusCode() const;
+    bool isHttp2Used() const;
+    int attemptCount() const;
+    bool isHedged() const;
+    bool isFromCache() const;
+    QWebCallTiming timing() const;
+    bool waitForFinished(int msecs = 30000);
+    void cancel();
+    void setDeadline(const QDateTime &deadline);
+    QWebMethodCall cancelWith(QObject *owner) const;
+
+    QByteArray requestData() const;
+    QByteArray replyReadRaw() const;
+    QVariant result() const;
+
+    typedef std::function<void (const QWebMethodCall &)> Continuation;
+    QWebMethodCall then(const Continuation &continuation) const;
+    QFuture<QWebMethodCall> future() const;
+
+private:
+    explicit QWebMethodCall(QWebMethodCallPrivate *dd);
+
+    QExplicitlySharedDataPointer<QWebMethodCallPrivate> d;
+
+    friend class QWebMethod;
+    friend class QWebMethodPrivate;
+};
+
+Q_DECLARE_METATYPE(QWebMethodCall)
+
+#endif // QWEBMETHODCALL_H
@@ -0,0 +1,108 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBMETHODCALL_P_H
+#define QWEBMETHODCALL_P_H
+
+#include <QtNetwork/qnetworkreply.h>
+#include <QtNetwork/qnetworkrequest.h>
+#include <QtNetwork/qnetworkaccessmanager.h>
+#include <QtCore/qshareddata.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qfutureinterface.h>
+#include <QtCore/qelapsedtimer.h>
+#include "qwebmethodcall.h"
+#include "qwebreplyparser_p.h"
+#include "qwebcompression_p.h"
+
+class QWebMethod;
+struct QWebMetricsSeries;
+
+class QWebMethodCallPrivate : public QSharedData
+{
+public:
+    QWebMethodCallPrivate();
+    ~QWebMethodCallPrivate();
+
+    void resetReply();
+    void decodeResult();
+    void complete(const QWebMethodCall &call);
+
+    quint64 id;
+    QString methodName;
+    QPointer<QWebMethod> method;
+    // Time (of QWebMethodPrivate::deadlineClock) the call is aborted at, or -1.
+    qint64 deadline;
+    // Only compared, when owner is being destroyed.
+    QObject *owner;
+    QPointer<QNetworkReply> networkReply;
+    // Duplicate request, racing networkReply (see QWebMethod::setHedgingDelay()).
+    QPointer<QNetworkReply> hedgeReply;
+    bool hedged;
+    // Original request failed first, and the call waits for the hedge.
+    bool hedgeWon;
+    // True while the hedge holds a connection slot of QWebScheduler.
+    bool hedgeScheduled;
+    QUrl hedgeUrl;
+    bool fromCache;
+    // Coalescing (see QWebMethod::setCoalescing()): a flight is the call
+    // actually sent, on behalf of the (coalesced) calls waiting for it.
+    QByteArray flightKey;
+    bool flight;
+    bool coalesced;
+    QList<QWebMethodCall> waiters;
+    QNetworkRequest request;
+    QNetworkAccessManager::Operation operation;
+    // True while the call holds a connection slot of QWebScheduler.
+    bool scheduled;
+    // HTTP/2 calls are capped by streams, not connections.
+    bool multiplexed;
+    QByteArray requestData;
+    QPointer<QIODevice> requestDevice;
+    bool ownsRequestDevice;
+    qint64 requestSize;
+    QByteArray reply;
+    bool finished;
+    bool errorState;
+    QString errorMessage;
+    int httpStatus;
+    bool http2Used;
+    bool timedOut;
+    int attempts;
+    // Series the call is recorded in (see QWebMetrics), or 0.
+    QWebMetricsSeries *metrics;
+    // Started when the call is invoked, see timing.
+    QElapsedTimer clock;
+    QWebCallTiming timing;
+    QWebReplyParser *parser;
+    bool requestCompressed;
+    bool acceptsCompressedReply;
+    bool replyEncodingChecked;
+    QWebDecompressor *decompressor;
+    int protocol;
+    QMap<QString, QVariant> returnValue;
+    QVariant result;
+    bool resultDecoded;
+    QFutureInterface<QWebMethodCall> *promise;
+    QList<QWebMethodCall::Continuation> continuations;
+};
+
+#endif // QWEBMETHODCALL_P_H
@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#ifndef QWEBMETRICS_H
+#define QWEBMETRICS_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include "QWebService_global.h"
+
+class QWEBSERVICESHARED_EXPORT QWebMetrics
+{
+public:
+    enum Phase
+    {
+        Serialize,
+        Queue,
+        Connect,
+        Server,
+        Download,
+        Parse
+    };
+
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    static QStringList methodNames();
+    static QStringList hosts();
+
+    static quint64 callCount(const QString &methodName = QString(),
+                             const QString &host = QString());
+    static int inFlightCount(const QString &methodName = QString(),
+                             const QString &host = QString());
+    static quint64 errorCount(const QString &methodName = QString(),
+                              const QString &host = QString());
+    static qint64 requestBytes(const QString &methodName = QString(),
+                               const QString &host = QString());
+    static qint64 responseBytes(const QString &methodName = QString(),
+                                const QString &host = QString());
+    static double latencyPercentile(double percentile,
+                                    const QString &methodName = QString(),
+                                    const QString &host = QString());
+    static double phasePercentile(Phase phase, double percentile,
+                                  const QString &methodName = QString(),
+                                  const QString &host = QString());
+
+    static int slowCallThreshold();
+    static void setSlowCallThreshold(int msecs);
+
+    static QByteArray toOpenMetrics();
+    static void reset();
+
+private:
+    QWebMetrics();
+    Q_DISABLE_COPY(QWebMetrics)
+};
+
+#endif // QWEBMETRICS_H
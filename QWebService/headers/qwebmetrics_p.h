@@ -0,0 +1,76 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#ifndef QWEBMETRICS_P_H
+#define QWEBMETRICS_P_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qurl.h>
+#include "qwebmetrics.h"
+#include "qwebmethodcall.h"
+
+// Log-linear histogram of durations in microseconds (like HdrHistogram):
+// 16 buckets per power of two, so values are kept with about 6% precision,
+// up to 2^40 us (12 days). Recording is lock-free.
+class QWebHistogram
+{
+public:
+    enum { SubBuckets = 16, MaxExponent = 40, BucketCount = 592 };
+
+    void record(qint64 usecs);
+    void reset();
+    void addTo(quint64 *counts) const;
+
+    static int bucketIndex(qint64 usecs);
+    static qint64 bucketValue(int index);
+    static qint64 percentile(const quint64 *counts, double percentile);
+
+    QAtomicInteger<quint64> buckets[BucketCount];
+    QAtomicInteger<quint64> count;
+    QAtomicInteger<qint64> sum;
+};
+
+// Metrics of calls of one web method, to one host.
+struct QWebMetricsSeries
+{
+    QString methodName;
+    QString host;
+    QAtomicInteger<quint64> calls;
+    QAtomicInt inFlight;
+    QAtomicInteger<quint64> errors;
+    QAtomicInteger<qint64> requestBytes;
+    QAtomicInteger<qint64> responseBytes;
+    QWebHistogram latency;
+    QWebHistogram phases[QWebMetrics::Parse + 1];
+};
+
+class QWebMetricsPrivate
+{
+public:
+    static QWebMetricsSeries *series(const QString &methodName, const QUrl &url);
+    static QString hostName(const QUrl &url);
+    static void callStarted(QWebMetricsSeries *series, qint64 requestBytes);
+    static void callFinished(QWebMetricsSeries *series, qint64 usecs,
+                             qint64 responseBytes, bool error);
+    static void phaseFinished(QWebMetricsSeries *series, QWebMetrics::Phase phase,
+                              qint64 usecs);
+    static void timingFinished(QWebMetricsSeries *series, const QWebCallTiming &timing);
+    static void logSlowCall(const QString &methodName, const QUrl &url,
+                            const QWebCallTiming &timing);
+};
+
+#endif // QWEBMETRICS_P_H
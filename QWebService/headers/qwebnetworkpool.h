@@ -0,0 +1,51 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBNETWORKPOOL_H
+#define QWEBNETWORKPOOL_H
+
+#include <QtNetwork/qnetworkaccessmanager.h>
+#include <QtNetwork/qnetworkreply.h>
+#include <QtCore/qurl.h>
+#include "QWebService_global.h"
+
+class QWEBSERVICESHARED_EXPORT QWebNetworkPool
+{
+public:
+    static QNetworkAccessManager *acquire();
+    static void release(QNetworkAccessManager *manager);
+    static bool isShared(QNetworkAccessManager *manager);
+
+    static void registerRequest(QNetworkAccessManager *manager, const QUrl &url);
+    static void registerHttp2Stream(QNetworkAccessManager *manager, const QUrl &url);
+    static bool waitForFinished(QNetworkReply *reply, int msecs = 30000);
+
+    static int managerCount();
+    static int referenceCount();
+    static quint64 requestCount();
+    static quint64 knownHostRequestCount();
+    static quint64 http2StreamCount();
+    static int http2ConnectionCount();
+    static double streamsPerConnection();
+    static void resetCounters();
+
+private:
+    QWebNetworkPool();
+    Q_DISABLE_COPY(QWebNetworkPool)
+};
+
+#endif // QWEBNETWORKPOOL_H
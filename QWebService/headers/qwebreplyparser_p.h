@@ -0,0 +1,81 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBREPLYPARSER_P_H
+#define QWEBREPLYPARSER_P_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qxmlstream.h>
+#include "QWebService_global.h"
+
+class QWEBSERVICESHARED_EXPORT QWebReplyParser
+{
+public:
+    enum Format
+    {
+        Xml,
+        Json
+    };
+
+    explicit QWebReplyParser(Format format = Xml);
+
+    Format format() const;
+    void addData(const QByteArray &data);
+    void finish();
+    bool readNext();
+
+    QString name() const;
+    QVariant value() const;
+    bool hasError() const;
+    QString errorString() const;
+
+    static QStringList jsonPointerTokens(const QString &pointer, bool *valid = 0);
+    static QByteArray jsonPointerSlice(const QByteArray &json, const QString &pointer);
+
+private:
+    bool readNextXml();
+    bool readNextJson();
+    bool takeJsonItem(int end);
+
+    Format m_format;
+    bool finished;
+    bool error;
+    QString m_errorString;
+    QString m_name;
+    QVariant m_value;
+
+    // XML state.
+    QXmlStreamReader xml;
+    QStringList elementStack;
+    QString text;
+    bool leaf;
+
+    // JSON state.
+    QByteArray buffer;
+    int scanPosition;
+    int itemStart;
+    int depth;
+    bool inString;
+    bool escaped;
+    bool topLevelObject;
+    bool containerStarted;
+};
+
+#endif // QWEBREPLYPARSER_P_H
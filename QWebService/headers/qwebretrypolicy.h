@@ -0,0 +1,55 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#ifndef QWEBRETRYPOLICY_H
+#define QWEBRETRYPOLICY_H
+
+#include <QtNetwork/qnetworkreply.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qstringlist.h>
+#include "QWebService_global.h"
+
+class QWEBSERVICESHARED_EXPORT QWebRetryPolicy
+{
+public:
+    QWebRetryPolicy(int maxAttempts = 3, int baseDelay = 200, int maxDelay = 10000);
+
+    int maxAttempts() const;
+    void setMaxAttempts(int attempts);
+    int baseDelay() const;
+    void setBaseDelay(int msecs);
+    int maxDelay() const;
+    void setMaxDelay(int msecs);
+
+    QList<int> retryableHttpStatuses() const;
+    void setRetryableHttpStatuses(const QList<int> &statuses);
+    QStringList retryableFaultCodes() const;
+    void setRetryableFaultCodes(const QStringList &codes);
+
+    bool isRetryableHttpStatus(int status) const;
+    bool isRetryableFaultCode(const QString &code) const;
+    bool isRetryableNetworkError(QNetworkReply::NetworkError error) const;
+    int delay(int attempt) const;
+
+private:
+    int m_maxAttempts;
+    int m_baseDelay;
+    int m_maxDelay;
+    QList<int> m_statuses;
+    QStringList m_faultCodes;
+};
+
+#endif // QWEBRETRYPOLICY_H
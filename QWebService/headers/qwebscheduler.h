@@ -0,0 +1,57 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef QWEBSCHEDULER_H
+#define QWEBSCHEDULER_H
+
+#include <QtCore/qurl.h>
+#include <functional>
+#include "QWebService_global.h"
+
+class QWEBSERVICESHARED_EXPORT QWebScheduler
+{
+public:
+    enum Lane { Interactive = 0, Bulk = 1 };
+
+    typedef std::function<bool ()> Dispatcher;
+
+    static void schedule(const QUrl &url, Lane lane, quint64 ticket,
+                         const Dispatcher &dispatcher, bool multiplexed = false);
+    static void release(const QUrl &url, bool multiplexed = false);
+    static bool cancel(const QUrl &url, quint64 ticket, bool multiplexed = false);
+
+    static int maxConnectionsPerHost();
+    static void setMaxConnectionsPerHost(int connections);
+    static int maxStreamsPerHost();
+    static void setMaxStreamsPerHost(int streams);
+    static int runningCount(const QUrl &url, bool multiplexed = false);
+
+    static int queueDepth(Lane lane);
+    static int maxQueueDepth(Lane lane);
+    static quint64 dispatchedCount(Lane lane);
+    static quint64 queuedCount(Lane lane);
+    static qint64 totalWaitTime(Lane lane);
+    static qint64 maxWaitTime(Lane lane);
+    static double averageWaitTime(Lane lane);
+    static void resetCounters();
+
+private:
+    QWebScheduler();
+    Q_DISABLE_COPY(QWebScheduler)
+};
+
+#endif // QWEBSCHEDULER_H
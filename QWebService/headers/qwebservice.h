@@ -22,6 +22,7 @@
 #include "QWebService_global.h"
 #include "qwebmethod.h"
 #include "qwsdl.h"
+#include "qwebbatch.h"
 
 class QWebServicePrivate;
 
@@ -55,6 +56,11 @@ public:
     void removeMethod(const QString &methodName);
     Q_INVOKABLE bool invokeMethod(const QString &methodName, const QByteArray &data = 0);
     Q_INVOKABLE QString replyRead(const QString &methodName);
+    QWebMethodCall invoke(const QString &methodName,
+                          const QMap<QString, QVariant> &params = QMap<QString, QVariant>());
+    QFuture<QWebMethodCall> invokeFuture(const QString &methodName,
+                                         const QMap<QString, QVariant> &params = QMap<QString, QVariant>());
+    QWebBatch *invokeBatch(const QList<QWebBatch::Item> &items, int maxInFlight = 6);
 
     QUrl hostUrl() const;
     QString host() const;
@@ -65,6 +71,38 @@ public:
     Q_INVOKABLE void setWsdl(QWsdl *newWsdl);
     void resetWsdl(QWsdl *newWsdl = 0);
 
+    QWebMethod::HttpTransport httpTransport() const;
+    void setHttpTransport(QWebMethod::HttpTransport transport);
+    QWebMethod::Priority priority() const;
+    void setPriority(QWebMethod::Priority priority);
+    QWebRetryPolicy retryPolicy() const;
+    void setRetryPolicy(const QWebRetryPolicy &policy);
+    int timeout() const;
+    void setTimeout(int msecs);
+    Q_INVOKABLE void cancelPendingCalls();
+
+    int cacheTtl(const QString &methodName) const;
+    void setCacheTtl(const QString &methodName, int msecs);
+    int cacheBudget() const;
+    void setCacheBudget(int bytes);
+    int cacheSize() const;
+    quint64 cacheHitCount() const;
+    quint64 cacheMissCount() const;
+    void clearCache();
+
+    bool isCoalescing() const;
+    void setCoalescing(bool coalescing);
+    quint64 coalescedCallCount() const;
+
+    bool isCompressionEnabled() const;
+    void setCompressionEnabled(bool enabled);
+    int compressionThreshold() const;
+    void setCompressionThreshold(int bytes);
+    qint64 bytesSent() const;
+    qint64 uncompressedBytesSent() const;
+    qint64 bytesReceived() const;
+    qint64 uncompressedBytesReceived() const;
+
     bool isErrorState();
     QString errorInfo() const;
 
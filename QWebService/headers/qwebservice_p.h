@@ -18,21 +18,39 @@
 #ifndef QWEBSERVICE_P_H
 #define QWEBSERVICE_P_H
 
+#include <QtCore/qcache.h>
+#include <QtCore/qelapsedtimer.h>
 #include "qwebservice.h"
 #include "qwebmethod.h"
 #include "qwsdl.h"
 
+struct QWebCacheEntry
+{
+    QByteArray reply;
+    // Time (of QWebServicePrivate::cacheClock) the entry expires at.
+    qint64 expires;
+};
+
 class QWebServicePrivate
 {
 
     Q_DECLARE_PUBLIC(QWebService)
 
 public:
-    QWebServicePrivate() {}
-    QWebServicePrivate(QWebService *q) : q_ptr(q) {}
+    QWebServicePrivate() :
+        httpTransport(QWebMethod::Http1), priority(QWebMethod::Interactive),
+        timeout(0), coalescing(false), compressionEnabled(false),
+        compressionThreshold(1024) {}
+    QWebServicePrivate(QWebService *q) :
+        q_ptr(q), httpTransport(QWebMethod::Http1), priority(QWebMethod::Interactive),
+        timeout(0), coalescing(false), compressionEnabled(false),
+        compressionThreshold(1024) {}
     QWebService *q_ptr;
 
     void init();
+    void configureMethod(QWebMethod *method);
+    QWebMethodCall invokeCached(const QString &methodName, const QByteArray &requestData);
+    void storeReply(const QString &key, const QByteArray &reply, int ttl);
     bool enterErrorState(const QString &errMessage = QString());
 
     bool errorState;
@@ -42,6 +60,19 @@ public:
     QWsdl *wsdl;
     // This is general, but should work for custom classes.
     QMap<QString, QWebMethod *> *methods;
+    QWebMethod::HttpTransport httpTransport;
+    QWebMethod::Priority priority;
+    QWebRetryPolicy retryPolicy;
+    int timeout;
+    // Result cache: TTL by method name, entries cost their size in bytes.
+    QHash<QString, int> cacheTtls;
+    QCache<QString, QWebCacheEntry> cache;
+    QElapsedTimer cacheClock;
+    quint64 cacheHits;
+    quint64 cacheMisses;
+    bool coalescing;
+    bool compressionEnabled;
+    int compressionThreshold;
 };
 
 #endif // QWEBSERVICE_P_H
@@ -53,7 +53,8 @@ public:
                                   const QMap<QString, QVariant> &params,
                                   Protocol protocol = Soap12,
                                   HttpMethod httpMethod = Post,
-                                  QObject *parent = 0);
+                                  QObject *parent = 0, int msecs = 30000,
+                                  QString *errorInfo = 0);
 
 protected:
     QWebServiceMethod(QWebServiceMethodPrivate &d,
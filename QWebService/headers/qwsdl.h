@@ -69,6 +69,7 @@ signals:
     void wsdlFileChanged();
 
 protected slots:
+    void networkReplyFinished();
     void fileReplyFinished(QNetworkReply *rply);
 
 protected:
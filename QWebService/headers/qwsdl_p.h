@@ -25,6 +25,7 @@
 #include <QtCore/qstringlist.h>
 #include <QtCore/qdatetime.h>
 #include "qwebservicemethod.h"
+#include "qwebnetworkpool.h"
 #include "qwsdl.h"
 
 class QWsdlPrivate
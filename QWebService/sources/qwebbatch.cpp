@@ -0,0 +1,293 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/qwebbatch_p.h"
+#include "../headers/qwebmethod_p.h"
+
+#include <QtCore/qeventloop.h>
+#include <QtCore/qtimer.h>
+
+/*!
+    \class QWebBatch
+    \brief Invokes many web method calls, with a limit of calls in flight.
+
+    A batch is a list of items - pairs of web method name and parameters.
+    Calls are sent over the shared network manager (see QWebNetworkPool),
+    but no more than maxInFlight() of them at a time; each finished call
+    makes room for the next one. The same web method can appear in many
+    items, with different parameters.
+
+    Results can be streamed, as calls finish (itemFinished() signal, with
+    index of the item), or read in input order once the batch is finished
+    (results()). Every item has its own QWebMethodCall, which holds its
+    error status - a failed item does not stop the batch. Items naming
+    a method which does not exist fail with an error, too.
+
+    \code
+    QList<QWebBatch::Item> items;
+    foreach (const QString &band, bands)
+        items.append(QWebBatch::Item("getBandInfo", params(band)));
+
+    QWebBatch *batch = service->invokeBatch(items, 8);
+    connect(batch, SIGNAL(finished()), this, SLOT(onBatchFinished()));
+    \endcode
+
+    Batches are usually created with QWebService::invokeBatch(). Do not
+    delete a batch in slots connected to its signals, use deleteLater().
+
+    \sa QWebService::invokeBatch()
+  */
+
+/*!
+    \fn QWebBatch::itemFinished(int index, const QWebMethodCall &call)
+
+    Signal emitted when \a call of item number \a index is finished
+    (successfully or not). Items finish in any order.
+  */
+
+/*!
+    \fn QWebBatch::finished()
+
+    Signal emitted when all items of the batch are finished.
+  */
+
+/*!
+    Constructs a batch of \a items, to be invoked using web methods
+    of \a service, with at most \a maxInFlight calls sent at the same time
+    (0 or less means no limit), and \a parent. Calls are sent after
+    start() is called.
+  */
+QWebBatch::QWebBatch(QWebService *service, const QList<Item> &items, int maxInFlight,
+                     QObject *parent) :
+    QObject(parent), d_ptr(new QWebBatchPrivate(this))
+{
+    Q_D(QWebBatch);
+    d->service = service;
+    d->items = items;
+    d->maxInFlight = (maxInFlight > 0) ? maxInFlight : items.size();
+    for (int i = 0; i < items.size(); i++)
+        d->calls.append(QWebMethodCall());
+}
+
+/*!
+    Destroys the batch. Calls in flight are not aborted, but the batch
+    does not send any more of them.
+  */
+QWebBatch::~QWebBatch()
+{
+    delete d_ptr;
+}
+
+/*!
+    Returns number of items in the batch.
+  */
+int QWebBatch::count() const
+{
+    Q_D(const QWebBatch);
+    return d->items.size();
+}
+
+/*!
+    Returns maximum number of calls sent at the same time.
+  */
+int QWebBatch::maxInFlight() const
+{
+    Q_D(const QWebBatch);
+    return d->maxInFlight;
+}
+
+/*!
+    Returns number of calls sent, which have not finished yet.
+  */
+int QWebBatch::inFlightCount() const
+{
+    Q_D(const QWebBatch);
+    return d->inFlight;
+}
+
+/*!
+    Returns number of finished items.
+  */
+int QWebBatch::finishedCount() const
+{
+    Q_D(const QWebBatch);
+    return d->finishedCount;
+}
+
+/*!
+    Returns number of items, which finished with an error.
+  */
+int QWebBatch::errorCount() const
+{
+    Q_D(const QWebBatch);
+    return d->errorCount;
+}
+
+/*!
+    Returns true if all items are finished.
+  */
+bool QWebBatch::isFinished() const
+{
+    Q_D(const QWebBatch);
+    return (d->started && (d->finishedCount == d->items.size()));
+}
+
+/*!
+    Blocks until the batch is finished, or \a msecs milliseconds have passed
+    (negative value means no timeout), in a local event loop. Starts the
+    batch, if needed. Returns true if the batch is finished.
+
+    \sa QWebMethod::invokeAndWait()
+  */
+bool QWebBatch::waitForFinished(int msecs)
+{
+    Q_D(QWebBatch);
+    if (!d->started)
+        start();
+
+    if (isFinished())
+        return true;
+
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    connect(this, SIGNAL(finished()), &loop, SLOT(quit()));
+    connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+
+    if (msecs >= 0)
+        timer.start(msecs);
+
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    return isFinished();
+}
+
+/*!
+    Returns call of item number \a index. Invalid until the item is sent.
+  */
+QWebMethodCall QWebBatch::call(int index) const
+{
+    Q_D(const QWebBatch);
+    return d->calls.value(index);
+}
+
+/*!
+    Returns calls of all items, in input order. Items which have not been
+    sent yet have invalid calls.
+
+    \sa call(), QWebMethodCall::result()
+  */
+QList<QWebMethodCall> QWebBatch::results() const
+{
+    Q_D(const QWebBatch);
+    return d->calls;
+}
+
+/*!
+    Starts sending calls. Does nothing if the batch was started already.
+    QWebService::invokeBatch() starts batches from the event loop, so that
+    signals can be connected first.
+  */
+void QWebBatch::start()
+{
+    Q_D(QWebBatch);
+    if (d->started)
+        return;
+
+    d->started = true;
+    if (d->items.isEmpty()) {
+        emit finished();
+        return;
+    }
+
+    d->startNext();
+}
+
+/*!
+    \internal
+
+    Sends next items, until the limit of calls in flight is reached.
+    Calls report back through continuations (QWebMethodCall::then()).
+  */
+void QWebBatchPrivate::startNext()
+{
+    Q_Q(QWebBatch);
+    while ((inFlight < maxInFlight) && (next < items.size())) {
+        int index = next++;
+        const QWebBatch::Item &item = items.at(index);
+        QWebMethod *method = service.isNull() ? 0 : service->method(item.first);
+        QWebMethodCall call;
+
+        if (method == 0) {
+            call = QWebMethodPrivate::failedCall(item.first,
+                                                 QLatin1String("No such web method: ")
+                                                 + item.first);
+        } else {
+            // Parameters are always set: QWebService::invoke() keeps
+            // old ones when given none, and an item without parameters
+            // would be sent with those of the previous item. Request is
+            // serialized by invoke(), so parameters can be changed for
+            // the next item right away. Cached results of the web
+            // service are used, too.
+            method->setParameters(item.second);
+            call = service->invoke(item.first);
+            if (!call.isValid())
+                call = QWebMethodPrivate::failedCall(item.first, method->errorInfo());
+        }
+
+        calls[index] = call;
+        if (call.isFinished()) {
+            reportItem(index, call);
+            continue;
+        }
+
+        ++inFlight;
+        QPointer<QWebBatch> guard(q);
+        call.then([guard, index](const QWebMethodCall &finishedCall) {
+            if (!guard.isNull())
+                guard->d_func()->callFinished(index, finishedCall);
+        });
+    }
+}
+
+/*!
+    \internal
+
+    Called when \a call of item \a index is finished.
+  */
+void QWebBatchPrivate::callFinished(int index, const QWebMethodCall &call)
+{
+    --inFlight;
+    reportItem(index, call);
+    startNext();
+}
+
+/*!
+    \internal
+
+    Counts item \a index as finished with \a call, and emits signals.
+  */
+void QWebBatchPrivate::reportItem(int index, const QWebMethodCall &call)
+{
+    Q_Q(QWebBatch);
+    ++finishedCount;
+    if (call.isErrorState())
+        ++errorCount;
+
+    emit q->itemFinished(index, call);
+    if (finishedCount == items.size())
+        emit q->finished();
+}
@@ -0,0 +1,169 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/qwebcompression_p.h"
+
+#include <zlib.h>
+
+/*!
+    \class QWebCompressor
+    \internal
+    \brief Compresses request bodies.
+  */
+
+/*!
+    Returns \a data compressed with gzip, using compression \a level
+    (from 1 to 9). Returns an empty array on failure.
+  */
+QByteArray QWebCompressor::gzip(const QByteArray &data, int level)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    // Window bits + 16 selects gzip header and trailer.
+    if (deflateInit2(&stream, level, Z_DEFLATED, MAX_WBITS + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return QByteArray();
+    }
+
+    QByteArray result;
+    result.resize(int(deflateBound(&stream, uLong(data.size()))));
+
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    stream.avail_in = uInt(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(result.data());
+    stream.avail_out = uInt(result.size());
+
+    int status = deflate(&stream, Z_FINISH);
+    result.resize(int(stream.total_out));
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END)
+        return QByteArray();
+    return result;
+}
+
+/*!
+    \class QWebDecompressor
+    \internal
+    \brief Decompresses replies, piece by piece, as they arrive.
+
+    Handles gzip and deflate content encodings. Deflate data is accepted
+    both with zlib header (as the standard says) and without it (as some
+    servers send it).
+  */
+
+/*!
+    Constructs the decompressor.
+  */
+QWebDecompressor::QWebDecompressor() :
+    stream(new z_stream), initialized(false), rawDeflate(false), error(false)
+{
+    stream->zalloc = Z_NULL;
+    stream->zfree = Z_NULL;
+    stream->opaque = Z_NULL;
+    stream->next_in = Z_NULL;
+    stream->avail_in = 0;
+}
+
+/*!
+    Destroys the decompressor.
+  */
+QWebDecompressor::~QWebDecompressor()
+{
+    if (initialized)
+        inflateEnd(stream);
+    delete stream;
+}
+
+/*!
+    Decompresses next piece of \a data, and returns all output
+    it has produced.
+
+    \sa hasError()
+  */
+QByteArray QWebDecompressor::decompress(const QByteArray &data)
+{
+    if (error)
+        return QByteArray();
+
+    QByteArray input;
+
+    if (!initialized) {
+        // Format is detected from the first two bytes.
+        firstBytes += data;
+        if (firstBytes.size() < 2)
+            return QByteArray();
+
+        uchar first = uchar(firstBytes.at(0));
+        uchar second = uchar(firstBytes.at(1));
+        bool isGzip = (first == 0x1f) && (second == 0x8b);
+        bool isZlib = ((first & 0x0f) == Z_DEFLATED) && ((first * 256 + second) % 31 == 0);
+        rawDeflate = !isGzip && !isZlib;
+
+        // Window bits + 32 detects gzip or zlib header automatically.
+        if (inflateInit2(stream, rawDeflate ? -MAX_WBITS : MAX_WBITS + 32) != Z_OK) {
+            error = true;
+            return QByteArray();
+        }
+
+        initialized = true;
+        input = firstBytes;
+        firstBytes.clear();
+    } else {
+        input = data;
+    }
+
+    QByteArray result;
+    char buffer[16 * 1024];
+
+    stream->next_in = reinterpret_cast<Bytef *>(input.data());
+    stream->avail_in = uInt(input.size());
+
+    do {
+        stream->next_out = reinterpret_cast<Bytef *>(buffer);
+        stream->avail_out = sizeof(buffer);
+
+        int status = inflate(stream, Z_NO_FLUSH);
+        result.append(buffer, int(sizeof(buffer) - stream->avail_out));
+
+        if (status == Z_STREAM_END) {
+            // Next gzip member may follow.
+            if (stream->avail_in == 0)
+                break;
+            inflateReset(stream);
+        } else if (status == Z_BUF_ERROR) {
+            // No progress possible, more input is needed.
+            break;
+        } else if (status != Z_OK) {
+            error = true;
+            break;
+        }
+    } while ((stream->avail_in > 0) || (stream->avail_out == 0));
+
+    return result;
+}
+
+/*!
+    Returns true if compressed data is corrupted.
+  */
+bool QWebDecompressor::hasError() const
+{
+    return error;
+}
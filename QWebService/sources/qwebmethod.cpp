@@ -17,7 +17,19 @@
 
 #include "../headers/qwebmethod_p.h"
 
+#include <QtCore/qatomic.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qbuffer.h>
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qset.h>
 #include <QUrlQuery>
+#include <string.h>
+#include <limits.h>
 
 /*!
     \class QWebMethod
@@ -57,32 +69,22 @@
     When invoking a REST method, \a methodName is used as request URI,
     and \a parameters specify additioanl data to be sent in message body.
 
-    This class provides asynchronous sendMessage() only.
     If synchronous operation is needed, you can:
     \list
-        \o use QWebServiceMethod, which provides some additional,
-           useful constructors and methods, including a synchronous static
-           sendMessage() method
+        \o use invokeAndWait(), which blocks until the reply arrives
+           or timeout passes
         \o use static QWebServiceMethod::invokeMethod()
-        \o subclass QWebMethod, and add a static invokeMethod() method with
-           a "waiting loop"
-        \o wait for replyReady() signal in a "waiting loop". You can use isReplyReady()
-           for that
+        \o wait for a QWebMethodCall with QWebMethodCall::waitForFinished()
     \endlist
 
-    Here's a waiting loop snippet:
+    Synchronous calls wait in a local event loop, so no CPU time is spent
+    while waiting for the network:
     \code
     QWebMethod qsm;
     ...
-    qsm.invokeMethod();
-    forever {
-        if (qsm.isReplyReady()) {
-            return qsm.replyRead();
-        } else {
-            qApp->processEvents(); // Ensures that application remains responive
-                                   // to events (prevents freezing).
-        }
-    }
+    QWebMethodCall call = qsm.invokeAndWait(5000);
+    if (!call.isErrorState())
+        return call.replyReadRaw();
     \endcode
 
     If you want to save some time on configuration in your code, you can
@@ -183,6 +185,7 @@ QWebMethod::QWebMethod(QObject *parent, Protocol protocol, HttpMethod method) :
     QObject(parent), d_ptr(new QWebMethodPrivate)
 {
     Q_D(QWebMethod);
+    d->q_ptr = this;
     d->init();
     setProtocol(protocol);
     setHttpMethod(method);
@@ -200,6 +203,7 @@ QWebMethod::QWebMethod(const QUrl &url, Protocol protocol,
     QObject(parent), d_ptr(new QWebMethodPrivate)
 {
     Q_D(QWebMethod);
+    d->q_ptr = this;
     d->init();
     setProtocol(protocol);
     setHttpMethod(method);
@@ -216,18 +220,21 @@ QWebMethod::QWebMethod(QWebMethodPrivate &dd, Protocol protocol,
     QObject(parent), d_ptr(&dd)
 {
     Q_D(QWebMethod);
+    d->q_ptr = this;
     d->init();
     setProtocol(protocol);
     setHttpMethod(httpMethod);
 }
 
 /*!
-    Deletes internal pointers.
+    Deletes internal pointers. Unfinished calls are aborted: they are
+    in error state at once, but their futures and continuations run
+    later, from the event loop, when this web method no longer exists.
   */
 QWebMethod::~QWebMethod()
 {
     Q_D(QWebMethod);
-    delete d->manager;
+    d->releaseManager();
 }
 
 /*!
@@ -433,10 +440,9 @@ bool QWebMethod::authenticate(const QUrl &customAuthString)
 
     d->authenticationPerformed = true;
     d->authenticationReplyReceived = false;
-    connect(d->manager, SIGNAL(finished(QNetworkReply*)),
-            this, SLOT(authReplyFinished(QNetworkReply*)));
     connect(d->manager, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)),
-            this, SLOT(authenticationSlot(QNetworkReply*,QAuthenticator*)));
+            this, SLOT(authenticationSlot(QNetworkReply*,QAuthenticator*)),
+            Qt::UniqueConnection);
 
     QNetworkRequest rqst(QUrl::fromUserInput(
                              QString(QLatin1String("http://")
@@ -444,11 +450,14 @@ bool QWebMethod::authenticate(const QUrl &customAuthString)
                                      + QLatin1String("/"))));
     rqst.setHeader(QNetworkRequest::ContentTypeHeader,
                    QLatin1String("application/x-www-form-urlencoded"));
+    rqst.setOriginatingObject(this);
 
     QByteArray paramBytes = customAuthString.toString().mid(1).toLatin1();
     paramBytes.replace("/", "%2F");
 //    qDebug() << paramBytes;
-    d->manager->post(rqst, paramBytes);
+    QWebNetworkPool::registerRequest(d->manager, rqst.url());
+    d->authReply = d->manager->post(rqst, paramBytes);
+    connect(d->authReply, SIGNAL(finished()), this, SLOT(networkReplyFinished()));
     return true;
 }
 
@@ -537,6 +546,7 @@ void QWebMethod::setReturnValue(const QMap<QString, QVariant> &returnVal)
 {
     Q_D(QWebMethod);
     d->returnValue = returnVal;
+    d->parsedReplyCached = false;
 }
 
 /*!
@@ -632,6 +642,7 @@ bool QWebMethod::setProtocol(Protocol prot)
             d->protocolUsed = Soap12;
         else
             d->protocolUsed = prot;
+        d->parsedReplyCached = false;
 
         emit protocolChanged();
         return true;
@@ -639,6 +650,7 @@ bool QWebMethod::setProtocol(Protocol prot)
 //        d->enterErrorState(QLatin1String("Wrong protocol is set. You have "
 //                                            "combined exclusive flags."));
         d->protocolUsed = Soap12;
+        d->parsedReplyCached = false;
         emit protocolChanged();
         return false;
     }
@@ -765,499 +777,2977 @@ bool QWebMethod::setHttpMethod(const QString &newMethod)
 }
 
 /*!
-    Invokes the method asynchronously, assuming that all neccessary data was
-    specified earlier. Optionally, a QByteArray (\a requestData) can be
-    specified - it will override standard data encapsulation (preparation,
-    see prepareRequestData()), and send the byte array without any changes.
+    Returns true if this web method uses the network manager shared
+    by all web methods in current thread (this is the default).
 
-    If synchronous operation is needed, you can:
-    \list
-        \o use static QWebServiceMethod::invokeMethod()
-        \o subclass QWebMethod, and add a static invokeMethod() method with
-           a "waiting loop"
-        \o wait for replyReady() signal in a "waiting loop"
-    \endlist
+    \sa setNetworkManagerShared(), QWebNetworkPool
+  */
+bool QWebMethod::isNetworkManagerShared() const
+{
+    Q_D(const QWebMethod);
+    return d->sharedManager;
+}
 
-    Here's a waiting loop snippet:
-    \code
-    QWebMethod qsm;
-    ...
-    qsm.invokeMethod();
-    forever {
-        if (qsm.isReplyReady()) {
-            return qsm.replyRead();
-        } else {
-            // Ensures that application remains responive to events (prevents freezing).
-            qApp->processEvents();
-        }
-    }
-    \endcode
+/*!
+    Switches between the shared, per-thread network manager (when \a shared
+    is true) and a private one, used only by this web method. A private
+    manager has its own connections, cookies and authentication cache,
+    which is useful when web methods need to be isolated from each other.
 
-    Returns true on success.
+    Replies that are still pending on the old manager are aborted, so it is
+    best to call this before invoking the method.
 
-    \sa setParameters(), setProtocol(), setTargetNamespace()
+    \sa isNetworkManagerShared(), QWebNetworkPool
   */
-bool QWebMethod::invokeMethod(const QByteArray &requestData)
+void QWebMethod::setNetworkManagerShared(bool shared)
 {
     Q_D(QWebMethod);
-    connect(d->manager, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)),
-            this, SLOT(authenticationSlot(QNetworkReply*,QAuthenticator*)));
-
-    if ((d->authenticationPerformed == true)
-            && (d->authenticationReplyReceived == false)) {
-        forever {
-            if (d->authenticationReplyReceived) {
-                disconnect(d->manager, SIGNAL(finished(QNetworkReply*)),
-                           this, SLOT(authReplyFinished(QNetworkReply*)));
-                break;
-            } else {
-                QCoreApplication::instance()->processEvents();
-            }
-        }
-    } else if ((d->authenticationPerformed == true)
-               && (d->authenticationReplyReceived == true)) {
-        disconnect(d->manager, SIGNAL(finished(QNetworkReply*)),
-                   this, SLOT(authReplyFinished(QNetworkReply*)));
-    }
+    if (d->sharedManager == shared)
+        return;
 
-    connect(d->manager, SIGNAL(finished(QNetworkReply*)),
-            this, SLOT(replyFinished(QNetworkReply*)));
+    d->releaseManager();
+    d->sharedManager = shared;
 
-    QNetworkRequest request;
-    request.setUrl(d->m_hostUrl);
+    if (shared)
+        d->manager = QWebNetworkPool::acquire();
+    else
+        d->manager = new QNetworkAccessManager;
+}
 
-    if (d->protocolUsed & Soap) {
-        request.setHeader(QNetworkRequest::ContentTypeHeader,
-                          QVariant(QLatin1String("application/soap+xml; charset=utf-8")));
-    } else if (d->protocolUsed & Json) {
-        request.setHeader(QNetworkRequest::ContentTypeHeader,
-                          QVariant(QLatin1String("application/json; charset=utf-8")));
-    } else if (d->protocolUsed & Http) {
-        request.setHeader(QNetworkRequest::ContentTypeHeader,
-                          QVariant(QLatin1String("Content-Type: application/x-www-form-urlencoded")));
-    } else if (d->protocolUsed & Xml) {
-        request.setHeader(QNetworkRequest::ContentTypeHeader,
-                          QVariant(QLatin1String("application/xml; charset=utf-8")));
-    }
+/*!
+    Returns true if replies are parsed incrementally, while they are
+    being downloaded.
 
-    if (d->protocolUsed & Soap10)
-        request.setRawHeader(QByteArray("SOAPAction"),
-                             QByteArray(d->m_hostUrl.toString().toLatin1()));
+    \sa setIncrementalParsing(), replyItemReceived()
+  */
+bool QWebMethod::isIncrementalParsing() const
+{
+    Q_D(const QWebMethod);
+    return d->incrementalParsing;
+}
 
-    if (requestData.isNull() || requestData.isEmpty())
-        d->prepareRequestData();
-    else
-        d->data = requestData;
+/*!
+    Enables (when \a incremental is true) or disables incremental parsing
+    of replies. It is disabled by default.
 
-    // OPTIONAL - FOR TESTING:
-//    qDebug() << request.url().toString();
-//    qDebug() << QString(d->data);
-    // ENDOF: OPTIONAL - FOR TESTING
+    In incremental mode, reply data is parsed as soon as it arrives, and
+    replyItemReceived() is emitted for every item read. For XML and SOAP
+    replies, an item is an element without child elements, for JSON -
+    each value of the top-level array, or member of the top-level object.
+    The reply is not stored, so memory use does not grow with its size:
+    replyRead(), replyReadRaw() and QWebMethodCall::replyReadRaw() return
+    empty data for such calls. callFinished() and replyReady() are still
+    emitted when download is finished.
 
-    if (d->protocolUsed & Rest) {
-        if (d->httpMethodUsed == Post)
-            d->manager->post(request, d->data);
-        else if (d->httpMethodUsed == Get)
-            d->manager->get(request);
-        else if (d->httpMethodUsed == Put)
-            d->manager->put(request, d->data);
-        else if (d->httpMethodUsed == Delete)
-            d->manager->deleteResource(request);
-    } else {
-        d->manager->post(request, d->data);
-    }
+    Only calls invoked after this setting is changed are affected.
 
-    return true;
+    \sa isIncrementalParsing(), replyItemReceived()
+  */
+void QWebMethod::setIncrementalParsing(bool incremental)
+{
+    Q_D(QWebMethod);
+    if (d->incrementalParsing == incremental)
+        return;
+
+    d->incrementalParsing = incremental;
+    emit incrementalParsingChanged();
 }
 
 /*!
-    After making asynchronous call, and getting the replyReady() signal,
-    this method can be used to read the reply.
+    Returns HTTP version used by this web method.
 
-    This method returns QString with complete and exact reply from server.
-    If other data format is needed, other methods can be used:
+    \sa setHttpTransport()
+  */
+QWebMethod::HttpTransport QWebMethod::httpTransport() const
+{
+    Q_D(const QWebMethod);
+    return d->httpTransport;
+}
+
+/*!
+    Sets HTTP version used to send requests to \a transport:
     \list
-    \o for parsed reply, stored in QVariant - replyReadParsed()
-    \o for raw, unprocessed reply - replyReadRaw()
+        \o Http1 - HTTP/1.1 (default). Concurrent calls to one host use
+           separate connections (up to 6 per host).
+        \o Http2 - HTTP/2 is used if the server supports it (negotiated
+           with ALPN over TLS, or by upgrade from HTTP/1.1 for cleartext).
+        \o Http2Direct - cleartext HTTP/2 with prior knowledge (h2c),
+           without negotiation. Use it for internal services known
+           to support HTTP/2.
     \endlist
 
-    \sa replyReadParsed(), replyReadRaw()
+    With HTTP/2, concurrent calls to one host are multiplexed
+    over a single connection. Use QWebMethodCall::isHttp2Used() and
+    QWebNetworkPool::streamsPerConnection() to check if that happens.
+
+    HTTP/2 requires Qt 5.8 (Http2Direct - Qt 5.11). With older versions,
+    HTTP/1.1 is always used.
+
+    \sa httpTransport()
   */
-QString QWebMethod::replyRead()
+void QWebMethod::setHttpTransport(HttpTransport transport)
 {
     Q_D(QWebMethod);
-    // Clears reply received bool.
-    d->replyReceived = false;
-    QString replyString(d->reply);
-    replyString = d->convertReplyToUtf(replyString);
-    // OPTIONAL - FOR TESTING:
-//    qDebug() << replyString;
-    // ENDOF: OPTIONAL - FOR TESTING
-    return replyString;
+    d->httpTransport = transport;
 }
 
 /*!
-    After making asynchronous call, and getting the replyReady() signal,
-    this method can be used to read the reply.
+    Returns scheduling priority of this web method's calls.
 
-    Returns parsed data (with type specified in WSDL or by user, wrapped
-    in QVariant). Tries to parse the reply automatically, but specifying
-    reply name and type using setReturnValue() might help a lot (this is
-    relevant mostly for SOAP).
+    \sa setPriority()
+  */
+QWebMethod::Priority QWebMethod::priority() const
+{
+    Q_D(const QWebMethod);
+    return d->priority;
+}
+
+/*!
+    Sets scheduling \a priority of calls made after this point:
+    \list
+        \o Interactive - default. Calls are sent before any waiting bulk
+           calls to the same host.
+        \o Bulk - for exports, synchronisation and other background work.
+           Bulk calls never take the last free connection to a host.
+    \endlist
 
-    Web APIs usually return a lot of data
-    in one go, this method is likely to get lost in it. It expects a simple
-    reply (say, you request 2 + 2, and get SOAP-enveloped reply - it will
-    work fine then, but not necessarily if WS returns a lot of additional
-    information).
+    Calls are sent through QWebScheduler, which caps the number of calls
+    running at the same time per host, and queues the rest.
 
-    \sa replyRead(), replyReadRaw()
+    \sa QWebScheduler
   */
-QVariant QWebMethod::replyReadParsed()
+void QWebMethod::setPriority(Priority priority)
 {
     Q_D(QWebMethod);
-    // Clears reply received bool.
-    d->replyReceived = false;
-    QVariant result;
-    QByteArray replyBytes = d->reply;
-    QString replyString = d->convertReplyToUtf(replyBytes);
-
-    // It's not done properly, anyway.
-    // Should return type specified in replyValue.
-    if (d->protocolUsed & Soap || d->protocolUsed & Xml) {
-        QString tempBegin = QString(QLatin1String("<")
-                                    + d->m_methodName);
-//                                    + QLatin1String("Result>"));
-        int replyBeginIndex = replyString.indexOf(tempBegin, 0,
-                                                  Qt::CaseSensitive);
-        replyBeginIndex += tempBegin.length();
-
-        QString tempFinish = QString(QLatin1String("</")
-                                     + d->m_methodName);
-//                                     + QLatin1String("Result>"));
-        int replyFinishIndex = replyString.indexOf(tempFinish,
-                                                   replyBeginIndex,
-                                                   Qt::CaseSensitive);
-
-        if (replyBeginIndex == -1)
-            replyBytes = 0;
-        if (replyFinishIndex == -1)
-            replyFinishIndex = replyString.length();
-
-        if (d->returnValue.isEmpty()) {
-            result = (QVariant) replyString.mid(replyBeginIndex,
-                                                replyFinishIndex - replyBeginIndex);
-        } else {
-            // This attempts to prepare a complete list of replies, if enough data is
-            // specified in returnValue QMap.
-            QString replyCore = replyString.mid(replyBeginIndex,
-                                                replyFinishIndex - replyBeginIndex);
-
-            // Need to add replyCore splitting into specific return values.
-            QList<QVariant> parsedReturns;
-            QStringList returnsSplitted;
-            // This is an optimistic algorithm, it assumes that
-            // returnValue QMap is right.
-            foreach (QString s, d->returnValue.keys()) {
-                if (replyCore.contains(s)) {
-                    // Get tag beginning index.
-                    int tempIndex = replyCore.indexOf(s, 0, Qt::CaseSensitive);
-                    // Get tag ending index.
-                    int tempBeginIndex = replyCore.indexOf(">", tempIndex, Qt::CaseSensitive) + 1;
-                    // Get closing tag index.
-                    tempIndex = replyCore.indexOf("</", tempBeginIndex, Qt::CaseSensitive);
-
-                    QString value = replyCore.mid(tempBeginIndex, tempBeginIndex - tempIndex).trimmed();
-                    returnsSplitted.append(value);
-                }
-            }
-
-            int i = 0;
-            foreach (QString s, d->returnValue.keys()) {
-                QString type = d->returnValue.value(s).typeName();
-
-                if (type == QLatin1String("int")) {
-                    parsedReturns.append(QVariant(returnsSplitted.at(i).toInt()));
-                } else if (type == QLatin1String("float")) {
-                    parsedReturns.append(QVariant(returnsSplitted.at(i).toFloat()));
-                } else if (type == QLatin1String("double")) {
-                    parsedReturns.append(QVariant(returnsSplitted.at(i).toDouble()));
-                } else if (type == QLatin1String("bool")) {
-                    if (returnsSplitted.at(i).toLower() == QLatin1String("true"))
-                        parsedReturns.append(QVariant(true));
-                    else if (returnsSplitted.at(i).toLower() == QLatin1String("false"))
-                        parsedReturns.append(QVariant(true));
-                } else if (type == QLatin1String("QDateTime")) {
-                    ;
-                } else if ((type == QLatin1String("QString"))
-                           || (type == QLatin1String("QChar"))) {
-                    parsedReturns.append(QVariant(returnsSplitted.at(i)));
-                } else if (type == QLatin1String("QStringList")) {
-                    // Prepare QStringLists
-                } else {
-                    parsedReturns.append(returnsSplitted.at(i));
-                }
-
-                i++;
-            }
+    d->priority = priority;
+}
 
-            if (parsedReturns.size() > 1)
-                result = parsedReturns;
-            else
-                result = parsedReturns.first();
-        }
-    } else if (d->protocolUsed & Json) {
-        // Parse JSON if you dare. Qt5 will have JSON parser, I could implement that then.. maybe.
-        // Writing own parser right now seems pointless.
-    } else { // Fallback - return QString. Will also be used for HTTP, which is bad.
-        result = replyString;
-    }
+/*!
+    Returns true if this web method is marked as idempotent.
 
-    return replyBytes;
+    \sa setIdempotent()
+  */
+bool QWebMethod::isIdempotent() const
+{
+    Q_D(const QWebMethod);
+    return d->idempotent;
 }
 
 /*!
-    After making asynchronous call, and getting the replyReady() signal,
-    this method can be used to read the reply.
-
-    Returns the raw data acquired from server.
+    Marks this web method as \a idempotent: sending it more than once has
+    the same effect as sending it once (getters, searches, PUTs and the
+    like). Failed calls of idempotent methods are sent again, according to
+    retryPolicy(). Default is false - calls are never retried.
 
-    \sa replyRead(), replyReadParsed()
+    \sa setRetryPolicy()
   */
-QByteArray QWebMethod::replyReadRaw()
+void QWebMethod::setIdempotent(bool idempotent)
 {
     Q_D(QWebMethod);
-    // Clears reply received bool.
-    d->replyReceived = false;
-    return d->reply;
+    d->idempotent = idempotent;
 }
 
 /*!
-    Returns QString with error message in case an error occured. Otherwise,
-    returns empty string.
+    Returns the policy used to retry failed calls of this web method
+    (if it is idempotent).
 
-    \sa isErrorState()
+    \sa setRetryPolicy(), setIdempotent()
   */
-QString QWebMethod::errorInfo() const
+QWebRetryPolicy QWebMethod::retryPolicy() const
 {
     Q_D(const QWebMethod);
-    return d->errorMessage;
+    return d->retryPolicy;
 }
 
 /*!
-    Returns true if there was an error, false otherwise. Details about
-    an error can be read with getErrorInfo().
+    Sets the \a policy used to retry failed calls, made after this point.
+    Policy is used only if the web method is marked as idempotent.
+    Default policy makes up to 3 attempts.
 
-    \sa errorInfo()
+    \sa QWebRetryPolicy, setIdempotent()
   */
-bool QWebMethod::isErrorState() const
+void QWebMethod::setRetryPolicy(const QWebRetryPolicy &policy)
 {
-    Q_D(const QWebMethod);
-    return d->errorState;
+    Q_D(QWebMethod);
+    d->retryPolicy = policy;
 }
 
 /*!
-    Returns true if reply was received,
-    and is ready to be read.
+    Returns the hedging delay, in milliseconds, or 0 if hedging is disabled.
+
+    \sa setHedgingDelay()
   */
-bool QWebMethod::isReplyReady() const
+int QWebMethod::hedgingDelay() const
 {
     Q_D(const QWebMethod);
-    return d->replyReceived;
+    return d->hedgingDelay;
 }
 
 /*!
-    Protected slot, which processes
-    the reply (\a netReply) from the server.
-    Emits the replyReady() signal.
+    Enables hedged requests: if a reply has not arrived \a msecs milliseconds
+    after the request was sent, a duplicate request (hedge) is sent - to
+    the next of hedgingEndpoints(), or to the same host. Whichever reply
+    arrives first wins, and the other request is aborted. A good delay is
+    the usual (95th percentile) reply time, so that only the slowest calls
+    are hedged. 0 (default) disables hedging.
+
+    Hedging duplicates requests, so it is used only by web methods marked
+    as idempotent (see setIdempotent()), and not for streamed requests or
+    incremental parsing. Hedges go through QWebScheduler like other
+    requests, so they count against the connection limit of their host;
+    their number is capped by hedgingBudget().
+
+    \sa setHedgingBudget(), setHedgingEndpoints(), QWebMethodCall::isHedged()
   */
-void QWebMethod::replyFinished(QNetworkReply *netReply)
+void QWebMethod::setHedgingDelay(int msecs)
 {
     Q_D(QWebMethod);
-    d->reply = netReply->readAll();
-    d->replyReceived = true;
-    emit replyReady(d->reply);
-    netReply->deleteLater();
+    d->hedgingDelay = qMax(0, msecs);
 }
 
 /*!
-    TEMP Auth METHOD. HIGHLY EXPERIMENTAL.
-    Checks for body of \a reply to determine correctness of authentication.
+    Returns maximum number of hedges, in percents of calls.
+
+    \sa setHedgingBudget()
   */
-void QWebMethod::authReplyFinished(QNetworkReply *reply)
+int QWebMethod::hedgingBudget() const
 {
-    Q_D(QWebMethod);
-    d->authenticationReplyReceived = true;
-    QByteArray array = reply->readAll();
-    if (!array.isEmpty())
-    {
-        d->enterErrorState(QLatin1String("Login incorrect."));
-    }
-//    else        qDebug() << "Login correct";
-    reply->deleteLater();
+    Q_D(const QWebMethod);
+    return d->hedgingBudget;
 }
 
 /*!
-    Internal method used to authenticate the communication.
-    Use setCredentials() or setUsername() and setPassword()
-    to specify the data.
+    Limits the number of hedges to \a percent of calls (counted since
+    hedging was enabled), so that a slow server does not get even more
+    load. Late calls above the budget are not hedged. Default is 10.
 
-    This is a fallback method of QNAM. Typically, authenticate()
-    should be used.
-
-    Fills the \a authenticator object. Does not use \a reply.
+    \sa setHedgingDelay(), hedgedCallCount()
   */
-void QWebMethod::authenticationSlot(QNetworkReply *reply,
-                                    QAuthenticator *authenticator)
+void QWebMethod::setHedgingBudget(int percent)
 {
     Q_D(QWebMethod);
-    if (d->authenticationError)
-    {
-        d->enterErrorState(QString(QLatin1String("Authentication error! ")
-                                   + reply->readAll()));
-        return;
-    }
-
-    authenticator->setUser(d->m_username);
-    authenticator->setPassword(d->m_password);
-    d->authenticationError = true;
-    reply->deleteLater();
+    d->hedgingBudget = qBound(0, percent, 100);
 }
 
 /*!
-    Performs genral initialisation of the object.
-    Sets default variable values, initializes network manager,
-    connects reply signals. Calls virtual method, configure().
+    Returns endpoints that hedges are sent to.
+
+    \sa setHedgingEndpoints()
   */
-void QWebMethodPrivate::init()
+QList<QUrl> QWebMethod::hedgingEndpoints() const
 {
-    replyReceived = false;
-    authenticationReplyReceived = false;
-    errorState = false;
-    authenticationError = false;
-    authenticationPerformed = false;
+    Q_D(const QWebMethod);
+    return d->hedgingEndpoints;
+}
+
+/*!
+    Sets \a endpoints (replicas of the web service), that hedges are sent
+    to, in turns. Only scheme, host and port of each endpoint are used, path
+    and query are the same as in the original request. With no endpoints
+    (default), hedges go to the same host as the original request.
 
-    manager = new QNetworkAccessManager;
+    \sa setHedgingDelay()
+  */
+void QWebMethod::setHedgingEndpoints(const QList<QUrl> &endpoints)
+{
+    Q_D(QWebMethod);
+    d->hedgingEndpoints = endpoints;
+    d->nextHedgingEndpoint = 0;
 }
 
 /*!
-    Private function, invoked by invokeMethod(). Modifies QByteArray data,
-    so that it is consistent with protocol and HTTP method specification.
-    It uses QMap<QString, QVariant> parameters to fill data object's body.
-    Can be overriden by creating custom QByteArray and passing it to
-    sendMessage().
+    Returns number of calls, for which a hedge was sent.
 
-    \sa invokeMethod()
+    \sa hedgeWinCount(), setHedgingDelay()
   */
-void QWebMethodPrivate::prepareRequestData()
+quint64 QWebMethod::hedgedCallCount() const
 {
-    data.clear();
-    QString header, body, footer;
-    // Replace with something OS-independent, or seriously rethink.
-    QString endl = QLatin1String("\r\n");
+    Q_D(const QWebMethod);
+    return d->hedgedCallCount;
+}
 
-    if (protocolUsed & QWebMethod::Soap) {
-        if (protocolUsed & QWebMethod::Soap12) {
-            header = QString(QLatin1String("<?xml version=\"1.0\" encoding=\"utf-8\"?> ")
-                     + endl + QLatin1String(" <soap12:Envelope "
-                     "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
-                     "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" "
-                     "xmlns:soap12=\"http://www.w3.org/2003/05/soap-envelope\"> ") + endl +
-                     QLatin1String(" <soap12:Body> ") + endl);
-
-            footer = QString(QLatin1String("</soap12:Body> ")
-                             + endl
-                             + QLatin1String("</soap12:Envelope>"));
-        } else if (protocolUsed & QWebMethod::Soap10) {
-            header = QString(QLatin1String("<?xml version=\"1.0\" encoding=\"utf-8\"?> ")
-                     + endl + QLatin1String(" <soap:Envelope "
-                     "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
-                     "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" "
-                     "xmlns:soap=\"http://www.w3.org/2003/05/soap-envelope\"> ") + endl +
-                     QLatin1String(" <soap:Body> ") + endl);
-
-            footer = QString(QLatin1String("</soap:Body> ")
-                             + endl
-                             + QLatin1String("</soap:Envelope>"));
-        }
+/*!
+    Returns number of hedged calls, which were finished with the reply
+    of the hedge: it replied first, or the original request failed.
 
-        body = QString(QLatin1String("\t<") + m_methodName
-                       + QLatin1String(" xmlns=\"")
-                       + m_targetNamespace
-                       + QLatin1String("\"> ") + endl);
-
-        foreach (const QString currentKey, parameters.keys()) {
-            QVariant qv = parameters.value(currentKey);
-            // Currently, this does not handle nested lists
-            body += QString(QLatin1String("\t\t<") + currentKey
-                            + QLatin1String(">")
-                            + qv.toString()
-                            + QLatin1String("</") + currentKey
-                            + QLatin1String("> ") + endl);
-        }
+    \sa hedgedCallCount(), setHedgingDelay()
+  */
+quint64 QWebMethod::hedgeWinCount() const
+{
+    Q_D(const QWebMethod);
+    return d->hedgeWinCount;
+}
 
-        body += QString(QLatin1String("\t</")
-                        + m_methodName
-                        + QLatin1String("> ") + endl);
-    } else if (protocolUsed & QWebMethod::Http) {
-        foreach (const QString currentKey, parameters.keys()) {
-            QVariant qv = parameters.value(currentKey);
-            // Currently, this does not handle nested lists
-            body += QString(currentKey + QLatin1String("=")
-                            + qv.toString() + QLatin1String("&"));
-        }
-        body.chop(1);
-    } else if (protocolUsed & QWebMethod::Json) {
-        body += QString(QLatin1String("{") + endl);
-        foreach (const QString currentKey, parameters.keys()) {
-            QVariant qv = parameters.value(currentKey);
-            // Currently, this does not handle nested lists
-            body += QString(QLatin1String("{") + endl
-                            + QLatin1String("\t\"") + currentKey
-                            + QLatin1String("\" : \"")
-                            + qv.toString()
-                            + QLatin1String("\"") + endl);
-        }
-        body += QLatin1String("}");
-    } else if (protocolUsed & QWebMethod::Xml) {
-        foreach (const QString currentKey, parameters.keys()) {
-            QVariant qv = parameters.value(currentKey);
-            // Currently, this does not handle nested lists
-            body += QString(QLatin1String("\t\t<") + currentKey
-                            + QLatin1String(">") + qv.toString()
-                            + QLatin1String("</") + currentKey
-                            + QLatin1String("> ") + endl);
-        }
-    }
+/*!
+    Returns true if identical calls of this web method are coalesced.
 
-    data.append(QString(header + body + footer).toLatin1());
+    \sa setCoalescing()
+  */
+bool QWebMethod::isCoalescing() const
+{
+    Q_D(const QWebMethod);
+    return d->coalescing;
 }
 
 /*!
-    \internal
+    Enables (when \a coalescing is true) coalescing of identical calls:
+    while a request with the same HTTP method, host and body is in flight,
+    invoke() does not send another one - the new call waits for the reply
+    of the request already sent. When it arrives, every waiting call
+    is finished with it (the reply data is shared, not copied), and
+    callFinished() is emitted for each of them. replyReady() is emitted
+    once per request. Default is false.
+
+    Meant for methods which read data, and get invoked by many views
+    at once. Canceling one of the waiting calls does not affect the others;
+    the request is aborted only when no call waits for it any more.
+    Streamed requests and incremental parsing are not coalesced.
+
+    \sa coalescedCallCount()
+  */
+void QWebMethod::setCoalescing(bool coalescing)
+{
+    Q_D(QWebMethod);
+    d->coalescing = coalescing;
+}
 
-    Changes the encoding of the reply, in a rather crude fashion.
+/*!
+    Returns number of calls, which waited for a request sent by an
+    identical call, instead of sending their own.
+
+    \sa setCoalescing()
   */
-QString QWebMethodPrivate::convertReplyToUtf(const QString &textToConvert)
+quint64 QWebMethod::coalescedCallCount() const
 {
-    QString result = textToConvert;
+    Q_D(const QWebMethod);
+    return d->coalescedCallCount;
+}
 
-    result.replace(QLatin1String("&lt;"), QLatin1String("<"));
-    result.replace(QLatin1String("&gt;"), QLatin1String(">"));
+/*!
+    Returns default timeout of calls, in milliseconds, or 0 if calls
+    do not time out.
 
-    return result;
+    \sa setTimeout()
+  */
+int QWebMethod::timeout() const
+{
+    Q_D(const QWebMethod);
+    return d->timeout;
 }
 
 /*!
-    \internal
+    Sets default timeout of calls made after this point to \a msecs
+    milliseconds, counted from invocation (time spent waiting in
+    QWebScheduler's queue and retries included). Calls which are not
+    finished in time are aborted, and end in error state with
+    "Request timed out." message. 0 (default) disables the timeout.
 
-    Enters into error state with message \a errMessage.
+    Use QWebMethodCall::setDeadline() to give a single call a different
+    (absolute) deadline.
+
+    \sa QWebMethodCall::cancel()
   */
-bool QWebMethodPrivate::enterErrorState(const QString &errMessage)
+void QWebMethod::setTimeout(int msecs)
 {
-    Q_Q(QWebMethod);
-    errorState = true;
-    errorMessage += QString(errMessage + QLatin1String(" "));
-    emit q->errorEncountered(errMessage);
+    Q_D(QWebMethod);
+    msecs = qMax(0, msecs);
+    if (d->timeout == msecs)
+        return;
+
+    d->timeout = msecs;
+    emit timeoutChanged();
+}
+
+/*!
+    Returns true if request and reply compression is enabled.
+
+    \sa setCompressionEnabled()
+  */
+bool QWebMethod::isCompressionEnabled() const
+{
+    Q_D(const QWebMethod);
+    return d->compressionEnabled;
+}
+
+/*!
+    Enables (when \a enabled is true) or disables compression. It is
+    disabled by default.
+
+    With compression enabled, request bodies of at least
+    compressionThreshold() bytes are sent gzipped (with "Content-Encoding:
+    gzip" header), and the server is told that gzip and deflate replies
+    are accepted. Compressed replies are decompressed while they arrive.
+    Bodies streamed from a QIODevice are never compressed.
+
+    SOAP envelopes are very repetitive, and compress well, but the server
+    has to support compressed requests.
+
+    \sa setCompressionThreshold(), bytesSent(), bytesReceived()
+  */
+void QWebMethod::setCompressionEnabled(bool enabled)
+{
+    Q_D(QWebMethod);
+    d->compressionEnabled = enabled;
+}
+
+/*!
+    Returns the size (in bytes) from which request bodies are compressed.
+    Default is 1024.
+
+    \sa setCompressionThreshold()
+  */
+int QWebMethod::compressionThreshold() const
+{
+    Q_D(const QWebMethod);
+    return d->compressionThreshold;
+}
+
+/*!
+    Sets the size of request body (in \a bytes), from which it is
+    compressed. Smaller bodies are sent as they are.
+
+    \sa setCompressionEnabled()
+  */
+void QWebMethod::setCompressionThreshold(int bytes)
+{
+    Q_D(QWebMethod);
+    d->compressionThreshold = bytes;
+}
+
+/*!
+    Returns number of request body bytes sent, as they were sent
+    (compressed, if compression was used).
+
+    \sa uncompressedBytesSent(), resetByteCounters()
+  */
+qint64 QWebMethod::bytesSent() const
+{
+    Q_D(const QWebMethod);
+    return d->bytesSent;
+}
+
+/*!
+    Returns number of request body bytes sent, before compression.
+
+    \sa bytesSent(), resetByteCounters()
+  */
+qint64 QWebMethod::uncompressedBytesSent() const
+{
+    Q_D(const QWebMethod);
+    return d->uncompressedBytesSent;
+}
+
+/*!
+    Returns number of reply body bytes received, as they were received
+    (compressed, if the server compressed them). Replies that are
+    decompressed by QNetworkAccessManager itself (when compression
+    is disabled) are counted after decompression.
+
+    \sa uncompressedBytesReceived(), resetByteCounters()
+  */
+qint64 QWebMethod::bytesReceived() const
+{
+    Q_D(const QWebMethod);
+    return d->bytesReceived;
+}
+
+/*!
+    Returns number of reply body bytes received, after decompression.
+
+    \sa bytesReceived(), resetByteCounters()
+  */
+qint64 QWebMethod::uncompressedBytesReceived() const
+{
+    Q_D(const QWebMethod);
+    return d->uncompressedBytesReceived;
+}
+
+/*!
+    Zeroes the byte counters.
+
+    \sa bytesSent(), bytesReceived()
+  */
+void QWebMethod::resetByteCounters()
+{
+    Q_D(QWebMethod);
+    d->bytesSent = 0;
+    d->uncompressedBytesSent = 0;
+    d->bytesReceived = 0;
+    d->uncompressedBytesReceived = 0;
+}
+
+/*!
+    Invokes the method asynchronously, assuming that all neccessary data was
+    specified earlier. Optionally, a QByteArray (\a requestData) can be
+    specified - it will override standard data encapsulation (preparation,
+    see prepareRequestData()), and send the byte array without any changes.
+
+    If synchronous operation is needed, use invokeAndWait().
+
+    Returns true on success.
+
+    \sa setParameters(), setProtocol(), setTargetNamespace()
+  */
+bool QWebMethod::invokeMethod(const QByteArray &requestData)
+{
+    return invoke(requestData).isValid();
+}
+
+/*!
+    Invokes the method asynchronously, like invokeMethod() (passing
+    \a requestData), and ties the call to \a owner: if \a owner is
+    destroyed before the call is finished, the call is canceled.
+    Returns true on success.
+
+    Meant for QML components using a shared web method - their calls
+    are canceled when the component goes away:
+    \code
+    Item {
+        id: page
+        Component.onCompleted: webMethod.invokeMethodFor(page)
+    }
+    \endcode
+
+    \sa QWebMethodCall::cancelWith(), cancelPendingCalls()
+  */
+bool QWebMethod::invokeMethodFor(QObject *owner, const QByteArray &requestData)
+{
+    return invoke(requestData).cancelWith(owner).isValid();
+}
+
+/*!
+    Invokes the method synchronously: sends the request (\a requestData, if
+    not empty, overrides standard data encapsulation) and blocks until
+    the reply arrives, or \a msecs milliseconds pass (negative value means
+    no timeout). Returns handle of the finished call. Calls which timed out
+    are aborted, and end in error state with "Request timed out." message.
+    Calls which could not be sent end in error state, too.
+
+    Waiting is done in a local event loop, not in a loop calling
+    processEvents(): the thread sleeps until network data arrives. Events
+    of the thread (except user input) are still delivered, so signals of
+    other objects (including callFinished() of this method) are emitted
+    while waiting. Needs to be called from the thread the method lives in,
+    which does not have to be the GUI thread.
+
+    \sa invoke(), QWebMethodCall::waitForFinished()
+  */
+QWebMethodCall QWebMethod::invokeAndWait(int msecs, const QByteArray &requestData)
+{
+    Q_D(QWebMethod);
+    QWebMethodCall call = invoke(requestData);
+    if (call.isValid() && !call.waitForFinished(msecs))
+        d->abortCall(call, true);
+
+    return call;
+}
+
+/*!
+    Invokes the method asynchronously, like invoke(), and returns a QFuture,
+    which gets the finished call (with its reply decoded into
+    QWebMethodCall::result()) as result. Optionally, a QByteArray
+    (\a requestData) can be specified - it will override standard data
+    encapsulation.
+
+    Many calls can be collected this way without a slot (or any other
+    QObject) per call. Futures can be consumed from other threads, and
+    composed with QtConcurrent. Do not block the thread of the web method
+    on the future, reply is delivered by its event loop.
+
+    \sa QWebMethodCall::future(), QWebMethodCall::then()
+  */
+QFuture<QWebMethodCall> QWebMethod::invokeFuture(const QByteArray &requestData)
+{
+    return invoke(requestData).future();
+}
+
+/*!
+    Invokes the method asynchronously, just like invokeMethod(), and returns
+    a handle of the call. Optionally, a QByteArray (\a requestData) can be
+    specified - it will override standard data encapsulation.
+
+    Every call gets its own QNetworkReply, so invoke() can be called again
+    before previous reply arrives - many calls of the same web method can be
+    in flight at the same time. When a call is finished, callFinished() is
+    emitted with the same handle (and replyReady(), for compatibility).
+
+    The returned handle is always valid. If the request cannot be sent,
+    the call finishes with an error (see QWebMethodCall::isErrorState()).
+
+    \sa callFinished(), pendingCallCount(), QWebMethodCall, setCoalescing()
+  */
+QWebMethodCall QWebMethod::invoke(const QByteArray &requestData)
+{
+    Q_D(QWebMethod);
+    d->waitForAuthentication();
+
+    if (d->coalescing && !d->incrementalParsing)
+        return d->joinFlight(requestData);
+
+    QWebMethodCall call = d->createCall(requestData);
+    d->sendCall(call);
+    return call;
+}
+
+/*!
+    \overload invoke()
+
+    Invokes the method asynchronously, streaming request body from
+    \a requestBody, which has to be open for reading, and stay alive until
+    the call is finished. Data is sent without any changes (no envelope
+    is added). Use this for request bodies too big to keep in memory.
+
+    Random access devices (like QFile) are read in pieces, as they are
+    being sent. Sequential devices are buffered by QNetworkAccessManager,
+    unless their \a size is specified.
+
+    Returns an invalid handle if \a requestBody is not readable.
+    Otherwise, errors of sending finish the call, like in invoke().
+  */
+QWebMethodCall QWebMethod::invoke(QIODevice *requestBody, qint64 size)
+{
+    Q_D(QWebMethod);
+    if (requestBody == 0 || !requestBody->isReadable()) {
+        d->enterErrorState(QLatin1String("Request body device is not readable."));
+        return QWebMethodCall();
+    }
+
+    d->waitForAuthentication();
+
+    QWebMethodCall call = d->createCall(QByteArray(), requestBody, size);
+    d->sendCall(call);
+    return call;
+}
+
+/*!
+    \overload invoke()
+
+    Invokes the method asynchronously, with request body produced by
+    \a generator. Generator is called each time more data can be sent,
+    and returns the next piece of body, or an empty QByteArray
+    when there is no more data. Only one piece is kept in memory at a time,
+    provided that total \a size of the body is known - otherwise,
+    QNetworkAccessManager has to buffer the whole body to compute it.
+
+    Errors of sending finish the call, like in invoke().
+  */
+QWebMethodCall QWebMethod::invoke(const RequestGenerator &generator, qint64 size)
+{
+    Q_D(QWebMethod);
+    d->waitForAuthentication();
+
+    QWebRequestGeneratorDevice *device = new QWebRequestGeneratorDevice(generator);
+    device->open(QIODevice::ReadOnly);
+
+    // Generator device is owned by the call, until it is sent - then
+    // by the reply, and deleted with it.
+    QWebMethodCall call = d->createCall(QByteArray(), device, size);
+    call.d->ownsRequestDevice = true;
+    d->sendCall(call);
+    return call;
+}
+
+/*!
+    Returns number of calls that were invoked, but have not received
+    a reply yet (including calls waiting in QWebScheduler's queue).
+
+    \sa invoke()
+  */
+int QWebMethod::pendingCallCount() const
+{
+    Q_D(const QWebMethod);
+    return d->waitingCalls().size();
+}
+
+/*!
+    Cancels all calls of this web method, which are not finished yet
+    (waiting in QWebScheduler's queue, or for a reply). Each of them is
+    finished in error state, and callFinished() is emitted.
+
+    \sa QWebMethodCall::cancel(), pendingCallCount()
+  */
+void QWebMethod::cancelPendingCalls()
+{
+    Q_D(QWebMethod);
+    QPointer<QWebMethod> guard(this);
+    foreach (const QWebMethodCall &call, d->waitingCalls()) {
+        d->cancelCall(call);
+        if (guard.isNull())
+            return;
+    }
+}
+
+/*!
+    After making asynchronous call, and getting the replyReady() signal,
+    this method can be used to read the reply.
+
+    This method returns QString with complete and exact reply from server.
+    If other data format is needed, other methods can be used:
+    \list
+    \o for parsed reply, stored in QVariant - replyReadParsed()
+    \o for raw, unprocessed reply - replyReadRaw()
+    \endlist
+
+    \sa replyReadParsed(), replyReadRaw()
+  */
+QString QWebMethod::replyRead()
+{
+    Q_D(QWebMethod);
+    // Clears reply received bool.
+    d->replyReceived = false;
+    QString replyString(d->reply);
+    replyString = d->convertReplyToUtf(replyString);
+    // OPTIONAL - FOR TESTING:
+//    qDebug() << replyString;
+    // ENDOF: OPTIONAL - FOR TESTING
+    return replyString;
+}
+
+/*!
+    After making asynchronous call, and getting the replyReady() signal,
+    this method can be used to read the reply.
+
+    Returns parsed data (with type specified in WSDL or by user, wrapped
+    in QVariant). For SOAP and XML, the reply is decoded in a single pass
+    against the return value names and types (see setReturnValue()).
+    Values are converted to int, double, float, bool, QDateTime, QChar,
+    QString, QStringList or QVariantList (arrays), complex elements become
+    a QVariantMap. If the response has a single value, it is returned
+    directly, otherwise a QVariantMap of all values, by their names.
+    Elements not present in return value map are decoded as strings
+    (or maps, if they have child elements).
+
+    JSON replies are converted from replyReadJson(), objects become
+    QVariantMap, arrays - QVariantList.
+
+    Result is cached, so repeated calls do not parse the reply again.
+
+    \sa replyRead(), replyReadRaw(), setReturnValue()
+  */
+QVariant QWebMethod::replyReadParsed()
+{
+    Q_D(QWebMethod);
+    // Clears reply received bool.
+    d->replyReceived = false;
+
+    if (d->parsedReplyCached)
+        return d->parsedReply;
+
+    QVariant result;
+
+    if ((d->protocolUsed & Soap) || (d->protocolUsed & Xml)) {
+        QString error;
+        result = QWebMethodPrivate::decodeXmlReply(d->reply, d->returnValue, &error);
+        if (!error.isEmpty())
+            d->enterErrorState(error);
+    } else if (d->protocolUsed & Json) {
+        result = replyReadJson().toVariant();
+    } else { // Fallback - return QString. Will also be used for HTTP, which is bad.
+        result = QString::fromUtf8(d->reply);
+    }
+
+    d->parsedReply = result;
+    d->parsedReplyCached = true;
+    return result;
+}
+
+/*!
+    After making asynchronous call, and getting the replyReady() signal,
+    this method can be used to read a JSON reply.
+
+    Reply is parsed on first access, and the document is reused
+    by all following calls (and by replyValue() and replyReadParsed()).
+    Returns an empty document, and enters error state, if the reply is
+    not a valid JSON.
+
+    \sa replyValue(), replyReadParsed()
+  */
+QJsonDocument QWebMethod::replyReadJson()
+{
+    Q_D(QWebMethod);
+    // Clears reply received bool.
+    d->replyReceived = false;
+
+    if (!d->jsonReplyCached) {
+        QJsonParseError parseError;
+        d->jsonReply = QJsonDocument::fromJson(d->reply, &parseError);
+        d->jsonReplyCached = true;
+
+        if (parseError.error != QJsonParseError::NoError) {
+            d->enterErrorState(QLatin1String("Reply could not be parsed: ")
+                               + parseError.errorString());
+        }
+    }
+
+    return d->jsonReply;
+}
+
+/*!
+    Returns the value of a JSON reply, pointed to by \a jsonPointer
+    (RFC 6901, for example "/bands/0/name"; empty pointer means the whole
+    document). Returns an invalid QVariant if there is no such value.
+
+    If the reply has not been parsed yet, the document is not parsed
+    as a whole: it is scanned up to the value, and only the value is
+    converted. This is cheap for picking a small part of a big reply.
+    If the document has already been parsed (see replyReadJson()),
+    it is used instead. In both cases, of duplicated keys the last one
+    is used. If the value cannot be parsed, an invalid QVariant is
+    returned, and the method enters error state, as in replyReadJson().
+
+    \code
+    QString name = method->replyValue("/bands/0/name").toString();
+    \endcode
+
+    \sa replyReadJson()
+  */
+QVariant QWebMethod::replyValue(const QString &jsonPointer)
+{
+    Q_D(QWebMethod);
+    // Clears reply received bool.
+    d->replyReceived = false;
+
+    if (!d->jsonReplyCached) {
+        QByteArray slice = QWebReplyParser::jsonPointerSlice(d->reply, jsonPointer);
+        if (slice.isEmpty())
+            return QVariant();
+
+        QJsonParseError parseError;
+        QJsonArray array = QJsonDocument::fromJson('[' + slice + ']', &parseError).array();
+        if ((parseError.error != QJsonParseError::NoError) || array.isEmpty()) {
+            d->enterErrorState(QLatin1String("Reply could not be parsed: ")
+                               + parseError.errorString());
+            return QVariant();
+        }
+
+        return array.first().toVariant();
+    }
+
+    bool valid = false;
+    const QStringList tokens = QWebReplyParser::jsonPointerTokens(jsonPointer, &valid);
+    if (!valid)
+        return QVariant();
+
+    QJsonValue value = d->jsonReply.isArray() ?
+                QJsonValue(d->jsonReply.array()) : QJsonValue(d->jsonReply.object());
+
+    foreach (const QString &token, tokens) {
+        if (value.isObject()) {
+            QJsonObject object = value.toObject();
+            if (!object.contains(token))
+                return QVariant();
+            value = object.value(token);
+        } else if (value.isArray()) {
+            bool isIndex = false;
+            int index = token.toInt(&isIndex);
+            QJsonArray array = value.toArray();
+            if (!isIndex || (index < 0) || (index >= array.size()))
+                return QVariant();
+            value = array.at(index);
+        } else {
+            return QVariant();
+        }
+    }
+
+    return value.toVariant();
+}
+
+/*!
+    After making asynchronous call, and getting the replyReady() signal,
+    this method can be used to read the reply.
+
+    Returns the raw data acquired from server.
+
+    \sa replyRead(), replyReadParsed()
+  */
+QByteArray QWebMethod::replyReadRaw()
+{
+    Q_D(QWebMethod);
+    // Clears reply received bool.
+    d->replyReceived = false;
+    return d->reply;
+}
+
+/*!
+    Returns QString with error message in case an error occured. Otherwise,
+    returns empty string.
+
+    \sa isErrorState()
+  */
+QString QWebMethod::errorInfo() const
+{
+    Q_D(const QWebMethod);
+    return d->errorMessage;
+}
+
+/*!
+    Returns true if there was an error, false otherwise. Details about
+    an error can be read with getErrorInfo().
+
+    \sa errorInfo()
+  */
+bool QWebMethod::isErrorState() const
+{
+    Q_D(const QWebMethod);
+    return d->errorState;
+}
+
+/*!
+    Returns true if reply was received,
+    and is ready to be read.
+  */
+bool QWebMethod::isReplyReady() const
+{
+    Q_D(const QWebMethod);
+    return d->replyReceived;
+}
+
+/*!
+    Protected slot, connected to QNetworkReply::finished() of every request
+    sent by this web method. Passes the reply to replyFinished()
+    or authReplyFinished().
+  */
+void QWebMethod::networkReplyFinished()
+{
+    Q_D(QWebMethod);
+    QNetworkReply *netReply = qobject_cast<QNetworkReply *>(sender());
+    if (netReply == 0)
+        return;
+
+    if (netReply == d->authReply) {
+        d->authReply = 0;
+        authReplyFinished(netReply);
+    } else if (d->pendingCalls.contains(netReply)) {
+        replyFinished(netReply);
+    }
+}
+
+/*!
+    Protected slot, connected to QNetworkReply::readyRead() of every
+    request. Notes arrival of the first byte of the reply. Calls parsed
+    incrementally, or with compressed replies, read new data as soon
+    as it arrives; for other calls, the slot is disconnected after
+    the first byte.
+
+    \sa setIncrementalParsing(), setCompressionEnabled(), QWebCallTiming
+  */
+void QWebMethod::networkReplyReadyRead()
+{
+    Q_D(QWebMethod);
+    QNetworkReply *netReply = qobject_cast<QNetworkReply *>(sender());
+    if (netReply == 0)
+        return;
+
+    QWebMethodCall call = d->pendingCalls.value(netReply);
+    if (!call.isValid())
+        return;
+
+    if (call.d->timing.firstByte < 0)
+        call.d->timing.firstByte = call.d->clock.nsecsElapsed() / 1000;
+
+    if ((call.d->parser != 0) || call.d->acceptsCompressedReply) {
+        d->readReplyData(call, netReply);
+    } else {
+        disconnect(netReply, SIGNAL(readyRead()), this, SLOT(networkReplyReadyRead()));
+    }
+}
+
+/*!
+    Protected slot, connected to QNetworkReply::metaDataChanged() of every
+    request. Notes arrival of reply headers.
+
+    \sa QWebCallTiming
+  */
+void QWebMethod::networkReplyMetaDataChanged()
+{
+    Q_D(QWebMethod);
+    QNetworkReply *netReply = qobject_cast<QNetworkReply *>(sender());
+    if (netReply == 0)
+        return;
+
+    QWebMethodCall call = d->pendingCalls.value(netReply);
+    if (call.isValid() && (call.d->timing.headersReceived < 0))
+        call.d->timing.headersReceived = call.d->clock.nsecsElapsed() / 1000;
+}
+
+/*!
+    Protected slot, connected to QNetworkReply::encrypted() of every
+    request. Notes the end of TLS handshake.
+
+    \sa QWebCallTiming
+  */
+void QWebMethod::networkReplyEncrypted()
+{
+    Q_D(QWebMethod);
+    QNetworkReply *netReply = qobject_cast<QNetworkReply *>(sender());
+    if (netReply == 0)
+        return;
+
+    QWebMethodCall call = d->pendingCalls.value(netReply);
+    if (call.isValid() && (call.d->timing.encrypted < 0))
+        call.d->timing.encrypted = call.d->clock.nsecsElapsed() / 1000;
+}
+
+/*!
+    \fn QWebMethod::replyItemReceived(const QWebMethodCall &call, const QString &name, const QVariant &value)
+
+    Signal emitted in incremental parsing mode, each time an item of
+    \a call's reply has been read. \a name and \a value hold the item's
+    name (empty for items of a JSON array) and value.
+
+    \sa setIncrementalParsing()
+  */
+
+/*!
+    \fn QWebMethod::callFinished(const QWebMethodCall &call)
+
+    Signal emitted when a reply for \a call has been received,
+    or the call has failed.
+
+    \sa invoke()
+  */
+
+/*!
+    Protected slot, which processes
+    the reply (\a netReply) from the server.
+    Emits the callFinished() and replyReady() signals.
+  */
+void QWebMethod::replyFinished(QNetworkReply *netReply)
+{
+    Q_D(QWebMethod);
+    QWebMethodCall call = d->pendingCalls.take(netReply);
+    if (!call.isValid())
+        return;
+
+    if (d->settleHedge(call, netReply)) {
+        netReply->deleteLater();
+        return;
+    }
+
+    d->finishCall(call, netReply);
+    netReply->deleteLater();
+
+    if (call.d->scheduled) {
+        call.d->scheduled = false;
+        QWebScheduler::release(call.d->request.url(), call.d->multiplexed);
+    }
+
+    if (d->retryCall(call, netReply))
+        return;
+
+    d->recordMetrics(call);
+    d->clearCallDeadline(call);
+    if (call.d->flight) {
+        d->finishFlight(call, true);
+        return;
+    }
+
+    d->reply = call.d->reply;
+    d->replyReceived = true;
+    d->parsedReplyCached = false;
+    d->jsonReplyCached = false;
+
+    // Slots might delete this web method - completion uses call data only.
+    QPointer<QWebMethod> guard(this);
+    emit callFinished(call);
+    if (!guard.isNull())
+        emit replyReady(d->reply);
+    call.d->complete(call);
+}
+
+/*!
+    Protected slot, which aborts calls whose deadline has passed.
+    They finish in error state, with "Request timed out." message.
+
+    \sa setTimeout(), QWebMethodCall::setDeadline()
+  */
+void QWebMethod::deadlineTimeout()
+{
+    Q_D(QWebMethod);
+    QPointer<QWebMethod> guard(this);
+    qint64 now = d->deadlineClock.elapsed();
+
+    while (!d->deadlines.isEmpty() && (d->deadlines.firstKey() <= now)) {
+        QMultiMap<qint64, QWebMethodCall>::iterator first = d->deadlines.begin();
+        QWebMethodCall call = first.value();
+        d->deadlines.erase(first);
+        call.d->deadline = -1;
+
+        // Slots connected to callFinished() might delete this web method.
+        d->abortCall(call, true);
+        if (guard.isNull())
+            return;
+    }
+
+    d->startDeadlineTimer();
+}
+
+/*!
+    Protected slot, which cancels unfinished calls tied to \a owner,
+    when it is destroyed.
+
+    \sa invokeMethodFor(), QWebMethodCall::cancelWith()
+  */
+void QWebMethod::callOwnerDestroyed(QObject *owner)
+{
+    Q_D(QWebMethod);
+    QPointer<QWebMethod> guard(this);
+    foreach (const QWebMethodCall &call, d->waitingCalls()) {
+        if (call.d->owner != owner)
+            continue;
+
+        d->cancelCall(call);
+        if (guard.isNull())
+            return;
+    }
+}
+
+/*!
+    TEMP Auth METHOD. HIGHLY EXPERIMENTAL.
+    Checks for body of \a reply to determine correctness of authentication.
+  */
+void QWebMethod::authReplyFinished(QNetworkReply *reply)
+{
+    Q_D(QWebMethod);
+    d->authenticationReplyReceived = true;
+    QByteArray array = reply->readAll();
+    if (!array.isEmpty())
+    {
+        d->enterErrorState(QLatin1String("Login incorrect."));
+    }
+//    else        qDebug() << "Login correct";
+    reply->deleteLater();
+}
+
+/*!
+    Internal method used to authenticate the communication.
+    Use setCredentials() or setUsername() and setPassword()
+    to specify the data.
+
+    This is a fallback method of QNAM. Typically, authenticate()
+    should be used.
+
+    Fills the \a authenticator object. Does not use \a reply.
+  */
+void QWebMethod::authenticationSlot(QNetworkReply *reply,
+                                    QAuthenticator *authenticator)
+{
+    Q_D(QWebMethod);
+    // The manager may be shared with other web methods.
+    if (reply->request().originatingObject() != this)
+        return;
+
+    if (d->authenticationError)
+    {
+        d->enterErrorState(QString(QLatin1String("Authentication error! ")
+                                   + reply->readAll()));
+        return;
+    }
+
+    authenticator->setUser(d->m_username);
+    authenticator->setPassword(d->m_password);
+    d->authenticationError = true;
+    reply->deleteLater();
+}
+
+/*!
+    Performs genral initialisation of the object.
+    Sets default variable values, initializes network manager,
+    connects reply signals. Calls virtual method, configure().
+  */
+void QWebMethodPrivate::init()
+{
+    replyReceived = false;
+    authenticationReplyReceived = false;
+    errorState = false;
+    authenticationError = false;
+    authenticationPerformed = false;
+    authReply = 0;
+
+    sharedManager = true;
+    incrementalParsing = false;
+    httpTransport = QWebMethod::Http1;
+    priority = QWebMethod::Interactive;
+    idempotent = false;
+    hedgingDelay = 0;
+    hedgingBudget = 10;
+    nextHedgingEndpoint = 0;
+    hedgeEligibleCount = 0;
+    hedgedCallCount = 0;
+    hedgeWinCount = 0;
+    coalescing = false;
+    coalescedCallCount = 0;
+    timeout = 0;
+    deadlineClock.start();
+    deadlineTimer = 0;
+    compressionEnabled = false;
+    compressionThreshold = 1024;
+    bytesSent = 0;
+    uncompressedBytesSent = 0;
+    bytesReceived = 0;
+    uncompressedBytesReceived = 0;
+    parsedReplyCached = false;
+    jsonReplyCached = false;
+    manager = QWebNetworkPool::acquire();
+    lastRequestSize = 0;
+
+    qRegisterMetaType<QWebMethodCall>();
+}
+
+/*!
+    \internal
+
+    Returns a new unique number, used as call ID and as ticket
+    of QWebScheduler.
+  */
+static quint64 newTicket()
+{
+    static QAtomicInteger<quint64> lastTicket;
+    return ++lastTicket;
+}
+
+/*!
+    \internal
+
+    Returns data of a new call of this web method, with a unique ID.
+  */
+QWebMethodCallPrivate *QWebMethodPrivate::newCallData()
+{
+    Q_Q(QWebMethod);
+    QWebMethodCallPrivate *callData = new QWebMethodCallPrivate;
+    callData->clock.start();
+    callData->id = newTicket();
+    callData->methodName = m_methodName;
+    callData->method = q;
+    callData->protocol = protocolUsed;
+    callData->returnValue = returnValue;
+    return callData;
+}
+
+/*!
+    \internal
+
+    Returns a call with body \a requestData, which is answered with
+    \a replyData (taken from result cache of QWebService) instead of
+    sending a request. The call is finished - and callFinished() and
+    replyReady() are emitted - when control returns to the event loop,
+    just like for calls sent over the network.
+  */
+QWebMethodCall QWebMethodPrivate::cachedCall(const QByteArray &requestData,
+                                             const QByteArray &replyData)
+{
+    Q_Q(QWebMethod);
+    QWebMethodCallPrivate *callData = newCallData();
+    callData->requestData = requestData;
+    callData->fromCache = true;
+
+    QWebMethodCall call(callData);
+    QTimer::singleShot(0, q, [this, call, replyData]() {
+        Q_Q(QWebMethod);
+        if (call.isFinished())
+            return;
+
+        call.d->reply = replyData;
+        call.d->httpStatus = 200;
+        call.d->finished = true;
+        call.d->timing.finished = call.d->clock.nsecsElapsed() / 1000;
+
+        reply = replyData;
+        replyReceived = true;
+        parsedReplyCached = false;
+        jsonReplyCached = false;
+
+        QPointer<QWebMethod> guard(q);
+        emit q->callFinished(call);
+        if (!guard.isNull())
+            emit q->replyReady(reply);
+        call.d->complete(call);
+    });
+    return call;
+}
+
+/*!
+    \internal
+
+    Returns the key of flights (see joinFlight()) of requests with body
+    \a requestData: HTTP method, host and hash of the body.
+  */
+QByteArray QWebMethodPrivate::flightKey(const QByteArray &requestData) const
+{
+    QByteArray key = QByteArray::number(int(httpMethodUsed));
+    key += ' ';
+    key += m_hostUrl.toEncoded();
+    key += ' ';
+    key += QCryptographicHash::hash(requestData, QCryptographicHash::Sha1);
+    return key;
+}
+
+/*!
+    \internal
+
+    Returns a new call with body \a requestData (or prepared from
+    parameters, if \a requestData is empty), which waits for the flight
+    (request actually sent) of identical calls. If there is no such
+    flight in progress, it is created and sent. The flight finishes the
+    waiting calls, see finishFlight(), also when the flight fails.
+  */
+QWebMethodCall QWebMethodPrivate::joinFlight(const QByteArray &requestData)
+{
+    QByteArray body = requestData;
+    if (body.isEmpty()) {
+        prepareRequestData();
+        body = data;
+    }
+
+    QByteArray key = flightKey(body);
+    QWebMethodCall flight = flights.value(key);
+
+    QWebMethodCallPrivate *callData = newCallData();
+    callData->flightKey = key;
+    callData->coalesced = true;
+    QWebMethodCall call(callData);
+
+    if (timeout > 0)
+        setCallDeadline(call, deadlineClock.elapsed() + timeout);
+
+    bool joined = flight.isValid();
+    if (joined) {
+        ++coalescedCallCount;
+    } else {
+        flight = createCall(body);
+        flight.d->flightKey = key;
+        flight.d->flight = true;
+        flights.insert(key, flight);
+    }
+
+    // Body is shared with the flight, as it was sent.
+    callData->requestData = flight.d->requestData;
+    callData->requestCompressed = flight.d->requestCompressed;
+    flight.d->waiters.append(call);
+    if (joined)
+        return call;
+
+    // Request might fail right away - then the call is finished already.
+    sendCall(flight);
+    return call;
+}
+
+/*!
+    \internal
+
+    Finishes calls waiting for \a flight, which has just finished,
+    with its reply, status and error. The reply data is shared, not
+    copied. If \a replied is true, the reply becomes the reply of this
+    web method, and replyReady() is emitted (once for all calls).
+  */
+void QWebMethodPrivate::finishFlight(const QWebMethodCall &flight, bool replied)
+{
+    Q_Q(QWebMethod);
+    if (flights.value(flight.d->flightKey) == flight)
+        flights.remove(flight.d->flightKey);
+
+    QList<QWebMethodCall> waiters = flight.d->waiters;
+    flight.d->waiters.clear();
+    if (waiters.isEmpty())
+        return;
+
+    const QWebMethodCallPrivate *flightData = flight.d.constData();
+    foreach (const QWebMethodCall &call, waiters) {
+        QWebMethodCallPrivate *callData = call.d.data();
+        clearCallDeadline(call);
+        callData->reply = flightData->reply;
+        callData->httpStatus = flightData->httpStatus;
+        callData->http2Used = flightData->http2Used;
+        callData->hedged = flightData->hedged;
+        callData->attempts = flightData->attempts;
+        callData->timedOut = flightData->timedOut;
+        callData->errorState = flightData->errorState;
+        callData->errorMessage = flightData->errorMessage;
+        callData->timing = flightData->timing;
+        callData->finished = true;
+    }
+
+    if (replied) {
+        reply = flightData->reply;
+        replyReceived = true;
+        parsedReplyCached = false;
+        jsonReplyCached = false;
+    }
+
+    // Slots might delete this web method, waiting calls are completed
+    // anyway.
+    QPointer<QWebMethod> guard(q);
+    foreach (const QWebMethodCall &call, waiters) {
+        if (!guard.isNull())
+            emit q->callFinished(call);
+    }
+    if (replied && !guard.isNull())
+        emit q->replyReady(reply);
+
+    foreach (const QWebMethodCall &call, waiters)
+        call.d->complete(call);
+}
+
+/*!
+    \internal
+
+    Creates a new call. Uses \a requestData as call's body, or prepares it
+    from parameters, if \a requestData is empty. If \a requestDevice is
+    specified, the body is streamed from that device instead
+    (\a requestSize bytes, or unknown if it is negative).
+  */
+QWebMethodCall QWebMethodPrivate::createCall(const QByteArray &requestData,
+                                             QIODevice *requestDevice,
+                                             qint64 requestSize)
+{
+    QWebMethodCallPrivate *callData = newCallData();
+
+    if (requestDevice != 0) {
+        callData->requestDevice = requestDevice;
+        callData->requestSize = requestSize;
+
+        if (requestSize > 0) {
+            bytesSent += requestSize;
+            uncompressedBytesSent += requestSize;
+        }
+        callData->timing.serialized = callData->clock.nsecsElapsed() / 1000;
+        return QWebMethodCall(callData);
+    } else if (requestData.isNull() || requestData.isEmpty()) {
+        prepareRequestData();
+        callData->requestData = data;
+    } else {
+        callData->requestData = requestData;
+    }
+
+    uncompressedBytesSent += callData->requestData.size();
+
+    if (compressionEnabled && (callData->requestData.size() >= compressionThreshold)) {
+        QByteArray compressed = QWebCompressor::gzip(callData->requestData);
+        if (!compressed.isEmpty() && (compressed.size() < callData->requestData.size())) {
+            callData->requestData = compressed;
+            callData->requestCompressed = true;
+        }
+    }
+
+    bytesSent += callData->requestData.size();
+    callData->timing.serialized = callData->clock.nsecsElapsed() / 1000;
+
+    return QWebMethodCall(callData);
+}
+
+/*!
+    \internal
+
+    Reads the reply and status of \a netReply into \a call, and marks
+    it as finished.
+  */
+void QWebMethodPrivate::finishCall(const QWebMethodCall &call, QNetworkReply *netReply)
+{
+    QWebMethodCallPrivate *callData = call.d.data();
+    readReplyData(call, netReply);
+
+    if (callData->parser != 0) {
+        callData->parser->finish();
+        emitReplyItems(call);
+    }
+
+    callData->httpStatus = netReply->attribute(
+                QNetworkRequest::HttpStatusCodeAttribute).toInt();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+    callData->http2Used = netReply->attribute(
+                QNetworkRequest::HTTP2WasUsedAttribute).toBool();
+    if (callData->http2Used)
+        QWebNetworkPool::registerHttp2Stream(manager, netReply->url());
+#endif
+    if (callData->timedOut) {
+        callData->errorState = true;
+        callData->errorMessage = QLatin1String("Request timed out.");
+    } else if (netReply->error() != QNetworkReply::NoError) {
+        callData->errorState = true;
+        callData->errorMessage = netReply->errorString();
+    } else if ((callData->decompressor != 0) && callData->decompressor->hasError()) {
+        callData->errorState = true;
+        callData->errorMessage = QLatin1String("Reply could not be decompressed.");
+    } else if ((callData->parser != 0) && callData->parser->hasError()) {
+        callData->errorState = true;
+        callData->errorMessage = callData->parser->errorString();
+    }
+    callData->finished = true;
+    callData->networkReply = 0;
+}
+
+/*!
+    \internal
+
+    Aborts the network reply (and hedge) of unfinished \a call, or removes
+    it from QWebScheduler's queue, if it has not been sent yet. The call
+    finishes (and callFinished() is emitted) in error state. If \a timedOut is true,
+    error message says that the request timed out.
+  */
+void QWebMethodPrivate::abortCall(const QWebMethodCall &call, bool timedOut)
+{
+    Q_Q(QWebMethod);
+    QWebMethodCallPrivate *callData = call.d.data();
+    if ((callData == 0) || callData->finished)
+        return;
+
+    if (callData->coalesced) {
+        QWebMethodCall flight = flights.value(callData->flightKey);
+        if (flight.isValid() && (flight.d->waiters.removeAll(call) > 0)
+                && flight.d->waiters.isEmpty()) {
+            // No call waits for the request any more.
+            flights.remove(callData->flightKey);
+            abortCall(flight, false);
+        }
+
+        failQueuedCall(call, timedOut ? QLatin1String("Request timed out.")
+                                      : QLatin1String("Call was aborted."));
+        return;
+    }
+
+    if (queuedCalls.contains(callData->id)) {
+        QWebScheduler::cancel(callData->request.url(), callData->id,
+                              callData->multiplexed);
+        failQueuedCall(call, timedOut ? QLatin1String("Request timed out.")
+                                      : QLatin1String("Call was aborted."));
+        return;
+    }
+
+    if (callData->fromCache) {
+        failQueuedCall(call, QLatin1String("Call was aborted."));
+        return;
+    }
+
+    if (!callData->hedgeReply.isNull()) {
+        QNetworkReply *hedge = callData->hedgeReply;
+        callData->hedgeReply = 0;
+        pendingCalls.remove(hedge);
+        hedge->disconnect(q);
+        hedge->abort();
+        hedge->deleteLater();
+    }
+
+    if (callData->networkReply == 0)
+        return;
+
+    callData->timedOut = timedOut;
+    callData->networkReply->abort();
+}
+
+/*!
+    \internal
+
+    Finishes \a call, which has not been sent, in error state with
+    \a errorMessage, and emits callFinished().
+  */
+void QWebMethodPrivate::failQueuedCall(const QWebMethodCall &call, const QString &errorMessage)
+{
+    Q_Q(QWebMethod);
+    queuedCalls.remove(call.d->id);
+    clearCallDeadline(call);
+    call.d->finished = true;
+    call.d->errorState = true;
+    call.d->errorMessage = errorMessage;
+    recordMetrics(call);
+
+    if (call.d->flight) {
+        finishFlight(call, false);
+        return;
+    }
+
+    emit q->callFinished(call);
+    call.d->complete(call);
+}
+
+/*!
+    \internal
+
+    Notes the finish of \a call in its timing, records it in QWebMetrics,
+    and logs it, if it was slow (see QWebMetrics::setSlowCallThreshold()).
+  */
+void QWebMethodPrivate::recordMetrics(const QWebMethodCall &call)
+{
+    QWebMethodCallPrivate *callData = call.d.data();
+    callData->timing.finished = callData->clock.nsecsElapsed() / 1000;
+
+    if (callData->metrics != 0) {
+        QWebMetricsPrivate::callFinished(callData->metrics, callData->timing.finished,
+                                         callData->reply.size(), callData->errorState);
+        QWebMetricsPrivate::timingFinished(callData->metrics, callData->timing);
+    }
+
+    int threshold = QWebMetrics::slowCallThreshold();
+    if ((threshold > 0) && (callData->timing.finished >= qint64(threshold) * 1000))
+        QWebMetricsPrivate::logSlowCall(m_methodName, m_hostUrl, callData->timing);
+}
+
+/*!
+    \internal
+
+    Returns a finished call of \a methodName, which failed with
+    \a errorMessage before it could be sent. Used where every request
+    needs a call handle, like in QWebBatch.
+  */
+QWebMethodCall QWebMethodPrivate::failedCall(const QString &methodName,
+                                             const QString &errorMessage)
+{
+    QWebMethodCallPrivate *callData = new QWebMethodCallPrivate;
+    callData->methodName = methodName;
+    callData->finished = true;
+    callData->errorState = true;
+    callData->errorMessage = errorMessage;
+    callData->resultDecoded = true;
+    return QWebMethodCall(callData);
+}
+
+/*!
+    \internal
+
+    Reads data available in \a netReply, decompresses it if needed,
+    and passes it to the parser of \a call (emitting replyItemReceived()
+    for every item read), or appends it to the call's reply.
+  */
+void QWebMethodPrivate::readReplyData(const QWebMethodCall &call, QNetworkReply *netReply)
+{
+    QWebMethodCallPrivate *callData = call.d.data();
+    QByteArray chunk = netReply->readAll();
+    if (chunk.isEmpty())
+        return;
+
+    bytesReceived += chunk.size();
+
+    if (callData->acceptsCompressedReply && !callData->replyEncodingChecked) {
+        QByteArray encoding = netReply->rawHeader("Content-Encoding").trimmed().toLower();
+        if ((encoding == "gzip") || (encoding == "x-gzip") || (encoding == "deflate"))
+            callData->decompressor = new QWebDecompressor;
+        callData->replyEncodingChecked = true;
+    }
+
+    if (callData->decompressor != 0)
+        chunk = callData->decompressor->decompress(chunk);
+
+    uncompressedBytesReceived += chunk.size();
+
+    if (callData->parser != 0) {
+        callData->parser->addData(chunk);
+        emitReplyItems(call);
+    } else {
+        callData->reply.append(chunk);
+    }
+}
+
+/*!
+    \internal
+
+    Emits replyItemReceived() for every item the parser of \a call
+    can read.
+  */
+void QWebMethodPrivate::emitReplyItems(const QWebMethodCall &call)
+{
+    Q_Q(QWebMethod);
+    QWebReplyParser *parser = call.d->parser;
+
+    while (parser->readNext())
+        emit q->replyItemReceived(call, parser->name(), parser->value());
+}
+
+/*!
+    \internal
+
+    Prepares QNetworkRequest according to protocol settings.
+  */
+QNetworkRequest QWebMethodPrivate::prepareRequest()
+{
+    Q_Q(QWebMethod);
+    QNetworkRequest request;
+    request.setUrl(m_hostUrl);
+    request.setOriginatingObject(q);
+
+    if (protocolUsed & QWebMethod::Soap) {
+        request.setHeader(QNetworkRequest::ContentTypeHeader,
+                          QVariant(QLatin1String("application/soap+xml; charset=utf-8")));
+    } else if (protocolUsed & QWebMethod::Json) {
+        request.setHeader(QNetworkRequest::ContentTypeHeader,
+                          QVariant(QLatin1String("application/json; charset=utf-8")));
+    } else if (protocolUsed & QWebMethod::Http) {
+        request.setHeader(QNetworkRequest::ContentTypeHeader,
+                          QVariant(QLatin1String("application/x-www-form-urlencoded")));
+    } else if (protocolUsed & QWebMethod::Xml) {
+        request.setHeader(QNetworkRequest::ContentTypeHeader,
+                          QVariant(QLatin1String("application/xml; charset=utf-8")));
+    }
+
+    if (protocolUsed & QWebMethod::Soap10)
+        request.setRawHeader(QByteArray("SOAPAction"),
+                             QByteArray(m_hostUrl.toString().toLatin1()));
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute,
+                         (httpTransport != QWebMethod::Http1));
+#endif
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    if (httpTransport == QWebMethod::Http2Direct)
+        request.setAttribute(QNetworkRequest::Http2DirectAttribute, true);
+#endif
+
+    return request;
+}
+
+/*!
+    \internal
+
+    Prepares request of the \a call using current protocol and HTTP method,
+    and passes it to QWebScheduler, which sends it (see dispatchCall())
+    when there is a free connection to the host. The reply is routed back
+    to that call only. Errors are reported by finishing the call.
+  */
+void QWebMethodPrivate::sendCall(const QWebMethodCall &call)
+{
+    QNetworkRequest request = prepareRequest();
+    QIODevice *device = call.d->requestDevice;
+
+    if (call.d->requestCompressed)
+        request.setRawHeader("Content-Encoding", "gzip");
+
+    if (compressionEnabled) {
+        // Setting the header disables decompression in QNetworkAccessManager,
+        // reply is decompressed while it is read, see readReplyData().
+        request.setRawHeader("Accept-Encoding", "gzip, deflate");
+        call.d->acceptsCompressedReply = true;
+    }
+
+    if ((device != 0) && device->isSequential() && (call.d->requestSize >= 0)) {
+        // With known length, sequential data does not need to be buffered.
+        request.setHeader(QNetworkRequest::ContentLengthHeader, call.d->requestSize);
+        request.setAttribute(QNetworkRequest::DoNotBufferUploadDataAttribute, true);
+    }
+
+    // OPTIONAL - FOR TESTING:
+//    qDebug() << request.url().toString();
+//    qDebug() << QString(call.d->requestData);
+    // ENDOF: OPTIONAL - FOR TESTING
+
+    QNetworkAccessManager::Operation operation = QNetworkAccessManager::PostOperation;
+    if (protocolUsed & QWebMethod::Rest) {
+        if (httpMethodUsed == QWebMethod::Get)
+            operation = QNetworkAccessManager::GetOperation;
+        else if (httpMethodUsed == QWebMethod::Put)
+            operation = QNetworkAccessManager::PutOperation;
+        else if (httpMethodUsed == QWebMethod::Delete)
+            operation = QNetworkAccessManager::DeleteOperation;
+    }
+
+    call.d->request = request;
+    call.d->operation = operation;
+    call.d->multiplexed = (httpTransport != QWebMethod::Http1);
+
+    if (QWebMetrics::isEnabled()) {
+        call.d->metrics = QWebMetricsPrivate::series(m_methodName, m_hostUrl);
+        QWebMetricsPrivate::callStarted(call.d->metrics, (device != 0) ? call.d->requestSize
+                                                                   : call.d->requestData.size());
+    }
+
+    scheduleCall(call);
+
+    // Flights have no deadline, calls waiting for them do.
+    if ((timeout > 0) && !call.d->flight && !call.isFinished())
+        setCallDeadline(call, deadlineClock.elapsed() + timeout);
+}
+
+/*!
+    \internal
+
+    Puts prepared \a call in QWebScheduler's queue.
+  */
+void QWebMethodPrivate::scheduleCall(const QWebMethodCall &call)
+{
+    Q_Q(QWebMethod);
+    queuedCalls.insert(call.d->id, call);
+
+    QPointer<QWebMethod> method(q);
+    QWebMethodCall scheduledCall = call;
+    QWebScheduler::schedule(call.d->request.url(), QWebScheduler::Lane(priority), call.d->id,
+                            [method, scheduledCall]() {
+        if (method.isNull() || scheduledCall.isFinished())
+            return false;
+        return method->d_func()->dispatchCall(scheduledCall);
+    }, call.d->multiplexed);
+}
+
+/*!
+    \internal
+
+    Sends the \a call, which was prepared by sendCall(). Called by
+    QWebScheduler, when the call can use a connection. Returns false,
+    if the call could not be sent (it is finished with an error then).
+  */
+bool QWebMethodPrivate::dispatchCall(const QWebMethodCall &call)
+{
+    Q_Q(QWebMethod);
+    queuedCalls.remove(call.d->id);
+
+    QIODevice *device = call.d->requestDevice;
+    QNetworkReply *netReply = sendRequest(call, call.d->request);
+
+    if (netReply == 0) {
+        failQueuedCall(call, QLatin1String("Request could not be sent."));
+        return false;
+    }
+
+    call.d->scheduled = true;
+    if (call.d->ownsRequestDevice) {
+        device->setParent(netReply);
+        call.d->ownsRequestDevice = false;
+    }
+
+    // Replies are routed through QNetworkReply::finished(), and not through
+    // the manager, which may be shared with other web methods.
+    call.d->networkReply = netReply;
+    pendingCalls.insert(netReply, call);
+    QObject::connect(netReply, SIGNAL(finished()), q, SLOT(networkReplyFinished()));
+
+    if (incrementalParsing) {
+        call.d->parser = new QWebReplyParser((protocolUsed & QWebMethod::Json) ?
+                                                 QWebReplyParser::Json : QWebReplyParser::Xml);
+    }
+
+    // Timing of the call's phases, see QWebCallTiming.
+    call.d->timing.dispatched = call.d->clock.nsecsElapsed() / 1000;
+    call.d->timing.encrypted = -1;
+    call.d->timing.headersReceived = -1;
+    call.d->timing.firstByte = -1;
+    QObject::connect(netReply, SIGNAL(metaDataChanged()), q, SLOT(networkReplyMetaDataChanged()));
+    QObject::connect(netReply, SIGNAL(readyRead()), q, SLOT(networkReplyReadyRead()));
+#ifndef QT_NO_SSL
+    QObject::connect(netReply, SIGNAL(encrypted()), q, SLOT(networkReplyEncrypted()));
+#endif
+
+    if ((hedgingDelay > 0) && idempotent && (device == 0) && !incrementalParsing) {
+        ++hedgeEligibleCount;
+        QWebMethodCall hedgedCall = call;
+        QPointer<QNetworkReply> primary(netReply);
+        QTimer::singleShot(hedgingDelay, q, [this, hedgedCall, primary]() {
+            sendHedge(hedgedCall, primary);
+        });
+    }
+    return true;
+}
+
+/*!
+    \internal
+
+    Sends \a request with body of the \a call, using operation of the call.
+    Returns the reply, or 0 on failure.
+  */
+QNetworkReply *QWebMethodPrivate::sendRequest(const QWebMethodCall &call,
+                                              const QNetworkRequest &request)
+{
+    const QByteArray &body = call.d->requestData;
+    QIODevice *device = call.d->requestDevice;
+    QWebNetworkPool::registerRequest(manager, request.url());
+
+    if (call.d->operation == QNetworkAccessManager::GetOperation)
+        return manager->get(request);
+    else if (call.d->operation == QNetworkAccessManager::DeleteOperation)
+        return manager->deleteResource(request);
+    else if (call.d->operation == QNetworkAccessManager::PutOperation)
+        return (device != 0) ? manager->put(request, device) : manager->put(request, body);
+    else if (device != 0)
+        return manager->post(request, device);
+    return manager->post(request, body);
+}
+
+/*!
+    \internal
+
+    Passes a hedge (duplicate request) for \a call to QWebScheduler, if
+    the call is still waiting for its \a primary reply, and hedging budget
+    allows it. Hedges use connections of their host like other requests,
+    see dispatchHedge().
+
+    \sa QWebMethod::setHedgingDelay()
+  */
+void QWebMethodPrivate::sendHedge(const QWebMethodCall &call, QNetworkReply *primary)
+{
+    Q_Q(QWebMethod);
+    QWebMethodCallPrivate *callData = call.d.data();
+    if ((primary == 0) || callData->finished || (callData->networkReply != primary)
+            || !callData->hedgeReply.isNull()) {
+        return;
+    }
+
+    if ((hedgedCallCount + 1) * 100 > quint64(hedgingBudget) * hedgeEligibleCount)
+        return;
+
+    QNetworkRequest request = callData->request;
+    if (!hedgingEndpoints.isEmpty()) {
+        nextHedgingEndpoint %= hedgingEndpoints.size();
+        const QUrl &endpoint = hedgingEndpoints.at(nextHedgingEndpoint++);
+        QUrl url = request.url();
+        url.setScheme(endpoint.scheme());
+        url.setHost(endpoint.host());
+        url.setPort(endpoint.port());
+        request.setUrl(url);
+    }
+
+    QPointer<QWebMethod> method(q);
+    QPointer<QNetworkReply> primaryReply(primary);
+    QWebMethodCall hedgedCall = call;
+    QWebScheduler::schedule(request.url(), QWebScheduler::Lane(priority), newTicket(),
+                            [method, hedgedCall, primaryReply, request]() {
+        if (method.isNull())
+            return false;
+        return method->d_func()->dispatchHedge(hedgedCall, primaryReply, request);
+    }, callData->multiplexed);
+}
+
+/*!
+    \internal
+
+    Sends the hedge of \a call with \a request. Called by QWebScheduler,
+    when the hedge can use a connection. Returns false (and sends nothing),
+    if the call is not waiting for its \a primary reply any more. Hedge
+    reply is not read until it is finished, see settleHedge().
+  */
+bool QWebMethodPrivate::dispatchHedge(const QWebMethodCall &call, QNetworkReply *primary,
+                                      const QNetworkRequest &request)
+{
+    Q_Q(QWebMethod);
+    QWebMethodCallPrivate *callData = call.d.data();
+    if ((primary == 0) || callData->finished || (callData->networkReply != primary)
+            || !callData->hedgeReply.isNull()) {
+        return false;
+    }
+
+    QNetworkReply *netReply = sendRequest(call, request);
+    if (netReply == 0)
+        return false;
+
+    ++hedgedCallCount;
+    callData->hedged = true;
+    callData->hedgeReply = netReply;
+    callData->hedgeScheduled = true;
+    callData->hedgeUrl = request.url();
+    pendingCalls.insert(netReply, call);
+    QObject::connect(netReply, SIGNAL(finished()), q, SLOT(networkReplyFinished()));
+    return true;
+}
+
+/*!
+    \internal
+
+    Frees the connection slot of QWebScheduler held by the hedge of the call
+    with \a callData, if it holds one.
+  */
+void QWebMethodPrivate::releaseHedge(QWebMethodCallPrivate *callData)
+{
+    if (!callData->hedgeScheduled)
+        return;
+
+    callData->hedgeScheduled = false;
+    QWebScheduler::release(callData->hedgeUrl, callData->multiplexed);
+}
+
+/*!
+    \internal
+
+    Decides the race between the original request and the hedge of \a call,
+    when one of them (\a netReply) is finished. A successful reply wins,
+    and the other request is aborted. A failed one is dropped if the other
+    request is still running, and the call keeps waiting for it - in that
+    case, returns true. Calls without a hedge are not affected.
+
+    Hedges count as won (see QWebMethod::hedgeWinCount()) when their
+    reply is used, also when it arrives after the original one failed.
+
+    Connection slots of QWebScheduler are freed as soon as their request
+    is finished or aborted. The slot of the original request is freed
+    by QWebMethod::replyFinished(), unless the hedge replaced it.
+  */
+bool QWebMethodPrivate::settleHedge(const QWebMethodCall &call, QNetworkReply *netReply)
+{
+    Q_Q(QWebMethod);
+    QWebMethodCallPrivate *callData = call.d.data();
+    QNetworkReply *hedge = callData->hedgeReply;
+    if (hedge == 0) {
+        // Hedge was aborted, or it has replaced the original request.
+        if (callData->hedgeWon && (netReply->error() == QNetworkReply::NoError))
+            ++hedgeWinCount;
+        callData->hedgeWon = false;
+        releaseHedge(callData);
+        return false;
+    }
+
+    QNetworkReply *other = (netReply == hedge) ? callData->networkReply.data() : hedge;
+    callData->hedgeReply = 0;
+    if ((other == 0) || !pendingCalls.contains(other)) {
+        if (netReply == hedge)
+            releaseHedge(callData);
+        return false;
+    }
+
+    bool primaryDone = false;
+    bool waiting = false;
+
+    if (netReply->error() != QNetworkReply::NoError) {
+        // Part of the original reply could have been read already.
+        if (other == hedge) {
+            callData->resetReply();
+            callData->hedgeWon = true;
+            primaryDone = true;
+        }
+        callData->networkReply = other;
+        waiting = true;
+    } else {
+        pendingCalls.remove(other);
+        other->disconnect(q);
+        other->abort();
+        other->deleteLater();
+
+        if (netReply == hedge) {
+            callData->resetReply();
+            callData->networkReply = netReply;
+            ++hedgeWinCount;
+            primaryDone = true;
+        }
+    }
+
+    // Slots are freed last, as freeing them may send queued requests.
+    if (primaryDone && callData->scheduled) {
+        callData->scheduled = false;
+        QWebScheduler::release(callData->request.url(), callData->multiplexed);
+    }
+    if (!waiting || (other != hedge))
+        releaseHedge(callData);
+    return waiting;
+}
+
+/*!
+    \internal
+
+    Returns true if \a call, which has just finished with \a netReply,
+    failed with a transient error and can be sent again, according to
+    retryPolicy. Only calls of idempotent web methods are retried.
+  */
+bool QWebMethodPrivate::isRetryable(const QWebMethodCall &call, QNetworkReply *netReply) const
+{
+    const QWebMethodCallPrivate *callData = call.d.constData();
+    if (!idempotent || (callData->attempts >= retryPolicy.maxAttempts()))
+        return false;
+
+    // Streamed request bodies cannot be read again, and timed out calls
+    // have used up their time already.
+    if ((callData->requestDevice != 0) || callData->timedOut)
+        return false;
+
+    int status = callData->httpStatus;
+    if (status == 0)
+        return retryPolicy.isRetryableNetworkError(netReply->error());
+
+    // Items of incrementally parsed replies have been emitted already.
+    if (callData->parser != 0)
+        return false;
+
+    if (status < 400)
+        return false;
+
+    if (protocolUsed & QWebMethod::Soap) {
+        QString faultCode = soapFaultCode(callData->reply);
+        if (!faultCode.isEmpty())
+            return retryPolicy.isRetryableFaultCode(faultCode);
+    }
+
+    return retryPolicy.isRetryableHttpStatus(status);
+}
+
+/*!
+    \internal
+
+    Sends \a call, which has just finished with \a netReply, again if it
+    is retryable (see isRetryable()). The call waits in queuedCalls for
+    a delay given by retryPolicy, and is scheduled with its original
+    request and body. Returns true if the call will be retried.
+  */
+bool QWebMethodPrivate::retryCall(const QWebMethodCall &call, QNetworkReply *netReply)
+{
+    Q_Q(QWebMethod);
+    if (!isRetryable(call, netReply))
+        return false;
+
+    int delay = retryPolicy.delay(call.d->attempts);
+    ++call.d->attempts;
+    call.d->resetReply();
+    queuedCalls.insert(call.d->id, call);
+
+    // Aborted calls are removed from queuedCalls while they wait.
+    QWebMethodCall retriedCall = call;
+    QTimer::singleShot(delay, q, [this, retriedCall]() {
+        if (queuedCalls.contains(retriedCall.id()) && !retriedCall.isFinished()) {
+            retriedCall.d->timing.queued = retriedCall.d->clock.nsecsElapsed() / 1000;
+            scheduleCall(retriedCall);
+        }
+    });
+    return true;
+}
+
+/*!
+    \internal
+
+    Returns code of the SOAP fault in \a replyData, without namespace
+    prefix (for example "Server" or "Receiver"), or an empty string,
+    if the reply is not a SOAP fault.
+  */
+QString QWebMethodPrivate::soapFaultCode(const QByteArray &replyData)
+{
+    if (!replyData.contains("Fault"))
+        return QString();
+
+    QXmlStreamReader reader(replyData);
+    bool inFault = false;
+    bool inCode = false;
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        QString code;
+        if (reader.name() == QLatin1String("Fault"))
+            inFault = true;
+        else if (inFault && (reader.name() == QLatin1String("faultcode")))
+            code = reader.readElementText();
+        else if (inFault && (reader.name() == QLatin1String("Code")))
+            inCode = true;
+        else if (inCode && (reader.name() == QLatin1String("Value")))
+            code = reader.readElementText();
+
+        if (!code.isEmpty())
+            return code.mid(code.lastIndexOf(QLatin1Char(':')) + 1).trimmed();
+    }
+
+    return QString();
+}
+
+/*!
+    \internal
+
+    Sets \a deadline (time of deadlineClock) of \a call, replacing its
+    previous deadline. All deadlines share one timer, which is set to
+    the earliest of them.
+  */
+void QWebMethodPrivate::setCallDeadline(const QWebMethodCall &call, qint64 deadline)
+{
+    Q_Q(QWebMethod);
+    clearCallDeadline(call);
+    call.d->deadline = deadline;
+    deadlines.insert(deadline, call);
+
+    if (deadlineTimer == 0) {
+        deadlineTimer = new QTimer(q);
+        deadlineTimer->setSingleShot(true);
+        QObject::connect(deadlineTimer, SIGNAL(timeout()), q, SLOT(deadlineTimeout()));
+    }
+
+    if (!deadlineTimer->isActive() || (deadline == deadlines.firstKey()))
+        startDeadlineTimer();
+}
+
+/*!
+    \internal
+
+    Removes deadline of \a call, if it has one. The timer is not stopped,
+    it is rearmed when it fires.
+  */
+void QWebMethodPrivate::clearCallDeadline(const QWebMethodCall &call)
+{
+    if (call.d->deadline < 0)
+        return;
+
+    deadlines.remove(call.d->deadline, call);
+    call.d->deadline = -1;
+}
+
+/*!
+    \internal
+
+    Starts the deadline timer for the earliest deadline, or stops it
+    if there are none.
+  */
+void QWebMethodPrivate::startDeadlineTimer()
+{
+    if (deadlineTimer == 0)
+        return;
+
+    if (deadlines.isEmpty()) {
+        deadlineTimer->stop();
+        return;
+    }
+
+    qint64 wait = deadlines.firstKey() - deadlineClock.elapsed();
+    deadlineTimer->start(int(qBound(qint64(0), wait, qint64(INT_MAX))));
+}
+
+/*!
+    \internal
+
+    Cancels unfinished \a call: aborts it (see abortCall()), and frees
+    its request and reply data, which are not needed any more.
+  */
+void QWebMethodPrivate::cancelCall(const QWebMethodCall &call)
+{
+    abortCall(call, false);
+    call.d->requestData = QByteArray();
+    call.d->reply = QByteArray();
+}
+
+/*!
+    \internal
+
+    Returns calls which are not finished: queued ones first, then ones
+    waiting for a reply. Hedged calls, which wait for two replies, are
+    listed once.
+  */
+QList<QWebMethodCall> QWebMethodPrivate::unfinishedCalls() const
+{
+    QList<QWebMethodCall> calls = queuedCalls.values();
+    QSet<quint64> listed;
+    foreach (const QWebMethodCall &call, pendingCalls) {
+        if (!listed.contains(call.d->id)) {
+            listed.insert(call.d->id);
+            calls.append(call);
+        }
+    }
+    return calls;
+}
+
+/*!
+    \internal
+
+    Returns calls which are not finished, like unfinishedCalls(), but
+    with flights replaced by the calls waiting for them.
+  */
+QList<QWebMethodCall> QWebMethodPrivate::waitingCalls() const
+{
+    QList<QWebMethodCall> calls;
+    foreach (const QWebMethodCall &call, unfinishedCalls()) {
+        if (call.d->flight)
+            calls.append(call.d->waiters);
+        else
+            calls.append(call);
+    }
+    return calls;
+}
+
+/*!
+    \internal
+
+    Waits for the reply to authenticate(), if it was called and the reply
+    has not arrived yet. Waiting is done in a local event loop, and gives up
+    after 30 seconds.
+  */
+void QWebMethodPrivate::waitForAuthentication()
+{
+    Q_Q(QWebMethod);
+    QObject::connect(manager, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)),
+                     q, SLOT(authenticationSlot(QNetworkReply*,QAuthenticator*)),
+                     Qt::UniqueConnection);
+
+    if ((authenticationPerformed == true)
+            && (authenticationReplyReceived == false)) {
+        if (!QWebNetworkPool::waitForFinished(authReply))
+            enterErrorState(QLatin1String("Authentication timed out."));
+    }
+}
+
+/*!
+    \internal
+
+    Runs futures and continuations of \a droppedCalls, which were already
+    marked as finished by releaseManager().
+  */
+void QWebMethodPrivate::completeDroppedCalls(const QList<QWebMethodCall> &droppedCalls)
+{
+    foreach (const QWebMethodCall &call, droppedCalls)
+        call.d->complete(call);
+}
+
+/*!
+    \internal
+
+    Aborts all pending replies and releases the network manager
+    (or deletes it, if it is not shared). Dropped calls finish in error
+    state at once, but their futures and continuations run from the
+    event loop, after this function (and the destructor) returns - unless
+    the thread runs no event loop.
+  */
+void QWebMethodPrivate::releaseManager()
+{
+    Q_Q(QWebMethod);
+    QList<QNetworkReply *> netReplies = pendingCalls.keys();
+    if (authReply != 0)
+        netReplies.append(authReply);
+
+    foreach (QNetworkReply *netReply, netReplies) {
+        netReply->disconnect(q);
+        netReply->abort();
+        netReply->deleteLater();
+    }
+
+    // Dropped calls are finished in error state, so that their futures
+    // and continuations do not wait forever. Queued calls are finished
+    // first, so that freed connections are not given to them.
+    QList<QWebMethodCall> droppedCalls = unfinishedCalls();
+    pendingCalls.clear();
+    queuedCalls.clear();
+    flights.clear();
+    deadlines.clear();
+    foreach (const QWebMethodCall &call, droppedCalls) {
+        if (!call.d->scheduled)
+            QWebScheduler::cancel(call.d->request.url(), call.d->id, call.d->multiplexed);
+
+        call.d->finished = true;
+        call.d->errorState = true;
+        call.d->errorMessage = QLatin1String("Call was aborted.");
+        recordMetrics(call);
+        call.d->networkReply = 0;
+        call.d->hedgeReply = 0;
+        call.d->deadline = -1;
+    }
+
+    foreach (const QWebMethodCall &call, droppedCalls) {
+        if (call.d->scheduled) {
+            call.d->scheduled = false;
+            QWebScheduler::release(call.d->request.url(), call.d->multiplexed);
+        }
+        releaseHedge(call.d.data());
+
+        foreach (const QWebMethodCall &waiter, call.d->waiters) {
+            waiter.d->finished = true;
+            waiter.d->errorState = true;
+            waiter.d->errorMessage = QLatin1String("Call was aborted.");
+            waiter.d->deadline = -1;
+            droppedCalls.append(waiter);
+        }
+        call.d->waiters.clear();
+    }
+    authReply = 0;
+
+    // This is called by the destructor, too - continuations and futures
+    // of dropped calls are completed later, when the web method is gone.
+    // Threads that run no event loop (like those of QThreadPool) would
+    // never get to them, so they are completed right away there.
+    if (!droppedCalls.isEmpty()) {
+        QThread *thread = QThread::currentThread();
+        QCoreApplication *application = QCoreApplication::instance();
+        if (((application != 0) && (application->thread() == thread))
+                || (thread->loopLevel() > 0)) {
+            QTimer::singleShot(0, [droppedCalls]() { completeDroppedCalls(droppedCalls); });
+        } else {
+            completeDroppedCalls(droppedCalls);
+        }
+    }
+
+    manager->disconnect(q);
+    if (sharedManager)
+        QWebNetworkPool::release(manager);
+    else
+        delete manager;
+    manager = 0;
+}
+
+/*!
+    \internal
+
+    Builds the constant part of SOAP envelope: everything before and after
+    the parameters. The result depends only on protocol, method name and
+    target namespace, so it is cached, and rebuilt only when one of them
+    changes.
+  */
+void QWebMethodPrivate::prepareEnvelope()
+{
+    if (!envelopePrefix.isEmpty()
+            && (envelopeProtocol == protocolUsed)
+            && (envelopeMethodName == m_methodName)
+            && (envelopeNamespace == m_targetNamespace)) {
+        return;
+    }
+
+    envelopeProtocol = protocolUsed;
+    envelopeMethodName = m_methodName;
+    envelopeNamespace = m_targetNamespace;
+
+    const QByteArray methodName = m_methodName.toUtf8();
+    QByteArray soapPrefix;
+
+    if (protocolUsed & QWebMethod::Soap12)
+        soapPrefix = "soap12";
+    else
+        soapPrefix = "soap";
+
+    envelopePrefix = "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+            "<" + soapPrefix + ":Envelope "
+            "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+            "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" "
+            "xmlns:" + soapPrefix + "=\"http://www.w3.org/2003/05/soap-envelope\">"
+            "<" + soapPrefix + ":Body>"
+            "<" + methodName + " xmlns=\""
+            + m_targetNamespace.toHtmlEscaped().toUtf8() + "\">";
+
+    envelopeSuffix = "</" + methodName + ">"
+            "</" + soapPrefix + ":Body>"
+            "</" + soapPrefix + ":Envelope>";
+}
+
+/*!
+    \internal
+
+    Returns XML schema name of \a value's type. Used to name elements
+    of lists.
+  */
+static QString xmlTypeName(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+        return QLatin1String("int");
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return QLatin1String("long");
+    case QMetaType::Double:
+        return QLatin1String("double");
+    case QMetaType::Float:
+        return QLatin1String("float");
+    case QMetaType::Bool:
+        return QLatin1String("boolean");
+    case QMetaType::QDateTime:
+        return QLatin1String("dateTime");
+    case QMetaType::QByteArray:
+        return QLatin1String("base64Binary");
+    case QMetaType::QString:
+    case QMetaType::QChar:
+        return QLatin1String("string");
+    default:
+        return QLatin1String("item");
+    }
+}
+
+/*!
+    \internal
+
+    Returns text representation of a simple \a value, as used in XML
+    schema (ISO dates, base64 binary data etc.).
+  */
+static QString xmlValueString(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        return value.toBool() ? QLatin1String("true") : QLatin1String("false");
+    case QMetaType::QDateTime:
+        return value.toDateTime().toString(Qt::ISODate);
+    case QMetaType::QDate:
+        return value.toDate().toString(Qt::ISODate);
+    case QMetaType::QTime:
+        return value.toTime().toString(Qt::ISODate);
+    case QMetaType::QByteArray:
+        return QString::fromLatin1(value.toByteArray().toBase64());
+    default:
+        return value.toString();
+    }
+}
+
+/*!
+    \internal
+
+    Writes \a value as element \a name. Maps become nested elements,
+    lists become sequences of elements named after the type of the item.
+    Text is escaped by \a writer.
+  */
+void QWebMethodPrivate::writeXmlValue(QXmlStreamWriter &writer, const QString &name,
+                                      const QVariant &value)
+{
+    writer.writeStartElement(name);
+
+    if (value.userType() == QMetaType::QVariantMap) {
+        const QVariantMap map = value.toMap();
+        QVariantMap::const_iterator i = map.constBegin();
+        for (; i != map.constEnd(); ++i)
+            writeXmlValue(writer, i.key(), i.value());
+    } else if ((value.userType() == QMetaType::QVariantList)
+               || (value.userType() == QMetaType::QStringList)) {
+        const QVariantList list = value.toList();
+        foreach (const QVariant &item, list)
+            writeXmlValue(writer, xmlTypeName(item), item);
+    } else {
+        writer.writeCharacters(xmlValueString(value));
+    }
+
+    writer.writeEndElement();
+}
+
+/*!
+    \internal
+
+    Serializes request body for \a params straight into \a device,
+    as UTF-8. SOAP envelope is taken from prepareEnvelope(), the rest
+    depends on protocol:
+    \list
+        \o SOAP and XML - parameters are written as (escaped) elements,
+        \o JSON - parameters are written as a JSON object,
+        \o HTTP - parameters are percent-encoded, as in HTML forms.
+    \endlist
+  */
+void QWebMethodPrivate::writeRequestData(QIODevice *device,
+                                         const QMap<QString, QVariant> &params)
+{
+    if ((protocolUsed & QWebMethod::Soap) || (protocolUsed & QWebMethod::Xml)) {
+        const bool soap = (protocolUsed & QWebMethod::Soap);
+        if (soap) {
+            prepareEnvelope();
+            device->write(envelopePrefix);
+        }
+
+        QXmlStreamWriter writer(device);
+        QMap<QString, QVariant>::const_iterator i = params.constBegin();
+        for (; i != params.constEnd(); ++i)
+            writeXmlValue(writer, i.key(), i.value());
+
+        if (soap)
+            device->write(envelopeSuffix);
+    } else if (protocolUsed & QWebMethod::Http) {
+        QMap<QString, QVariant>::const_iterator i = params.constBegin();
+        for (; i != params.constEnd(); ++i) {
+            if (i != params.constBegin())
+                device->write("&", 1);
+            device->write(QUrl::toPercentEncoding(i.key()));
+            device->write("=", 1);
+            device->write(QUrl::toPercentEncoding(xmlValueString(i.value())));
+        }
+    } else if (protocolUsed & QWebMethod::Json) {
+        device->write(QJsonDocument::fromVariant(QVariant(params)).toJson(
+                          QJsonDocument::Compact));
+    }
+}
+
+/*!
+    \internal
+
+    Returns request body for \a params. The buffer is reserved using
+    the size of previous request, so usually it is written without
+    reallocations.
+
+    \sa writeRequestData()
+  */
+QByteArray QWebMethodPrivate::serializeRequest(const QMap<QString, QVariant> &params)
+{
+    QByteArray result;
+    result.reserve(lastRequestSize);
+
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+    writeRequestData(&buffer, params);
+    buffer.close();
+
+    lastRequestSize = result.size();
+    return result;
+}
+
+/*!
+    Private function, invoked by invokeMethod(). Modifies QByteArray data,
+    so that it is consistent with protocol and HTTP method specification.
+    It uses QMap<QString, QVariant> parameters to fill data object's body.
+    Can be overriden by creating custom QByteArray and passing it to
+    sendMessage().
+
+    \sa invokeMethod(), serializeRequest()
+  */
+void QWebMethodPrivate::prepareRequestData()
+{
+    data = serializeRequest(parameters);
+}
+
+/*!
+    \internal
+
+    Converts \a text of an XML element to \a type. Text that cannot be
+    converted is returned as QString.
+  */
+QVariant QWebMethodPrivate::convertXmlText(const QString &text, int type)
+{
+    bool ok = true;
+    QVariant result;
+
+    switch (type) {
+    case QMetaType::Int:
+        result = text.toInt(&ok);
+        break;
+    case QMetaType::UInt:
+        result = text.toUInt(&ok);
+        break;
+    case QMetaType::LongLong:
+        result = text.toLongLong(&ok);
+        break;
+    case QMetaType::ULongLong:
+        result = text.toULongLong(&ok);
+        break;
+    case QMetaType::Double:
+        result = text.toDouble(&ok);
+        break;
+    case QMetaType::Float:
+        result = text.toFloat(&ok);
+        break;
+    case QMetaType::Bool:
+        if ((text == QLatin1String("true")) || (text == QLatin1String("1")))
+            result = true;
+        else if ((text == QLatin1String("false")) || (text == QLatin1String("0")))
+            result = false;
+        else
+            ok = false;
+        break;
+    case QMetaType::QDateTime:
+        result = QDateTime::fromString(text, Qt::ISODate);
+        ok = result.toDateTime().isValid();
+        break;
+    case QMetaType::QChar:
+        ok = (text.length() == 1);
+        if (ok)
+            result = text.at(0);
+        break;
+    default:
+        ok = false;
+    }
+
+    if (!ok)
+        return QVariant(text);
+    return result;
+}
+
+/*!
+    \internal
+
+    Returns the type of array items named \a itemName (like "int"
+    in ArrayOfInt), or QMetaType::QString if it is not known.
+  */
+static int xmlItemType(const QStringRef &itemName)
+{
+    if (itemName == QLatin1String("int"))
+        return QMetaType::Int;
+    else if (itemName == QLatin1String("long"))
+        return QMetaType::LongLong;
+    else if (itemName == QLatin1String("double"))
+        return QMetaType::Double;
+    else if (itemName == QLatin1String("float"))
+        return QMetaType::Float;
+    else if (itemName == QLatin1String("boolean"))
+        return QMetaType::Bool;
+    else if (itemName == QLatin1String("dateTime"))
+        return QMetaType::QDateTime;
+    return QMetaType::QString;
+}
+
+/*!
+    \internal
+
+    Reads the element \a reader is positioned at (up to, and including
+    its end element), and returns its value converted to \a type: lists
+    and string lists become arrays of child elements' values, other
+    elements with child elements become maps, and text is converted
+    with convertXmlText().
+  */
+QVariant QWebMethodPrivate::readXmlValue(QXmlStreamReader &reader, int type)
+{
+    const bool isList = (type == QMetaType::QVariantList)
+            || (type == QMetaType::QStringList);
+    QString text;
+    QVariantList list;
+    QVariantMap map;
+    bool complex = false;
+
+    while (!reader.atEnd()) {
+        QXmlStreamReader::TokenType token = reader.readNext();
+
+        if (token == QXmlStreamReader::Characters) {
+            if (!complex)
+                text += reader.text();
+        } else if (token == QXmlStreamReader::StartElement) {
+            complex = true;
+            if (isList) {
+                int itemType = (type == QMetaType::QStringList) ?
+                            int(QMetaType::QString) : xmlItemType(reader.name());
+                list.append(readXmlValue(reader, itemType));
+            } else {
+                QString name = reader.name().toString();
+                QVariant value = readXmlValue(reader, QMetaType::UnknownType);
+                // Repeated elements are gathered into a list.
+                if (map.contains(name)) {
+                    QVariantList values;
+                    if (map.value(name).userType() == QMetaType::QVariantList)
+                        values = map.value(name).toList();
+                    else
+                        values.append(map.value(name));
+                    values.append(value);
+                    map.insert(name, values);
+                } else {
+                    map.insert(name, value);
+                }
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            break;
+        }
+    }
+
+    if (isList) {
+        if (type == QMetaType::QStringList)
+            return QVariant(QVariant(list).toStringList());
+        return list;
+    } else if (complex) {
+        return map;
+    }
+
+    return convertXmlText(text, type);
+}
+
+/*!
+    \internal
+
+    Decodes SOAP or XML \a replyData against \a returnValue, in a single pass.
+    SOAP Envelope, Header and Body elements are recognised by their
+    namespace, and skipped. SOAP faults and parse errors are reported
+    in \a errorMessage.
+
+    \sa QWebMethod::replyReadParsed()
+  */
+QVariant QWebMethodPrivate::decodeXmlReply(const QByteArray &replyData,
+                                           const QMap<QString, QVariant> &returnValue,
+                                           QString *errorMessage)
+{
+    static const QString soap10Namespace =
+            QLatin1String("http://schemas.xmlsoap.org/soap/envelope/");
+    static const QString soap12Namespace =
+            QLatin1String("http://www.w3.org/2003/05/soap-envelope");
+
+    QXmlStreamReader reader(replyData);
+    QVariant result;
+
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        if ((reader.namespaceUri() == soap10Namespace)
+                || (reader.namespaceUri() == soap12Namespace)) {
+            if (reader.name() == QLatin1String("Header")) {
+                reader.skipCurrentElement();
+            } else if (reader.name() == QLatin1String("Fault")) {
+                result = readXmlValue(reader, QMetaType::UnknownType);
+                QVariantMap fault = result.toMap();
+                QString reason = fault.contains(QLatin1String("faultstring")) ?
+                            fault.value(QLatin1String("faultstring")).toString()
+                          : fault.value(QLatin1String("Reason")).toMap()
+                            .value(QLatin1String("Text")).toString();
+                *errorMessage = QLatin1String("SOAP fault: ") + reason;
+                return result;
+            }
+            continue;
+        }
+
+        // Response element, like "getBandsResponse". Its children are
+        // the return values.
+        QVariantMap values;
+        QString text;
+
+        while (!reader.atEnd()) {
+            QXmlStreamReader::TokenType token = reader.readNext();
+
+            if (token == QXmlStreamReader::StartElement) {
+                QString name = reader.name().toString();
+                values.insert(name, readXmlValue(reader, returnValue.value(name).userType()));
+            } else if ((token == QXmlStreamReader::Characters) && values.isEmpty()) {
+                text += reader.text();
+            } else if (token == QXmlStreamReader::EndElement) {
+                break;
+            }
+        }
+
+        if (values.isEmpty()) {
+            // Plain XML reply, holding just the value.
+            int type = (returnValue.size() == 1) ?
+                        returnValue.constBegin().value().userType() : int(QMetaType::QString);
+            result = convertXmlText(text, type);
+        } else if (values.size() == 1) {
+            result = values.constBegin().value();
+        } else {
+            result = values;
+        }
+        break;
+    }
+
+    if (reader.hasError()) {
+        *errorMessage = QLatin1String("Reply could not be parsed: ") + reader.errorString();
+        return QVariant();
+    }
+
+    return result;
+}
+
+/*!
+    \internal
+
+    Decodes \a replyData of a web method using \a protocol, without
+    touching state of any web method, so that replies of single calls
+    can be decoded, too. Errors are reported in \a errorMessage.
+
+    \sa decodeXmlReply(), QWebMethodCall::result()
+  */
+QVariant QWebMethodPrivate::decodeReply(const QByteArray &replyData, int protocol,
+                                        const QMap<QString, QVariant> &returnValue,
+                                        QString *errorMessage)
+{
+    if ((protocol & QWebMethod::Soap) || (protocol & QWebMethod::Xml))
+        return decodeXmlReply(replyData, returnValue, errorMessage);
+
+    if (protocol & QWebMethod::Json) {
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(replyData, &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            *errorMessage = QLatin1String("Reply could not be parsed: ")
+                    + parseError.errorString();
+            return QVariant();
+        }
+        return document.toVariant();
+    }
+
+    return QString::fromUtf8(replyData);
+}
+
+/*!
+    \internal
+
+    Changes the encoding of the reply, in a rather crude fashion.
+  */
+QString QWebMethodPrivate::convertReplyToUtf(const QString &textToConvert)
+{
+    QString result = textToConvert;
+
+    result.replace(QLatin1String("&lt;"), QLatin1String("<"));
+    result.replace(QLatin1String("&gt;"), QLatin1String(">"));
+
+    return result;
+}
+
+/*!
+    \internal
+
+    Enters into error state with message \a errMessage.
+  */
+bool QWebMethodPrivate::enterErrorState(const QString &errMessage)
+{
+    Q_Q(QWebMethod);
+    errorState = true;
+    errorMessage += QString(errMessage + QLatin1String(" "));
+    emit q->errorEncountered(errMessage);
     return false;
 }
+
+/*!
+    \class QWebRequestGeneratorDevice
+    \internal
+
+    Sequential device that reads request body from
+    a QWebMethod::RequestGenerator, one piece at a time.
+  */
+
+/*!
+    \internal
+
+    Constructs the device around \a requestGenerator. The first piece
+    of data is requested right away.
+  */
+QWebRequestGeneratorDevice::QWebRequestGeneratorDevice(
+        const QWebMethod::RequestGenerator &requestGenerator) :
+    QIODevice(), generator(requestGenerator), position(0), finished(false)
+{
+    fetchChunk();
+}
+
+/*!
+    \internal
+  */
+bool QWebRequestGeneratorDevice::isSequential() const
+{
+    return true;
+}
+
+/*!
+    \internal
+
+    Returns true when generator has no more data, and all of it was read.
+  */
+bool QWebRequestGeneratorDevice::atEnd() const
+{
+    return finished && (position >= chunk.size())
+            && (QIODevice::bytesAvailable() == 0);
+}
+
+/*!
+    \internal
+  */
+qint64 QWebRequestGeneratorDevice::bytesAvailable() const
+{
+    return (chunk.size() - position) + QIODevice::bytesAvailable();
+}
+
+/*!
+    \internal
+
+    Copies up to \a maxSize bytes into \a data, asking the generator
+    for more when current piece is used up.
+  */
+qint64 QWebRequestGeneratorDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 total = 0;
+
+    while ((total < maxSize) && (position < chunk.size())) {
+        qint64 length = qMin<qint64>(maxSize - total, chunk.size() - position);
+        memcpy(data + total, chunk.constData() + position, length);
+        position += length;
+        total += length;
+
+        if (position >= chunk.size())
+            fetchChunk();
+    }
+
+    if ((total == 0) && finished)
+        return -1;
+
+    return total;
+}
+
+/*!
+    \internal
+
+    Device is read-only, always returns -1 (\a data and \a maxSize are
+    not used).
+  */
+qint64 QWebRequestGeneratorDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+/*!
+    \internal
+
+    Replaces current piece of data with the next one.
+  */
+void QWebRequestGeneratorDevice::fetchChunk()
+{
+    position = 0;
+
+    if (finished || !generator) {
+        chunk.clear();
+        finished = true;
+        return;
+    }
+
+    chunk = generator();
+    if (chunk.isEmpty())
+        finished = true;
+}
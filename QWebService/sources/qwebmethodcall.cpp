@@ -0,0 +1,690 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/qwebmethod_p.h"
+
+#include <QtCore/qeventloop.h>
+#include <QtCore/qtimer.h>
+
+/*!
+    \class QWebMethodCall
+    \brief Handle of a single invocation of a web method.
+
+    QWebMethod::invoke() returns a QWebMethodCall for every request it sends.
+    One web method can have many calls in flight at the same time, each of
+    them gets its own reply. When a call is finished,
+    QWebMethod::callFinished() is emitted with the handle.
+
+    QWebMethodCall is explicitly shared - all copies refer to the same call,
+    so a copy taken before the reply arrived will see the reply, too.
+
+    \code
+    QWebMethodCall first = method->invoke();
+    QWebMethodCall second = method->invoke();
+    ...
+    void MyClass::onCallFinished(const QWebMethodCall &call)
+    {
+        if (call == first)
+            ...
+    }
+    \endcode
+
+    Instead of connecting to QWebMethod::callFinished(), results can be
+    consumed with a continuation (then()), or a QFuture (future()).
+    Neither of them creates a QObject per call:
+    \code
+    method->invoke().then([](const QWebMethodCall &call) {
+        if (!call.isErrorState())
+            qDebug() << call.result();
+    });
+
+    QFuture<QWebMethodCall> future = service->invokeFuture("getBands", params);
+    \endcode
+
+    \sa QWebMethod::invoke(), QWebMethod::callFinished()
+  */
+
+/*!
+    \internal
+  */
+QWebMethodCallPrivate::QWebMethodCallPrivate() :
+    id(0), deadline(-1), owner(0), hedged(false), hedgeWon(false),
+    hedgeScheduled(false),
+    fromCache(false),
+    flight(false), coalesced(false),
+    operation(QNetworkAccessManager::PostOperation), scheduled(false), multiplexed(false), ownsRequestDevice(false), requestSize(-1),
+    finished(false), errorState(false), httpStatus(0), http2Used(false),
+    timedOut(false), attempts(1), metrics(0), parser(0), requestCompressed(false),
+    acceptsCompressedReply(false), replyEncodingChecked(false), decompressor(0),
+    protocol(0), resultDecoded(false), promise(0)
+{
+}
+
+/*!
+    \internal
+  */
+QWebMethodCallPrivate::~QWebMethodCallPrivate()
+{
+    delete parser;
+    delete decompressor;
+    if (ownsRequestDevice)
+        delete requestDevice.data();
+
+    // Call was dropped before it finished - futures waiting for it
+    // should not hang.
+    if (promise != 0) {
+        promise->reportCanceled();
+        promise->reportFinished();
+        delete promise;
+    }
+}
+
+/*!
+    \internal
+
+    Clears the reply and status of a failed attempt, before the call
+    is sent again. Request data is kept.
+
+    \sa QWebRetryPolicy
+  */
+void QWebMethodCallPrivate::resetReply()
+{
+    delete parser;
+    parser = 0;
+    delete decompressor;
+    decompressor = 0;
+
+    reply.clear();
+    finished = false;
+    errorState = false;
+    errorMessage.clear();
+    httpStatus = 0;
+    http2Used = false;
+    timedOut = false;
+    replyEncodingChecked = false;
+    result = QVariant();
+    resultDecoded = false;
+}
+
+/*!
+    \internal
+
+    Decodes the reply into result, once. Errors found while decoding
+    (like SOAP faults) put the call in error state.
+
+    \sa QWebMethod::replyReadParsed()
+  */
+void QWebMethodCallPrivate::decodeResult()
+{
+    if (resultDecoded)
+        return;
+
+    resultDecoded = true;
+    if (errorState || reply.isEmpty())
+        return;
+
+    QString error;
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    result = QWebMethodPrivate::decodeReply(reply, protocol, returnValue, &error);
+    timing.parsed = parseTimer.nsecsElapsed() / 1000;
+    if (metrics != 0)
+        QWebMetricsPrivate::phaseFinished(metrics, QWebMetrics::Parse, timing.parsed);
+
+    if (!error.isEmpty()) {
+        errorState = true;
+        errorMessage = error;
+    }
+}
+
+/*!
+    \internal
+
+    Called once \a call (which refers to this data) is finished. Reports
+    the result to the future, if there is one, and runs continuations.
+    Result is decoded here, in the thread of the web method, so that
+    future's consumers in other threads only read it.
+  */
+void QWebMethodCallPrivate::complete(const QWebMethodCall &call)
+{
+    if (promise != 0)
+        decodeResult();
+
+    if (promise != 0) {
+        // Future keeps the call alive from now on, and the call must not
+        // keep the future - or neither of them would be deleted.
+        QFutureInterface<QWebMethodCall> *finishedPromise = promise;
+        promise = 0;
+        finishedPromise->reportResult(call);
+        finishedPromise->reportFinished();
+        delete finishedPromise;
+    }
+
+    QList<QWebMethodCall::Continuation> pending = continuations;
+    continuations.clear();
+    for (int i = 0; i < pending.size(); ++i)
+        pending.at(i)(call);
+}
+
+/*!
+    Constructs an invalid call handle.
+  */
+QWebMethodCall::QWebMethodCall()
+{
+}
+
+/*!
+    \internal
+
+    Constructs the handle around call data (\a dd).
+  */
+QWebMethodCall::QWebMethodCall(QWebMethodCallPrivate *dd) :
+    d(dd)
+{
+}
+
+/*!
+    Constructs a copy of \a other. Both handles refer to the same call.
+  */
+QWebMethodCall::QWebMethodCall(const QWebMethodCall &other) :
+    d(other.d)
+{
+}
+
+/*!
+    Destroys the handle. The call itself is not affected.
+  */
+QWebMethodCall::~QWebMethodCall()
+{
+}
+
+/*!
+    Makes this handle refer to the same call as \a other.
+  */
+QWebMethodCall &QWebMethodCall::operator=(const QWebMethodCall &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+    Returns true if this handle and \a other refer to the same call.
+  */
+bool QWebMethodCall::operator==(const QWebMethodCall &other) const
+{
+    return (d == other.d);
+}
+
+/*!
+    Returns true if this handle and \a other refer to different calls.
+  */
+bool QWebMethodCall::operator!=(const QWebMethodCall &other) const
+{
+    return (d != other.d);
+}
+
+/*!
+    Returns true if the handle refers to a call. Invocations which
+    cannot start a call at all (for example, of a missing method of
+    QWebService) return invalid handles.
+  */
+bool QWebMethodCall::isValid() const
+{
+    return (d.constData() != 0);
+}
+
+/*!
+    Returns an identifier of the call, unique within the process.
+    Invalid handles return 0.
+  */
+quint64 QWebMethodCall::id() const
+{
+    return d ? d->id : 0;
+}
+
+/*!
+    Returns name of the web method that was invoked.
+  */
+QString QWebMethodCall::methodName() const
+{
+    return d ? d->methodName : QString();
+}
+
+/*!
+    Returns true if the reply has been received (or the call failed).
+  */
+bool QWebMethodCall::isFinished() const
+{
+    return d ? d->finished : false;
+}
+
+/*!
+    Returns true if the call has failed. Details can be read
+    with errorInfo().
+
+    \sa errorInfo()
+  */
+bool QWebMethodCall::isErrorState() const
+{
+    return d ? d->errorState : false;
+}
+
+/*!
+    Returns error message, if the call has failed. Otherwise,
+    returns empty string.
+
+    \sa isErrorState()
+  */
+QString QWebMethodCall::errorInfo() const
+{
+    return d ? d->errorMessage : QString();
+}
+
+/*!
+    Returns HTTP status code of the reply, or 0 if it is not
+    known (yet).
+  */
+int QWebMethodCall::httpStatusCode() const
+{
+    return d ? d->httpStatus : 0;
+}
+
+/*!
+    Blocks until the call is finished, or \a msecs milliseconds have passed
+    (negative value means no timeout). Returns true if the call is finished.
+    The call is not aborted on timeout.
+
+    Waits in a local event loop, without using CPU time. Needs to be called
+    from the thread of the web method that was invoked.
+
+    \sa QWebMethod::invokeAndWait()
+  */
+bool QWebMethodCall::waitForFinished(int msecs)
+{
+    if (!d)
+        return false;
+
+    if (d->finished)
+        return true;
+
+    // Calls waiting in QWebScheduler have no network reply yet, so
+    // the loop is quit by a continuation of the call.
+    QEventLoop loop;
+    QPointer<QEventLoop> guard(&loop);
+    then([guard](const QWebMethodCall &) {
+        if (!guard.isNull())
+            guard->quit();
+    });
+
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    if (msecs >= 0)
+        timer.start(msecs);
+
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    return d->finished;
+}
+
+/*!
+    Cancels the call, if it is not finished: aborts its request (or removes
+    it from QWebScheduler's queue), and frees its request and reply data.
+    The call finishes in error state, and QWebMethod::callFinished() is
+    emitted. Needs to be called from the thread of the web method.
+
+    \sa cancelWith(), QWebMethod::cancelPendingCalls()
+  */
+void QWebMethodCall::cancel()
+{
+    if (!d || d->finished || d->method.isNull())
+        return;
+
+    d->method->d_func()->cancelCall(*this);
+}
+
+/*!
+    Sets absolute \a deadline of the call, replacing the default timeout
+    of its web method. If the call is not finished by then, it is aborted,
+    and ends in error state with "Request timed out." message.
+
+    \sa QWebMethod::setTimeout()
+  */
+void QWebMethodCall::setDeadline(const QDateTime &deadline)
+{
+    if (!d || d->finished || d->method.isNull())
+        return;
+
+    QWebMethodPrivate *methodData = d->method->d_func();
+    qint64 remaining = QDateTime::currentDateTime().msecsTo(deadline);
+    methodData->setCallDeadline(*this, methodData->deadlineClock.elapsed() + remaining);
+}
+
+/*!
+    Ties the call to \a owner: if \a owner is destroyed before the call
+    is finished, the call is canceled. Returns this call, so it can be
+    chained with QWebMethod::invoke() and then(). Useful when results
+    are delivered to an object (a view, a QML component) with shorter
+    life than the web method.
+
+    \sa cancel(), QWebMethod::invokeMethodFor()
+  */
+QWebMethodCall QWebMethodCall::cancelWith(QObject *owner) const
+{
+    if (!d || d->finished || d->method.isNull() || (owner == 0))
+        return *this;
+
+    d->owner = owner;
+    QObject::connect(owner, SIGNAL(destroyed(QObject*)),
+                     d->method.data(), SLOT(callOwnerDestroyed(QObject*)),
+                     Qt::UniqueConnection);
+    return *this;
+}
+
+/*!
+    Returns true if the reply was received over HTTP/2.
+
+    \sa QWebMethod::setHttpTransport()
+  */
+bool QWebMethodCall::isHttp2Used() const
+{
+    return d ? d->http2Used : false;
+}
+
+/*!
+    Returns how many times the call was sent: 1, unless it was retried.
+
+    \sa QWebRetryPolicy, QWebMethod::setIdempotent()
+  */
+int QWebMethodCall::attemptCount() const
+{
+    return d ? d->attempts : 0;
+}
+
+/*!
+    Returns true if a hedge (duplicate request) was sent for this call,
+    because its reply was late.
+
+    \sa QWebMethod::setHedgingDelay()
+  */
+bool QWebMethodCall::isHedged() const
+{
+    return d ? d->hedged : false;
+}
+
+/*!
+    Returns true if the reply was taken from result cache of QWebService,
+    and no request was sent.
+
+    \sa QWebService::setCacheTtl()
+  */
+bool QWebMethodCall::isFromCache() const
+{
+    return d ? d->fromCache : false;
+}
+
+/*!
+    Returns timing of the call: how long its phases took, from
+    serializing the request to decoding the reply. Phases are known once
+    they are done - the whole timing, when the call is finished and
+    its result() is decoded.
+
+    \sa QWebCallTiming, QWebMetrics::setSlowCallThreshold()
+  */
+QWebCallTiming QWebMethodCall::timing() const
+{
+    return d ? d->timing : QWebCallTiming();
+}
+
+/*!
+    Returns the request body that was sent (compressed, if request
+    compression was used). Calls that were streamed from a QIODevice
+    return an empty array.
+  */
+QByteArray QWebMethodCall::requestData() const
+{
+    return d ? d->requestData : QByteArray();
+}
+
+/*!
+    Returns the raw data acquired from server. Empty until
+    the call is finished, and for calls parsed incrementally.
+
+    \sa QWebMethod::setIncrementalParsing()
+
+    \sa isFinished()
+  */
+QByteArray QWebMethodCall::replyReadRaw() const
+{
+    return d ? d->reply : QByteArray();
+}
+
+/*!
+    Returns the reply decoded into typed values, the same way
+    QWebMethod::replyReadParsed() does (using return value types of
+    the web method, as they were when the call was made). Returns
+    an invalid QVariant until the call is finished, and for failed calls.
+
+    Reply is decoded once, on first access (or when the call finishes, if
+    it has a future). SOAP faults found while decoding put
+    the call in error state.
+
+    \sa QWebMethod::replyReadParsed()
+  */
+QVariant QWebMethodCall::result() const
+{
+    if (!d || !d->finished)
+        return QVariant();
+
+    d->decodeResult();
+    return d->result;
+}
+
+/*!
+    Adds a \a continuation, which is called with this call once it is
+    finished (right after QWebMethod::callFinished() is emitted), in
+    the thread of the web method. If the call is finished already,
+    \a continuation is called immediately. Returns this call, so
+    continuations can be chained; to continue with another call, invoke
+    it from within the continuation.
+
+    Continuations are kept in the call, no QObject is created for them.
+    Needs to be called from the thread of the web method.
+
+    \sa future()
+  */
+QWebMethodCall QWebMethodCall::then(const Continuation &continuation) const
+{
+    if (!d || !continuation)
+        return *this;
+
+    if (d->finished) {
+        continuation(*this);
+    } else {
+        d->continuations.append(continuation);
+    }
+
+    return *this;
+}
+
+/*!
+    Returns a QFuture, which gets this call as its result when the call is
+    finished (and the reply is decoded, see result()). Futures can be
+    waited for from any thread, watched with QFutureWatcher, combined
+    with QFutureSynchronizer or QtConcurrent, and - with Qt 6 - chained
+    with QFuture::then().
+
+    Reply still arrives through the event loop of the web method's thread,
+    so do not block that thread on the future (use waitForFinished()
+    there). If the call is dropped before it finishes (for example, its
+    web method is deleted), the future is canceled. Invalid calls return
+    a finished future holding the invalid call.
+
+    Needs to be called from the thread of the web method.
+
+    \sa then(), QWebMethod::invokeFuture()
+  */
+QFuture<QWebMethodCall> QWebMethodCall::future() const
+{
+    if (d && !d->finished) {
+        if (d->promise == 0)
+            d->promise = new QFutureInterface<QWebMethodCall>(QFutureInterfaceBase::Started);
+        return d->promise->future();
+    }
+
+    if (d)
+        d->decodeResult();
+
+    QFutureInterface<QWebMethodCall> ready(QFutureInterfaceBase::Started);
+    ready.reportResult(*this);
+    ready.reportFinished();
+    return ready.future();
+}
+
+/*!
+    \class QWebCallTiming
+    \brief Durations of phases of a web method call.
+
+    Timing is taken from the library's own stages (serializing the request,
+    waiting in QWebScheduler's queue, decoding the reply) and from signals
+    of the call's QNetworkReply: encrypted(), metaDataChanged() (headers
+    received), first readyRead() and finished(). All times are in
+    microseconds; phases which did not happen (or have not happened yet)
+    are -1.
+
+    Phases follow each other:
+    \list
+    \o serializeTime() - building the request body,
+    \o retryTime() - earlier attempts of retried calls, and delays
+       between them,
+    \o queueTime() - waiting for a free connection,
+    \o connectTime() - connecting and TLS handshake, known only for
+       new encrypted connections (plain and reused connections do not
+       report it, and it is counted in serverTime()),
+    \o serverTime() - waiting for reply headers,
+    \o downloadTime() - receiving the reply body,
+    \o parseTime() - decoding the reply (QWebMethodCall::result()).
+    \endlist
+
+    Retried calls report phases of their last attempt, everything before
+    it is in retryTime(). Durations are also collected in histograms
+    of QWebMetrics.
+
+    \sa QWebMethodCall::timing(), QWebMetrics::phasePercentile()
+  */
+
+/*!
+    Constructs an empty timing, with all phases unknown.
+  */
+QWebCallTiming::QWebCallTiming() :
+    serialized(-1), queued(-1), dispatched(-1), encrypted(-1), headersReceived(-1),
+    firstByte(-1), finished(-1), parsed(-1)
+{
+}
+
+/*!
+    Returns time spent building the request body.
+  */
+qint64 QWebCallTiming::serializeTime() const
+{
+    return serialized;
+}
+
+/*!
+    Returns time from building the request body to queueing its last
+    attempt: earlier attempts, and delays between them. Calls which were
+    not retried return -1.
+
+    \sa QWebMethodCall::attemptCount()
+  */
+qint64 QWebCallTiming::retryTime() const
+{
+    if ((serialized < 0) || (queued < 0))
+        return -1;
+    return queued - serialized;
+}
+
+/*!
+    Returns time the request waited in QWebScheduler's queue, before
+    it was sent. For retried calls, it is the wait of the last attempt.
+  */
+qint64 QWebCallTiming::queueTime() const
+{
+    qint64 start = (queued < 0) ? serialized : queued;
+    if ((start < 0) || (dispatched < 0))
+        return -1;
+    return dispatched - start;
+}
+
+/*!
+    Returns time spent connecting to the host, and in TLS handshake.
+  */
+qint64 QWebCallTiming::connectTime() const
+{
+    if ((dispatched < 0) || (encrypted < 0))
+        return -1;
+    return encrypted - dispatched;
+}
+
+/*!
+    Returns time from sending the request (or finishing TLS handshake)
+    to receiving reply headers.
+  */
+qint64 QWebCallTiming::serverTime() const
+{
+    if ((dispatched < 0) || (headersReceived < 0))
+        return -1;
+    return headersReceived - ((encrypted < 0) ? dispatched : encrypted);
+}
+
+/*!
+    Returns time from sending the request to receiving the first bytes
+    of reply body.
+  */
+qint64 QWebCallTiming::timeToFirstByte() const
+{
+    if ((dispatched < 0) || (firstByte < 0))
+        return -1;
+    return firstByte - dispatched;
+}
+
+/*!
+    Returns time spent receiving the reply body.
+  */
+qint64 QWebCallTiming::downloadTime() const
+{
+    qint64 start = (firstByte < 0) ? headersReceived : firstByte;
+    if ((start < 0) || (finished < 0))
+        return -1;
+    return finished - start;
+}
+
+/*!
+    Returns time spent decoding the reply.
+  */
+qint64 QWebCallTiming::parseTime() const
+{
+    return parsed;
+}
+
+/*!
+    Returns time from invoking the call to its finish (decoding the reply
+    is not included).
+  */
+qint64 QWebCallTiming::totalTime() const
+{
+    return finished;
+}
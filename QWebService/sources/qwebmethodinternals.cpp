@@ -0,0 +1,65 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/qwebmethodinternals_p.h"
+#include "../headers/qwebmethod_p.h"
+
+/*!
+    \class QWebMethodInternals
+    \internal
+    \brief Exposes serialization and reply decoding steps of QWebMethod
+    to benchmarks, without exporting QWebMethodPrivate.
+  */
+
+/*!
+    Serializes parameters of \a method using \a protocol, and returns the
+    request body. Protocol of \a method is left unchanged.
+  */
+QByteArray QWebMethodInternals::requestData(QWebMethod *method,
+                                            QWebMethod::Protocol protocol)
+{
+    QWebMethodPrivate *d = method->d_func();
+    QWebMethod::Protocol previous = d->protocolUsed;
+
+    d->protocolUsed = protocol;
+    d->prepareRequestData();
+    d->protocolUsed = previous;
+
+    return d->data;
+}
+
+/*!
+    Sets \a reply as the last reply of \a method and drops the cached
+    parsed result, so that next replyReadParsed() decodes it again.
+  */
+void QWebMethodInternals::setReply(QWebMethod *method, const QByteArray &reply)
+{
+    QWebMethodPrivate *d = method->d_func();
+    d->reply = reply;
+    d->parsedReplyCached = false;
+    d->jsonReplyCached = false;
+}
+
+/*!
+    Returns \a text with XML entities converted the way \a method does it
+    for replies.
+  */
+QString QWebMethodInternals::convertReplyToUtf(QWebMethod *method,
+                                               const QString &text)
+{
+    return method->d_func()->convertReplyToUtf(text);
+}
@@ -0,0 +1,653 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "../headers/qwebmetrics_p.h"
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qreadwritelock.h>
+#include <string.h>
+#include <math.h>
+
+/*!
+    \class QWebMetrics
+    \brief Process-wide metrics of web method calls.
+
+    Every call sent by a QWebMethod is recorded, by method name and host
+    (scheme, host name and port): number of calls, calls in flight, errors,
+    request and response bytes, and latency - time from invoking the call
+    to its finish, including time spent in QWebScheduler's queue and
+    retries. Latencies are kept in log-linear histograms (like
+    HdrHistogram), so percentiles are accurate to about 6%, and recording
+    does not allocate.
+
+    Calls answered from QWebService's result cache, and calls coalesced with
+    an identical one (see QWebMethod::setCoalescing()), do not send
+    requests, and are not recorded.
+
+    Recording uses atomic counters only, so it is cheap, and works with
+    web methods living in different threads. Metrics can be read with
+    getters like callCount() and latencyPercentile() (an empty method name
+    or host matches all of them), or exported in OpenMetrics (Prometheus)
+    text format, with toOpenMetrics():
+    \code
+    QWebMetrics::latencyPercentile(99, "getBands"); // In milliseconds.
+    socket->write(QWebMetrics::toOpenMetrics());
+    \endcode
+
+    Phases of calls (see QWebCallTiming) have histograms too, see
+    phasePercentile(). Calls slower than slowCallThreshold() are logged,
+    with their phases, as warnings of "qwebservice.slowcalls" logging
+    category:
+    \code
+    QWebMetrics::setSlowCallThreshold(1000);
+    // qwebservice.slowcalls: Slow call of getBands (https://example.com):
+    //   1520.4 ms - serialize 0.1, queue 802.3, connect 210.5, server 431.0,
+    //   download 76.5 ms
+    \endcode
+
+    Recording can be disabled with setEnabled().
+
+    \sa QWebMethod::pendingCallCount(), QWebScheduler, QWebMethodCall::timing()
+  */
+
+namespace {
+struct QWebMetricsRegistry
+{
+    ~QWebMetricsRegistry() { qDeleteAll(series); }
+
+    QReadWriteLock lock;
+    // Series by method name and host, see seriesKey().
+    QHash<QString, QWebMetricsSeries *> series;
+};
+}
+
+Q_GLOBAL_STATIC(QWebMetricsRegistry, metricsRegistry)
+Q_LOGGING_CATEGORY(slowCallsCategory, "qwebservice.slowcalls")
+
+static QAtomicInt metricsEnabled(1);
+static QAtomicInt slowCallThresholdMsecs(0);
+static const char *const phaseNames[] = {
+    "serialize", "queue", "connect", "server", "download", "parse"
+};
+
+/*!
+    \internal
+
+    Returns a key identifying series of \a methodName and \a host.
+  */
+static QString seriesKey(const QString &methodName, const QString &host)
+{
+    return methodName + QLatin1Char('\n') + host;
+}
+
+/*!
+    \internal
+
+    Returns series of \a methodName and \a host (all of them, if empty),
+    sorted by method name and host.
+  */
+static QList<QWebMetricsSeries *> matchingSeries(const QString &methodName,
+                                                 const QString &host)
+{
+    QMap<QString, QWebMetricsSeries *> sorted;
+    QWebMetricsRegistry *registry = metricsRegistry();
+    QReadLocker locker(&registry->lock);
+    foreach (QWebMetricsSeries *series, registry->series) {
+        if ((!methodName.isEmpty() && (series->methodName != methodName))
+                || (!host.isEmpty() && (series->host != host)))
+            continue;
+        sorted.insert(seriesKey(series->methodName, series->host), series);
+    }
+    return sorted.values();
+}
+
+/*!
+    Returns true if calls are recorded. Default is true.
+
+    \sa setEnabled()
+  */
+bool QWebMetrics::isEnabled()
+{
+    return (metricsEnabled.loadAcquire() != 0);
+}
+
+/*!
+    Enables (when \a enabled is true) or disables recording of calls
+    sent after this point.
+  */
+void QWebMetrics::setEnabled(bool enabled)
+{
+    metricsEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+/*!
+    Returns names of recorded web methods.
+  */
+QStringList QWebMetrics::methodNames()
+{
+    QStringList result;
+    foreach (QWebMetricsSeries *series, matchingSeries(QString(), QString())) {
+        if (!result.contains(series->methodName))
+            result.append(series->methodName);
+    }
+    return result;
+}
+
+/*!
+    Returns hosts of recorded web methods.
+  */
+QStringList QWebMetrics::hosts()
+{
+    QStringList result;
+    foreach (QWebMetricsSeries *series, matchingSeries(QString(), QString())) {
+        if (!result.contains(series->host))
+            result.append(series->host);
+    }
+    result.sort();
+    return result;
+}
+
+/*!
+    Returns number of calls of \a methodName sent to \a host (empty strings
+    match all methods, or hosts).
+  */
+quint64 QWebMetrics::callCount(const QString &methodName, const QString &host)
+{
+    quint64 result = 0;
+    foreach (QWebMetricsSeries *series, matchingSeries(methodName, host))
+        result += series->calls;
+    return result;
+}
+
+/*!
+    Returns number of calls of \a methodName to \a host, which are not
+    finished yet (waiting in a queue, or for a reply).
+
+    \sa callCount()
+  */
+int QWebMetrics::inFlightCount(const QString &methodName, const QString &host)
+{
+    int result = 0;
+    foreach (QWebMetricsSeries *series, matchingSeries(methodName, host))
+        result += series->inFlight;
+    return result;
+}
+
+/*!
+    Returns number of calls of \a methodName to \a host, which finished
+    in error state (network and HTTP errors, timeouts, cancellation).
+
+    \sa callCount()
+  */
+quint64 QWebMetrics::errorCount(const QString &methodName, const QString &host)
+{
+    quint64 result = 0;
+    foreach (QWebMetricsSeries *series, matchingSeries(methodName, host))
+        result += series->errors;
+    return result;
+}
+
+/*!
+    Returns number of request bytes of calls of \a methodName to \a host,
+    as they were sent (compressed, if request compression was used).
+
+    \sa responseBytes()
+  */
+qint64 QWebMetrics::requestBytes(const QString &methodName, const QString &host)
+{
+    qint64 result = 0;
+    foreach (QWebMetricsSeries *series, matchingSeries(methodName, host))
+        result += series->requestBytes;
+    return result;
+}
+
+/*!
+    Returns number of reply bytes of calls of \a methodName to \a host,
+    after decompression.
+
+    \sa requestBytes()
+  */
+qint64 QWebMetrics::responseBytes(const QString &methodName, const QString &host)
+{
+    qint64 result = 0;
+    foreach (QWebMetricsSeries *series, matchingSeries(methodName, host))
+        result += series->responseBytes;
+    return result;
+}
+
+/*!
+    Returns latency of calls of \a methodName to \a host at \a percentile
+    (between 0 and 100, for example 99.9), in milliseconds. Returns 0
+    if no call has finished yet.
+  */
+double QWebMetrics::latencyPercentile(double percentile, const QString &methodName,
+                                      const QString &host)
+{
+    quint64 counts[QWebHistogram::BucketCount];
+    memset(counts, 0, sizeof(counts));
+    foreach (QWebMetricsSeries *series, matchingSeries(methodName, host))
+        series->latency.addTo(counts);
+    return QWebHistogram::percentile(counts, percentile) / 1000.0;
+}
+
+/*!
+    Returns duration of \a phase of calls of \a methodName to \a host at
+    \a percentile (between 0 and 100), in milliseconds. Returns 0
+    if the phase has not been recorded yet.
+
+    \sa QWebCallTiming
+  */
+double QWebMetrics::phasePercentile(Phase phase, double percentile,
+                                    const QString &methodName, const QString &host)
+{
+    quint64 counts[QWebHistogram::BucketCount];
+    memset(counts, 0, sizeof(counts));
+    foreach (QWebMetricsSeries *series, matchingSeries(methodName, host))
+        series->phases[phase].addTo(counts);
+    return QWebHistogram::percentile(counts, percentile) / 1000.0;
+}
+
+/*!
+    Returns the time (in milliseconds) from which calls are logged
+    as slow, or 0 if they are not logged.
+
+    \sa setSlowCallThreshold()
+  */
+int QWebMetrics::slowCallThreshold()
+{
+    return slowCallThresholdMsecs.loadAcquire();
+}
+
+/*!
+    Sets the time (\a msecs milliseconds), from which finished calls are
+    logged as slow, with durations of their phases. 0 (default) disables
+    the log. Slow calls are logged even if recording of metrics
+    is disabled.
+  */
+void QWebMetrics::setSlowCallThreshold(int msecs)
+{
+    slowCallThresholdMsecs.storeRelease(qMax(msecs, 0));
+}
+
+/*!
+    \internal
+
+    Returns \a value escaped for use as OpenMetrics label value.
+  */
+static QByteArray labelValue(const QString &value)
+{
+    QByteArray result = value.toUtf8();
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    result.replace('\n', "\\n");
+    return result;
+}
+
+/*!
+    \internal
+
+    Appends to \a result samples of summary \a name with \a labels
+    (ending with a closing brace), made of \a histogram.
+  */
+static void appendSummary(QByteArray &result, const QByteArray &name,
+                          const QByteArray &labels, const QWebHistogram &histogram)
+{
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    quint64 counts[QWebHistogram::BucketCount];
+    memset(counts, 0, sizeof(counts));
+    histogram.addTo(counts);
+
+    QByteArray openLabels = labels;
+    openLabels.chop(1);
+    for (unsigned int i = 0; i < (sizeof(quantiles) / sizeof(quantiles[0])); i++) {
+        qint64 usecs = QWebHistogram::percentile(counts, quantiles[i] * 100);
+        result += name + openLabels + ",quantile=\"" + QByteArray::number(quantiles[i])
+                + "\"} " + QByteArray::number(usecs / 1000000.0, 'f', 6) + '\n';
+    }
+    result += name + "_sum" + labels + ' '
+            + QByteArray::number(qint64(histogram.sum) / 1000000.0, 'f', 6) + '\n';
+    result += name + "_count" + labels + ' '
+            + QByteArray::number(quint64(histogram.count)) + '\n';
+}
+
+/*!
+    Returns all metrics in OpenMetrics text format, which can be served
+    to Prometheus (or other monitoring system) as it is. Latencies
+    (and phases of calls) are exported as summaries, with 0.5, 0.9, 0.99
+    and 0.999 quantiles, in seconds.
+  */
+QByteArray QWebMetrics::toOpenMetrics()
+{
+    QList<QWebMetricsSeries *> allSeries = matchingSeries(QString(), QString());
+    QList<QByteArray> labels;
+    foreach (QWebMetricsSeries *series, allSeries) {
+        labels.append("{method=\"" + labelValue(series->methodName)
+                      + "\",host=\"" + labelValue(series->host) + "\"}");
+    }
+
+    QByteArray result;
+    result += "# TYPE qwebservice_calls counter\n"
+              "# HELP qwebservice_calls Calls sent by web methods.\n";
+    for (int i = 0; i < allSeries.size(); i++) {
+        result += "qwebservice_calls_total" + labels.at(i) + ' '
+                + QByteArray::number(quint64(allSeries.at(i)->calls)) + '\n';
+    }
+
+    result += "# TYPE qwebservice_calls_in_flight gauge\n"
+              "# HELP qwebservice_calls_in_flight Calls waiting for a reply.\n";
+    for (int i = 0; i < allSeries.size(); i++) {
+        result += "qwebservice_calls_in_flight" + labels.at(i) + ' '
+                + QByteArray::number(int(allSeries.at(i)->inFlight)) + '\n';
+    }
+
+    result += "# TYPE qwebservice_call_errors counter\n"
+              "# HELP qwebservice_call_errors Calls finished in error state.\n";
+    for (int i = 0; i < allSeries.size(); i++) {
+        result += "qwebservice_call_errors_total" + labels.at(i) + ' '
+                + QByteArray::number(quint64(allSeries.at(i)->errors)) + '\n';
+    }
+
+    result += "# TYPE qwebservice_request_bytes counter\n"
+              "# UNIT qwebservice_request_bytes bytes\n"
+              "# HELP qwebservice_request_bytes Request bytes sent.\n";
+    for (int i = 0; i < allSeries.size(); i++) {
+        result += "qwebservice_request_bytes_total" + labels.at(i) + ' '
+                + QByteArray::number(qint64(allSeries.at(i)->requestBytes)) + '\n';
+    }
+
+    result += "# TYPE qwebservice_response_bytes counter\n"
+              "# UNIT qwebservice_response_bytes bytes\n"
+              "# HELP qwebservice_response_bytes Reply bytes received.\n";
+    for (int i = 0; i < allSeries.size(); i++) {
+        result += "qwebservice_response_bytes_total" + labels.at(i) + ' '
+                + QByteArray::number(qint64(allSeries.at(i)->responseBytes)) + '\n';
+    }
+
+    result += "# TYPE qwebservice_call_duration_seconds summary\n"
+              "# UNIT qwebservice_call_duration_seconds seconds\n"
+              "# HELP qwebservice_call_duration_seconds Time from invoking a call to its finish.\n";
+    for (int i = 0; i < allSeries.size(); i++) {
+        appendSummary(result, "qwebservice_call_duration_seconds", labels.at(i),
+                      allSeries.at(i)->latency);
+    }
+
+    result += "# TYPE qwebservice_call_phase_duration_seconds summary\n"
+              "# UNIT qwebservice_call_phase_duration_seconds seconds\n"
+              "# HELP qwebservice_call_phase_duration_seconds Duration of phases of calls.\n";
+    for (int i = 0; i < allSeries.size(); i++) {
+        for (int phase = Serialize; phase <= Parse; phase++) {
+            QByteArray label = labels.at(i);
+            label.chop(1);
+            label += ",phase=\"" + QByteArray(phaseNames[phase]) + "\"}";
+            appendSummary(result, "qwebservice_call_phase_duration_seconds", label,
+                          allSeries.at(i)->phases[phase]);
+        }
+    }
+
+    result += "# EOF\n";
+    return result;
+}
+
+/*!
+    Resets all counters and histograms to 0. Calls in flight stay
+    counted, as they have not finished yet.
+  */
+void QWebMetrics::reset()
+{
+    foreach (QWebMetricsSeries *series, matchingSeries(QString(), QString())) {
+        series->calls.storeRelease(0);
+        series->errors.storeRelease(0);
+        series->requestBytes.storeRelease(0);
+        series->responseBytes.storeRelease(0);
+        series->latency.reset();
+        for (int phase = Serialize; phase <= Parse; phase++)
+            series->phases[phase].reset();
+    }
+}
+
+/*!
+    \internal
+
+    Returns series of \a methodName, called at host of \a url. Series
+    are created on first use, and live as long as the process.
+  */
+QWebMetricsSeries *QWebMetricsPrivate::series(const QString &methodName, const QUrl &url)
+{
+    QString host = hostName(url);
+    QString key = seriesKey(methodName, host);
+    QWebMetricsRegistry *registry = metricsRegistry();
+
+    {
+        QReadLocker locker(&registry->lock);
+        QWebMetricsSeries *series = registry->series.value(key);
+        if (series != 0)
+            return series;
+    }
+
+    QWriteLocker locker(&registry->lock);
+    QWebMetricsSeries *&series = registry->series[key];
+    if (series == 0) {
+        series = new QWebMetricsSeries;
+        series->methodName = methodName;
+        series->host = host;
+    }
+    return series;
+}
+
+/*!
+    \internal
+
+    Returns host of \a url, as used in metrics: scheme, host name
+    and port (if specified).
+  */
+QString QWebMetricsPrivate::hostName(const QUrl &url)
+{
+    QString result = url.scheme() + QLatin1String("://") + url.host();
+    if (url.port() != -1)
+        result += QLatin1Char(':') + QString::number(url.port());
+    return result;
+}
+
+/*!
+    \internal
+
+    Records start of a call in \a series, with request of
+    \a requestBytes bytes.
+  */
+void QWebMetricsPrivate::callStarted(QWebMetricsSeries *series, qint64 requestBytes)
+{
+    series->calls.fetchAndAddRelaxed(1);
+    series->inFlight.fetchAndAddRelaxed(1);
+    if (requestBytes > 0)
+        series->requestBytes.fetchAndAddRelaxed(requestBytes);
+}
+
+/*!
+    \internal
+
+    Records finish of a call in \a series, which took \a usecs
+    microseconds, and got \a responseBytes bytes of reply. If
+    \a error is true, the call is counted as failed.
+  */
+void QWebMetricsPrivate::callFinished(QWebMetricsSeries *series, qint64 usecs,
+                                      qint64 responseBytes, bool error)
+{
+    series->inFlight.fetchAndAddRelaxed(-1);
+    if (error)
+        series->errors.fetchAndAddRelaxed(1);
+    if (responseBytes > 0)
+        series->responseBytes.fetchAndAddRelaxed(responseBytes);
+    series->latency.record(usecs);
+}
+
+/*!
+    \internal
+
+    Records \a usecs of \a phase in \a series.
+  */
+void QWebMetricsPrivate::phaseFinished(QWebMetricsSeries *series, QWebMetrics::Phase phase,
+                                       qint64 usecs)
+{
+    if (usecs >= 0)
+        series->phases[phase].record(usecs);
+}
+
+/*!
+    \internal
+
+    Records phases of a finished call, with \a timing, in \a series.
+    Parse phase is recorded when the reply is decoded.
+  */
+void QWebMetricsPrivate::timingFinished(QWebMetricsSeries *series, const QWebCallTiming &timing)
+{
+    phaseFinished(series, QWebMetrics::Serialize, timing.serializeTime());
+    phaseFinished(series, QWebMetrics::Queue, timing.queueTime());
+    phaseFinished(series, QWebMetrics::Connect, timing.connectTime());
+    phaseFinished(series, QWebMetrics::Server, timing.serverTime());
+    phaseFinished(series, QWebMetrics::Download, timing.downloadTime());
+}
+
+/*!
+    \internal
+
+    Returns \a usecs as milliseconds, for the slow call log.
+  */
+static QString logTime(qint64 usecs)
+{
+    return (usecs < 0) ? QString(QLatin1String("-"))
+                       : QString::number(usecs / 1000.0, 'f', 1);
+}
+
+/*!
+    \internal
+
+    Logs call of \a methodName to host of \a url as slow, with
+    durations of phases from \a timing.
+  */
+void QWebMetricsPrivate::logSlowCall(const QString &methodName, const QUrl &url,
+                                     const QWebCallTiming &timing)
+{
+    qCWarning(slowCallsCategory, "Slow call of %s (%s): %s ms - serialize %s, retry %s, "
+              "queue %s, connect %s, server %s, download %s ms",
+              qPrintable(methodName), qPrintable(hostName(url)),
+              qPrintable(logTime(timing.totalTime())),
+              qPrintable(logTime(timing.serializeTime())),
+              qPrintable(logTime(timing.retryTime())),
+              qPrintable(logTime(timing.queueTime())),
+              qPrintable(logTime(timing.connectTime())),
+              qPrintable(logTime(timing.serverTime())),
+              qPrintable(logTime(timing.downloadTime())));
+}
+
+/*!
+    \internal
+
+    Returns index of the bucket holding \a usecs. Values below 16 have
+    their own buckets, bigger ones share them with values equal in
+    5 most significant bits.
+  */
+int QWebHistogram::bucketIndex(qint64 usecs)
+{
+    if (usecs < SubBuckets)
+        return (usecs < 0) ? 0 : int(usecs);
+
+    usecs = qMin(usecs, (qint64(1) << MaxExponent) - 1);
+    int exponent = 63 - qCountLeadingZeroBits(quint64(usecs));
+    return (exponent - 4) * SubBuckets + int(usecs >> (exponent - 4));
+}
+
+/*!
+    \internal
+
+    Returns the value (middle of the range) represented by bucket
+    with \a index.
+  */
+qint64 QWebHistogram::bucketValue(int index)
+{
+    if (index < SubBuckets)
+        return index;
+
+    int shift = index / SubBuckets - 1;
+    qint64 lower = qint64(SubBuckets + index % SubBuckets) << shift;
+    return lower + ((qint64(1) << shift) / 2);
+}
+
+/*!
+    \internal
+
+    Records \a usecs.
+  */
+void QWebHistogram::record(qint64 usecs)
+{
+    buckets[bucketIndex(usecs)].fetchAndAddRelaxed(1);
+    count.fetchAndAddRelaxed(1);
+    sum.fetchAndAddRelaxed(qMax(usecs, qint64(0)));
+}
+
+/*!
+    \internal
+
+    Removes all recorded values.
+  */
+void QWebHistogram::reset()
+{
+    for (int i = 0; i < BucketCount; i++)
+        buckets[i].storeRelease(0);
+    count.storeRelease(0);
+    sum.storeRelease(0);
+}
+
+/*!
+    \internal
+
+    Adds counts of buckets to \a counts (which has BucketCount items),
+    so that histograms can be merged.
+  */
+void QWebHistogram::addTo(quint64 *counts) const
+{
+    for (int i = 0; i < BucketCount; i++)
+        counts[i] += buckets[i];
+}
+
+/*!
+    \internal
+
+    Returns value at \a percentile (0 - 100) of histogram with bucket
+    \a counts, or 0 if it is empty.
+  */
+qint64 QWebHistogram::percentile(const quint64 *counts, double percentile)
+{
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; i++)
+        total += counts[i];
+    if (total == 0)
+        return 0;
+
+    quint64 rank = quint64(ceil(qBound(0.0, percentile, 100.0) / 100.0 * total));
+    if (rank == 0)
+        rank = 1;
+
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; i++) {
+        seen += counts[i];
+        if (seen >= rank)
+            return bucketValue(i);
+    }
+    return bucketValue(BucketCount - 1);
+}
@@ -0,0 +1,356 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/qwebnetworkpool.h"
+
+#include <QtCore/qthread.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qtimer.h>
+
+/*!
+    \class QWebNetworkPool
+    \brief Per-thread, reference counted pool of QNetworkAccessManagers.
+
+    QNetworkAccessManager keeps its own connection cache, so every manager
+    means a separate set of TCP connections. QWebNetworkPool hands out one
+    manager per thread, and keeps it alive as long as somebody is using it.
+    This way all web methods living in the same thread (for example, all
+    methods created by QWsdl for a big web service) share one connection
+    pool, and keep-alive connections are reused between operations
+    on the same host.
+
+    QWebMethod, QWebServiceMethod and QWsdl use the pool by default.
+    If a web method needs an isolated manager (different proxy, cookie jar,
+    credentials cache etc.), use QWebMethod::setNetworkManagerShared().
+
+    A few counters are available to check how the pool is doing:
+    requestCount() and knownHostRequestCount(). The latter counts requests
+    to a host (scheme, host name and port) already contacted through the same
+    manager. Such requests may be served from a cached keep-alive
+    connection, but that is not guaranteed (the connection may have been
+    closed meanwhile), so it is an upper bound of connection reuse.
+
+    Managers are bound to the thread that acquired them. When the thread
+    finishes, its manager is detached from it: methods still holding it
+    keep it until they release it, but new threads (even one created at
+    the same address) get a manager of their own.
+
+    For HTTP/2 (see QWebMethod::setHttpTransport()), QNetworkAccessManager
+    multiplexes all requests to a host over a single connection.
+    http2StreamCount(), http2ConnectionCount() and streamsPerConnection()
+    show how many requests shared each connection.
+  */
+
+namespace {
+struct QWebNetworkPoolEntry
+{
+    QWebNetworkPoolEntry() : thread(0), references(0) {}
+
+    // Thread the manager is handed out to, or 0 once the thread finished.
+    QThread *thread;
+    int references;
+    QSet<QString> knownHosts;
+};
+
+typedef QHash<QNetworkAccessManager *, QWebNetworkPoolEntry> QWebNetworkPoolHash;
+}
+
+Q_GLOBAL_STATIC(QMutex, poolMutex)
+Q_GLOBAL_STATIC(QWebNetworkPoolHash, poolEntries)
+
+static quint64 poolRequestCount = 0;
+static quint64 poolKnownHostRequestCount = 0;
+static quint64 poolHttp2StreamCount = 0;
+Q_GLOBAL_STATIC(QSet<QString>, poolHttp2Connections)
+
+/*!
+    \internal
+
+    Returns a key identifying connections to host of \a url.
+  */
+static QString hostKey(const QUrl &url)
+{
+    return url.scheme() + QLatin1String("://") + url.host()
+            + QLatin1Char(':') + QString::number(url.port());
+}
+
+/*!
+    \internal
+
+    Finds the pool entry of a manager handed out to \a thread. Needs to be
+    called with the pool mutex locked.
+  */
+static QWebNetworkPoolHash::iterator findThreadEntry(QThread *thread)
+{
+    QWebNetworkPoolHash::iterator i = poolEntries()->begin();
+    for (; i != poolEntries()->end(); ++i) {
+        if (i.value().thread == thread)
+            break;
+    }
+    return i;
+}
+
+/*!
+    \internal
+
+    Detaches the manager of \a thread, which is finished (or destroyed),
+    so that it is not handed out again.
+  */
+static void detachThread(QThread *thread)
+{
+    QMutexLocker locker(poolMutex());
+    QWebNetworkPoolHash::iterator i = findThreadEntry(thread);
+    if (i != poolEntries()->end())
+        i.value().thread = 0;
+}
+
+/*!
+    Returns the shared network manager for current thread, creating it
+    if needed, and increases its reference count. Each call needs to be
+    matched by a call to release().
+
+    \sa release()
+  */
+QNetworkAccessManager *QWebNetworkPool::acquire()
+{
+    QThread *thread = QThread::currentThread();
+    QMutexLocker locker(poolMutex());
+    QWebNetworkPoolHash::iterator i = findThreadEntry(thread);
+
+    if (i == poolEntries()->end()) {
+        QNetworkAccessManager *manager = new QNetworkAccessManager;
+        i = poolEntries()->insert(manager, QWebNetworkPoolEntry());
+        i.value().thread = thread;
+
+        // Connections are dropped with the manager.
+        QObject::connect(thread, &QThread::finished, manager,
+                         [thread]() { detachThread(thread); }, Qt::DirectConnection);
+        QObject::connect(thread, &QObject::destroyed, manager,
+                         [thread]() { detachThread(thread); }, Qt::DirectConnection);
+    }
+
+    ++i.value().references;
+    return i.key();
+}
+
+/*!
+    Decreases reference count of a shared \a manager. When it drops to zero,
+    the manager is deleted. Managers that were not created by the pool
+    are deleted right away.
+
+    \sa acquire()
+  */
+void QWebNetworkPool::release(QNetworkAccessManager *manager)
+{
+    if (manager == 0)
+        return;
+
+    {
+        QMutexLocker locker(poolMutex());
+        QWebNetworkPoolHash::iterator i = poolEntries()->find(manager);
+
+        if (i != poolEntries()->end()) {
+            if (--i.value().references > 0)
+                return;
+            poolEntries()->erase(i);
+        }
+    }
+
+    if (manager->thread() == QThread::currentThread())
+        delete manager;
+    else
+        manager->deleteLater();
+}
+
+/*!
+    Returns true if \a manager is owned by the pool.
+  */
+bool QWebNetworkPool::isShared(QNetworkAccessManager *manager)
+{
+    QMutexLocker locker(poolMutex());
+    return poolEntries()->contains(manager);
+}
+
+/*!
+    Updates request counters with a request to \a url, sent through
+    \a manager. Called by QWebMethod each time a request is issued.
+
+    \sa requestCount(), knownHostRequestCount()
+  */
+void QWebNetworkPool::registerRequest(QNetworkAccessManager *manager, const QUrl &url)
+{
+    QMutexLocker locker(poolMutex());
+    ++poolRequestCount;
+
+    QWebNetworkPoolHash::iterator i = poolEntries()->find(manager);
+    if (i == poolEntries()->end())
+        return;
+
+    QString key = hostKey(url);
+
+    if (i.value().knownHosts.contains(key))
+        ++poolKnownHostRequestCount;
+    else
+        i.value().knownHosts.insert(key);
+}
+
+/*!
+    Counts a reply to \a url, received over HTTP/2 through \a manager.
+    Called by QWebMethod each time such a reply is finished. Connection
+    is identified by the manager and host, as QNetworkAccessManager keeps
+    one HTTP/2 connection per host.
+
+    \sa http2StreamCount(), http2ConnectionCount()
+  */
+void QWebNetworkPool::registerHttp2Stream(QNetworkAccessManager *manager, const QUrl &url)
+{
+    QMutexLocker locker(poolMutex());
+    ++poolHttp2StreamCount;
+    poolHttp2Connections()->insert(QString::number(quintptr(manager), 16)
+                                   + QLatin1Char('/') + hostKey(url));
+}
+
+/*!
+    Blocks until \a reply is finished, or \a msecs milliseconds have passed
+    (negative value means no timeout). Returns true if the reply is finished
+    (or has been deleted).
+
+    Waiting is done in a local event loop, which sleeps until network
+    data arrives, so no CPU time is used while waiting. Events of current
+    thread, except user input, are still processed. Needs to be called from
+    the thread \a reply lives in.
+  */
+bool QWebNetworkPool::waitForFinished(QNetworkReply *reply, int msecs)
+{
+    QPointer<QNetworkReply> guard(reply);
+    if (guard.isNull() || guard->isFinished())
+        return true;
+
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
+    QObject::connect(reply, SIGNAL(destroyed()), &loop, SLOT(quit()));
+    QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+
+    if (msecs >= 0)
+        timer.start(msecs);
+
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    return (guard.isNull() || guard->isFinished());
+}
+
+/*!
+    Returns the number of shared managers currently alive (one per thread
+    that uses the pool, plus managers of finished threads, which are still
+    referenced).
+  */
+int QWebNetworkPool::managerCount()
+{
+    QMutexLocker locker(poolMutex());
+    return poolEntries()->size();
+}
+
+/*!
+    Returns the reference count of current thread's shared manager, or 0
+    if it has not been created.
+  */
+int QWebNetworkPool::referenceCount()
+{
+    QMutexLocker locker(poolMutex());
+    QWebNetworkPoolHash::iterator i = findThreadEntry(QThread::currentThread());
+    return (i != poolEntries()->end()) ? i.value().references : 0;
+}
+
+/*!
+    Returns the number of requests issued through all managers
+    (shared and isolated) since start, or last resetCounters().
+
+    \sa knownHostRequestCount(), resetCounters()
+  */
+quint64 QWebNetworkPool::requestCount()
+{
+    QMutexLocker locker(poolMutex());
+    return poolRequestCount;
+}
+
+/*!
+    Returns the number of requests issued through shared managers to a host
+    that was already contacted by the same manager. These requests could
+    reuse a kept-alive connection, but whether they actually did is not
+    known, so do not report this as the number of reused connections.
+
+    \sa requestCount(), resetCounters()
+  */
+quint64 QWebNetworkPool::knownHostRequestCount()
+{
+    QMutexLocker locker(poolMutex());
+    return poolKnownHostRequestCount;
+}
+
+/*!
+    Returns the number of requests that were sent as HTTP/2 streams.
+
+    \sa http2ConnectionCount(), streamsPerConnection()
+  */
+quint64 QWebNetworkPool::http2StreamCount()
+{
+    QMutexLocker locker(poolMutex());
+    return poolHttp2StreamCount;
+}
+
+/*!
+    Returns the number of HTTP/2 connections used (one for each manager
+    and host pair).
+
+    \sa http2StreamCount(), streamsPerConnection()
+  */
+int QWebNetworkPool::http2ConnectionCount()
+{
+    QMutexLocker locker(poolMutex());
+    return poolHttp2Connections()->size();
+}
+
+/*!
+    Returns average number of HTTP/2 streams per connection, or 0
+    if HTTP/2 was not used.
+
+    \sa http2StreamCount(), http2ConnectionCount()
+  */
+double QWebNetworkPool::streamsPerConnection()
+{
+    QMutexLocker locker(poolMutex());
+    if (poolHttp2Connections()->isEmpty())
+        return 0.0;
+    return double(poolHttp2StreamCount) / poolHttp2Connections()->size();
+}
+
+/*!
+    Zeroes the request counters.
+  */
+void QWebNetworkPool::resetCounters()
+{
+    QMutexLocker locker(poolMutex());
+    poolRequestCount = 0;
+    poolKnownHostRequestCount = 0;
+    poolHttp2StreamCount = 0;
+    poolHttp2Connections()->clear();
+}
@@ -0,0 +1,472 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/qwebreplyparser_p.h"
+
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsonarray.h>
+
+/*!
+    \class QWebReplyParser
+    \internal
+    \brief Incremental parser of web service replies.
+
+    Reply data is added piece by piece with addData(), as it arrives from
+    the network. readNext() returns true each time a complete item has been
+    read, its name and value are then available with name() and value().
+    Data that was already parsed is dropped, so memory use does not depend
+    on the size of the reply.
+
+    For XML (and SOAP), an item is an element that has no child elements:
+    name() is its local name, value() is its text. For JSON, an item is
+    each value of the top-level array (name() is empty), or each member of
+    the top-level object.
+
+    \code
+    QWebReplyParser parser(QWebReplyParser::Json);
+    parser.addData(reply->readAll());
+    while (parser.readNext())
+        qDebug() << parser.name() << parser.value();
+    \endcode
+  */
+
+/*!
+    Constructs a parser expecting replies in given \a format.
+  */
+QWebReplyParser::QWebReplyParser(Format format) :
+    m_format(format), finished(false), error(false), leaf(false),
+    scanPosition(0), itemStart(0), depth(0), inString(false),
+    escaped(false), topLevelObject(false), containerStarted(false)
+{
+}
+
+/*!
+    Returns the format of parsed data.
+  */
+QWebReplyParser::Format QWebReplyParser::format() const
+{
+    return m_format;
+}
+
+/*!
+    Appends \a data to the parser's input.
+  */
+void QWebReplyParser::addData(const QByteArray &data)
+{
+    if (m_format == Xml)
+        xml.addData(data);
+    else
+        buffer.append(data);
+}
+
+/*!
+    Tells the parser that the whole reply has been added. Incomplete
+    items left in the input are reported as an error by the next
+    call to readNext().
+  */
+void QWebReplyParser::finish()
+{
+    finished = true;
+}
+
+/*!
+    Reads the next complete item. Returns false when more data is needed,
+    or an error occured.
+
+    \sa name(), value(), hasError()
+  */
+bool QWebReplyParser::readNext()
+{
+    if (error)
+        return false;
+
+    if (m_format == Xml)
+        return readNextXml();
+    else
+        return readNextJson();
+}
+
+/*!
+    Returns name of the last item read.
+  */
+QString QWebReplyParser::name() const
+{
+    return m_name;
+}
+
+/*!
+    Returns value of the last item read.
+  */
+QVariant QWebReplyParser::value() const
+{
+    return m_value;
+}
+
+/*!
+    Returns true if the reply is not well-formed.
+  */
+bool QWebReplyParser::hasError() const
+{
+    return error;
+}
+
+/*!
+    Returns the error message, or empty string if there was no error.
+  */
+QString QWebReplyParser::errorString() const
+{
+    return m_errorString;
+}
+
+/*!
+    \internal
+  */
+bool QWebReplyParser::readNextXml()
+{
+    forever {
+        QXmlStreamReader::TokenType token = xml.readNext();
+
+        if (token == QXmlStreamReader::Invalid) {
+            if (xml.error() != QXmlStreamReader::PrematureEndOfDocumentError) {
+                error = true;
+                m_errorString = xml.errorString();
+            } else if (finished && !elementStack.isEmpty()) {
+                error = true;
+                m_errorString = QLatin1String("Reply ended prematurely.");
+            }
+            return false;
+        } else if (token == QXmlStreamReader::EndDocument) {
+            return false;
+        } else if (token == QXmlStreamReader::StartElement) {
+            elementStack.append(xml.name().toString());
+            text.clear();
+            leaf = true;
+        } else if (token == QXmlStreamReader::Characters) {
+            if (leaf)
+                text += xml.text();
+        } else if (token == QXmlStreamReader::EndElement) {
+            bool wasLeaf = leaf;
+            leaf = false;
+            QString elementName = elementStack.takeLast();
+
+            if (wasLeaf) {
+                m_name = elementName;
+                m_value = text;
+                text.clear();
+                return true;
+            }
+        }
+    }
+}
+
+/*!
+    \internal
+
+    Scans the buffer for the end of current top-level item. Only nesting
+    depth and strings are tracked here, items themselves are parsed
+    by QJsonDocument.
+  */
+bool QWebReplyParser::readNextJson()
+{
+    while (scanPosition < buffer.size()) {
+        char c = buffer.at(scanPosition++);
+
+        if (inString) {
+            if (escaped)
+                escaped = false;
+            else if (c == '\\')
+                escaped = true;
+            else if (c == '"')
+                inString = false;
+            continue;
+        }
+
+        if (c == '"') {
+            inString = true;
+        } else if ((c == '{') || (c == '[')) {
+            if (depth == 0) {
+                topLevelObject = (c == '{');
+                containerStarted = true;
+                itemStart = scanPosition;
+            }
+            ++depth;
+        } else if ((c == '}') || (c == ']')) {
+            if (--depth < 0) {
+                error = true;
+                m_errorString = QLatin1String("Unexpected closing bracket in reply.");
+                return false;
+            }
+
+            if ((depth == 0) && takeJsonItem(scanPosition - 1))
+                return true;
+        } else if ((c == ',') && (depth == 1)) {
+            if (takeJsonItem(scanPosition - 1))
+                return true;
+        }
+
+        if (error)
+            return false;
+    }
+
+    // Parsed data is no longer needed.
+    if (containerStarted && (itemStart > 0)) {
+        int parsed = qMin(itemStart, buffer.size());
+        buffer.remove(0, parsed);
+        scanPosition -= parsed;
+        itemStart = 0;
+    }
+
+    if (finished) {
+        if ((depth != 0) || inString) {
+            error = true;
+            m_errorString = QLatin1String("Reply ended prematurely.");
+        } else if (!containerStarted && !buffer.trimmed().isEmpty()) {
+            // Scalar reply, like "42".
+            containerStarted = true;
+            topLevelObject = false;
+            itemStart = 0;
+            return takeJsonItem(buffer.size());
+        }
+    }
+
+    return false;
+}
+
+/*!
+    \internal
+
+    Parses the item between last item start and \a end. Returns true
+    if a value has been read.
+  */
+bool QWebReplyParser::takeJsonItem(int end)
+{
+    QByteArray item = buffer.mid(itemStart, end - itemStart).trimmed();
+    itemStart = end + 1;
+
+    if (item.isEmpty())
+        return false;
+
+    QJsonParseError parseError;
+
+    if (topLevelObject) {
+        QJsonDocument document = QJsonDocument::fromJson('{' + item + '}', &parseError);
+        QJsonObject object = document.object();
+        if (parseError.error == QJsonParseError::NoError && !object.isEmpty()) {
+            QJsonObject::const_iterator member = object.constBegin();
+            m_name = member.key();
+            m_value = member.value().toVariant();
+            return true;
+        }
+    } else {
+        QJsonDocument document = QJsonDocument::fromJson('[' + item + ']', &parseError);
+        if (parseError.error == QJsonParseError::NoError && !document.array().isEmpty()) {
+            m_name.clear();
+            m_value = document.array().first().toVariant();
+            return true;
+        }
+    }
+
+    error = true;
+    m_errorString = parseError.errorString();
+    return false;
+}
+
+/*!
+    Splits JSON \a pointer (RFC 6901, like "/bands/0/name") into
+    unescaped reference tokens. \a valid is set to false if the pointer
+    is not empty, and does not start with a slash.
+  */
+QStringList QWebReplyParser::jsonPointerTokens(const QString &pointer, bool *valid)
+{
+    QStringList tokens;
+    bool isValid = pointer.isEmpty() || pointer.startsWith(QLatin1Char('/'));
+
+    if (isValid && !pointer.isEmpty()) {
+        tokens = pointer.mid(1).split(QLatin1Char('/'));
+        for (int i = 0; i < tokens.size(); ++i) {
+            tokens[i].replace(QLatin1String("~1"), QLatin1String("/"));
+            tokens[i].replace(QLatin1String("~0"), QLatin1String("~"));
+        }
+    }
+
+    if (valid != 0)
+        *valid = isValid;
+    return tokens;
+}
+
+/*!
+    \internal
+
+    Returns position of first non-whitespace character in \a json,
+    starting from \a position.
+  */
+static int skipJsonWhitespace(const QByteArray &json, int position)
+{
+    while ((position < json.size())
+           && ((json.at(position) == ' ') || (json.at(position) == '\t')
+               || (json.at(position) == '\r') || (json.at(position) == '\n'))) {
+        ++position;
+    }
+    return position;
+}
+
+/*!
+    \internal
+
+    Returns position right after the JSON value starting at \a position,
+    or -1 if the value is not complete. Value is not parsed, only nesting
+    and strings are tracked.
+  */
+static int skipJsonValue(const QByteArray &json, int position)
+{
+    int depth = 0;
+    bool inString = false;
+
+    for (; position < json.size(); ++position) {
+        char c = json.at(position);
+
+        if (inString) {
+            if (c == '\\')
+                ++position;
+            else if (c == '"')
+                inString = false;
+
+            if (!inString && (depth == 0))
+                return position + 1;
+            continue;
+        }
+
+        if (c == '"') {
+            inString = true;
+        } else if ((c == '{') || (c == '[')) {
+            ++depth;
+        } else if ((c == '}') || (c == ']')) {
+            if (--depth == 0)
+                return position + 1;
+            if (depth < 0)
+                return position;
+        } else if ((depth == 0) && ((c == ',') || (c == ' ') || (c == '\t')
+                                    || (c == '\r') || (c == '\n'))) {
+            return position;
+        }
+    }
+
+    return ((depth == 0) && !inString) ? position : -1;
+}
+
+/*!
+    Finds the value pointed to by JSON \a pointer in \a json text, and
+    returns its (unparsed) text, or an empty array if there is no such
+    value. Only the keys on the way to the value are decoded, the rest
+    of the document is skipped without being parsed.
+
+    \sa jsonPointerTokens()
+  */
+QByteArray QWebReplyParser::jsonPointerSlice(const QByteArray &json, const QString &pointer)
+{
+    bool valid = false;
+    const QStringList tokens = jsonPointerTokens(pointer, &valid);
+    if (!valid)
+        return QByteArray();
+
+    int position = skipJsonWhitespace(json, 0);
+
+    foreach (const QString &token, tokens) {
+        if (position >= json.size())
+            return QByteArray();
+
+        bool found = false;
+
+        if (json.at(position) == '{') {
+            // Like QJsonDocument, the last of duplicated keys wins, so
+            // the whole object has to be scanned.
+            int match = -1;
+            position = skipJsonWhitespace(json, position + 1);
+
+            while ((position < json.size()) && (json.at(position) == '"')) {
+                int keyEnd = skipJsonValue(json, position);
+                if (keyEnd < 0)
+                    return QByteArray();
+
+                QByteArray rawKey = json.mid(position, keyEnd - position);
+                QString key;
+                if (rawKey.contains('\\')) {
+                    QJsonParseError parseError;
+                    QJsonArray keyArray = QJsonDocument::fromJson('[' + rawKey + ']',
+                                                                  &parseError).array();
+                    if ((parseError.error != QJsonParseError::NoError)
+                            || keyArray.isEmpty()) {
+                        return QByteArray();
+                    }
+                    key = keyArray.first().toString();
+                } else {
+                    key = QString::fromUtf8(rawKey.constData() + 1, rawKey.size() - 2);
+                }
+
+                position = skipJsonWhitespace(json, keyEnd);
+                if ((position >= json.size()) || (json.at(position) != ':'))
+                    return QByteArray();
+                position = skipJsonWhitespace(json, position + 1);
+
+                if (key == token)
+                    match = position;
+
+                position = skipJsonValue(json, position);
+                if (position < 0)
+                    return QByteArray();
+                position = skipJsonWhitespace(json, position);
+                if ((position < json.size()) && (json.at(position) == ','))
+                    position = skipJsonWhitespace(json, position + 1);
+            }
+
+            if (match >= 0) {
+                position = match;
+                found = true;
+            }
+        } else if (json.at(position) == '[') {
+            bool isIndex = false;
+            int index = token.toInt(&isIndex);
+            if (!isIndex || (index < 0))
+                return QByteArray();
+
+            position = skipJsonWhitespace(json, position + 1);
+
+            for (int i = 0; (position < json.size()) && (json.at(position) != ']'); ++i) {
+                if (i == index) {
+                    found = true;
+                    break;
+                }
+
+                position = skipJsonValue(json, position);
+                if (position < 0)
+                    return QByteArray();
+                position = skipJsonWhitespace(json, position);
+                if ((position < json.size()) && (json.at(position) == ','))
+                    position = skipJsonWhitespace(json, position + 1);
+            }
+        }
+
+        if (!found)
+            return QByteArray();
+    }
+
+    int end = skipJsonValue(json, position);
+    if (end < 0)
+        return QByteArray();
+    return json.mid(position, end - position);
+}
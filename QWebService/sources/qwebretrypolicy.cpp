@@ -0,0 +1,254 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "../headers/qwebretrypolicy.h"
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QtCore/qrandom.h>
+#else
+#include <QtCore/qdatetime.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadstorage.h>
+
+/*
+  qrand() is seeded per thread, and starts with the same sequence in
+  every thread (and process) that did not call qsrand(). Marks threads,
+  which have already seeded it.
+  */
+Q_GLOBAL_STATIC(QThreadStorage<bool>, retrySeeded)
+#endif
+
+/*!
+    \class QWebRetryPolicy
+    \brief Describes when, and how often, failed calls are sent again.
+
+    Calls of web methods marked as idempotent (QWebMethod::setIdempotent())
+    are sent again, when they fail with a transient error: a network
+    error (connection refused or reset, network timeout etc.), one of
+    retryableHttpStatuses(), or a SOAP fault with one of
+    retryableFaultCodes(). Other web methods are never retried, as sending
+    them twice could do the work twice.
+
+    Each call is sent at most maxAttempts() times. Before n-th retry,
+    the call waits a random time between 0 and
+    baseDelay() * 2^(n - 1) milliseconds, but not more than maxDelay()
+    (exponential backoff with full jitter). Randomness spreads retries
+    of many clients over time, so that they do not hit a recovering
+    server all at once.
+
+    Retries reuse the request body serialized for the first attempt,
+    parameters are not serialized again. Calls streamed from a QIODevice
+    are not retried.
+
+    \code
+    QWebRetryPolicy policy(5, 100);
+    policy.setRetryableFaultCodes(QStringList() << "Receiver" << "Server" << "Busy");
+    method->setRetryPolicy(policy);
+    method->setIdempotent(true);
+    \endcode
+
+    \sa QWebMethod::setRetryPolicy(), QWebMethodCall::attemptCount()
+  */
+
+/*!
+    Constructs a retry policy, which sends a call at most \a maxAttempts
+    times, waiting up to \a baseDelay milliseconds before first retry
+    (doubled for every next one, up to \a maxDelay).
+
+    HTTP statuses 408, 429, 500, 502, 503 and 504 are retryable by default,
+    along with SOAP fault codes Server (SOAP 1.0) and Receiver (SOAP 1.2).
+  */
+QWebRetryPolicy::QWebRetryPolicy(int maxAttempts, int baseDelay, int maxDelay) :
+    m_maxAttempts(qMax(1, maxAttempts)), m_baseDelay(qMax(0, baseDelay)),
+    m_maxDelay(qMax(0, maxDelay))
+{
+    m_statuses << 408 << 429 << 500 << 502 << 503 << 504;
+    m_faultCodes << QLatin1String("Server") << QLatin1String("Receiver");
+}
+
+/*!
+    Returns maximum number of times a call is sent (first attempt
+    included). 1 means calls are not retried.
+
+    \sa setMaxAttempts()
+  */
+int QWebRetryPolicy::maxAttempts() const
+{
+    return m_maxAttempts;
+}
+
+/*!
+    Sets maximum number of times a call is sent to \a attempts.
+
+    \sa maxAttempts()
+  */
+void QWebRetryPolicy::setMaxAttempts(int attempts)
+{
+    m_maxAttempts = qMax(1, attempts);
+}
+
+/*!
+    Returns upper bound of the delay before first retry, in milliseconds.
+
+    \sa setBaseDelay(), delay()
+  */
+int QWebRetryPolicy::baseDelay() const
+{
+    return m_baseDelay;
+}
+
+/*!
+    Sets upper bound of the delay before first retry to \a msecs.
+
+    \sa baseDelay()
+  */
+void QWebRetryPolicy::setBaseDelay(int msecs)
+{
+    m_baseDelay = qMax(0, msecs);
+}
+
+/*!
+    Returns maximum delay before any retry, in milliseconds.
+
+    \sa setMaxDelay(), delay()
+  */
+int QWebRetryPolicy::maxDelay() const
+{
+    return m_maxDelay;
+}
+
+/*!
+    Sets maximum delay before any retry to \a msecs.
+
+    \sa maxDelay()
+  */
+void QWebRetryPolicy::setMaxDelay(int msecs)
+{
+    m_maxDelay = qMax(0, msecs);
+}
+
+/*!
+    Returns HTTP status codes, for which calls are retried.
+
+    \sa setRetryableHttpStatuses()
+  */
+QList<int> QWebRetryPolicy::retryableHttpStatuses() const
+{
+    return m_statuses;
+}
+
+/*!
+    Sets HTTP status codes, for which calls are retried, to \a statuses.
+    SOAP faults are judged by their fault code, not by HTTP status.
+
+    \sa retryableHttpStatuses(), setRetryableFaultCodes()
+  */
+void QWebRetryPolicy::setRetryableHttpStatuses(const QList<int> &statuses)
+{
+    m_statuses = statuses;
+}
+
+/*!
+    Returns SOAP fault codes (without namespace prefix), for which calls
+    are retried.
+
+    \sa setRetryableFaultCodes()
+  */
+QStringList QWebRetryPolicy::retryableFaultCodes() const
+{
+    return m_faultCodes;
+}
+
+/*!
+    Sets SOAP fault codes, for which calls are retried, to \a codes.
+    Codes are compared without namespace prefix, so "Server" matches
+    "soap:Server".
+
+    \sa retryableFaultCodes()
+  */
+void QWebRetryPolicy::setRetryableFaultCodes(const QStringList &codes)
+{
+    m_faultCodes = codes;
+}
+
+/*!
+    Returns true if calls failing with HTTP \a status should be retried.
+  */
+bool QWebRetryPolicy::isRetryableHttpStatus(int status) const
+{
+    return m_statuses.contains(status);
+}
+
+/*!
+    Returns true if calls failing with SOAP fault \a code should be retried.
+    Namespace prefix of \a code is ignored.
+  */
+bool QWebRetryPolicy::isRetryableFaultCode(const QString &code) const
+{
+    QString localCode = code.mid(code.lastIndexOf(QLatin1Char(':')) + 1).trimmed();
+    return m_faultCodes.contains(localCode);
+}
+
+/*!
+    Returns true if calls failing with network \a error (one not caused
+    by HTTP status of the reply) should be retried. Transient connection
+    problems are retryable. Aborted requests, and errors which would repeat
+    (like unknown host or protocol), are not.
+  */
+bool QWebRetryPolicy::isRetryableNetworkError(QNetworkReply::NetworkError error) const
+{
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*!
+    Returns a random delay, in milliseconds, to wait before retry number
+    \a attempt (counting from 1).
+
+    \sa baseDelay(), maxDelay()
+  */
+int QWebRetryPolicy::delay(int attempt) const
+{
+    qint64 ceiling = m_baseDelay;
+    for (int i = 1; (i < attempt) && (ceiling < m_maxDelay); ++i)
+        ceiling *= 2;
+    ceiling = qMin(ceiling, qint64(m_maxDelay));
+
+    if (ceiling <= 0)
+        return 0;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    return int(QRandomGenerator::global()->bounded(quint32(ceiling) + 1));
+#else
+    if (!retrySeeded()->hasLocalData()) {
+        qsrand(uint(QTime::currentTime().msec())
+               ^ uint(quintptr(QThread::currentThreadId())));
+        retrySeeded()->setLocalData(true);
+    }
+    return int(qint64(qrand()) % (ceiling + 1));
+#endif
+}
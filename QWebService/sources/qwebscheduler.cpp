@@ -0,0 +1,399 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService library.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/qwebscheduler.h"
+
+#include <QtCore/qthread.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qelapsedtimer.h>
+
+/*!
+    \class QWebScheduler
+    \brief Per-host request scheduler, with priority lanes.
+
+    QWebMethod does not send requests right away, it passes them to
+    the scheduler. At most maxConnectionsPerHost() requests to one host
+    (scheme, host name and port) are running at a time, per thread - which
+    matches the connection pool of QWebNetworkPool's shared manager.
+    Requests above the cap wait in a queue, and are sent when running ones
+    finish. HTTP/2 requests are multiplexed over one connection, so they
+    are capped separately, by maxStreamsPerHost().
+
+    There are two lanes: Interactive (default) and Bulk, chosen by
+    QWebMethod::setPriority(). Interactive requests are always sent first.
+    Bulk requests never take the last free connection to a host, so an
+    interactive call does not wait behind a long bulk export. Within a lane,
+    requests are sent in FIFO order.
+
+    Counters show how the queues behave: queueDepth() and maxQueueDepth(),
+    queuedCount() (requests that had to wait), dispatchedCount(),
+    and wait times - totalWaitTime(), maxWaitTime() and averageWaitTime(),
+    in milliseconds.
+
+    \sa QWebMethod::setPriority(), QWebNetworkPool
+  */
+
+namespace {
+struct QWebSchedulerEntry
+{
+    quint64 ticket;
+    QElapsedTimer queuedSince;
+    QWebScheduler::Dispatcher dispatcher;
+};
+
+struct QWebSchedulerHost
+{
+    QWebSchedulerHost() : running(0), multiplexed(false) {}
+
+    int running;
+    bool multiplexed;
+    QQueue<QWebSchedulerEntry> lanes[2];
+};
+
+struct QWebSchedulerCounters
+{
+    QWebSchedulerCounters() : depth(0), maxDepth(0), dispatched(0), queued(0),
+        totalWait(0), maxWait(0) {}
+
+    int depth;
+    int maxDepth;
+    quint64 dispatched;
+    quint64 queued;
+    qint64 totalWait;
+    qint64 maxWait;
+};
+
+typedef QHash<QThread *, QHash<QString, QWebSchedulerHost> > QWebSchedulerHash;
+}
+
+Q_GLOBAL_STATIC(QMutex, schedulerMutex)
+Q_GLOBAL_STATIC(QWebSchedulerHash, schedulerHosts)
+
+static int schedulerMaxConnections = 6;
+static int schedulerMaxStreams = 100;
+static QWebSchedulerCounters schedulerCounters[2];
+
+/*!
+    \internal
+
+    Returns a key identifying connections to host of \a url
+    (\a multiplexed ones, if true).
+  */
+static QString hostKey(const QUrl &url, bool multiplexed)
+{
+    return (multiplexed ? QLatin1String("h2+") : QLatin1String(""))
+            + url.scheme() + QLatin1String("://") + url.host()
+            + QLatin1Char(':') + QString::number(url.port());
+}
+
+/*!
+    \internal
+
+    Returns scheduler state of host of \a url, in current thread. Needs
+    to be called with the scheduler mutex locked.
+  */
+static QWebSchedulerHost &hostState(const QUrl &url, bool multiplexed)
+{
+    QWebSchedulerHost &host = (*schedulerHosts())[QThread::currentThread()]
+            [hostKey(url, multiplexed)];
+    host.multiplexed = multiplexed;
+    return host;
+}
+
+/*!
+    \internal
+
+    Returns true if a request from \a lane can be sent to \a host now.
+    Needs to be called with the scheduler mutex locked.
+  */
+static bool canRun(const QWebSchedulerHost &host, QWebScheduler::Lane lane)
+{
+    int limit = host.multiplexed ? schedulerMaxStreams : schedulerMaxConnections;
+    if (lane == QWebScheduler::Interactive)
+        return (host.running < limit);
+
+    int bulkLimit = (limit > 1) ? (limit - 1) : 1;
+    return (host.lanes[QWebScheduler::Interactive].isEmpty() && (host.running < bulkLimit));
+}
+
+/*!
+    \internal
+
+    Takes the next request, which can be sent to \a host, from its queues
+    into \a entry, and counts it as running. Returns false if there is none.
+    Needs to be called with the scheduler mutex locked.
+  */
+static bool takeNext(QWebSchedulerHost &host, QWebSchedulerEntry *entry)
+{
+    for (int lane = QWebScheduler::Interactive; lane <= QWebScheduler::Bulk; ++lane) {
+        if (host.lanes[lane].isEmpty() || !canRun(host, QWebScheduler::Lane(lane)))
+            continue;
+
+        *entry = host.lanes[lane].dequeue();
+        ++host.running;
+
+        QWebSchedulerCounters &counters = schedulerCounters[lane];
+        qint64 wait = entry->queuedSince.elapsed();
+        --counters.depth;
+        ++counters.dispatched;
+        counters.totalWait += wait;
+        counters.maxWait = qMax(counters.maxWait, wait);
+        return true;
+    }
+
+    return false;
+}
+
+/*!
+    \internal
+
+    Sends queued requests to host of \a url, as long as there is room.
+    Dispatchers are called with the mutex unlocked, as they send requests
+    (and may schedule new ones). A dispatcher returning false did not send
+    anything, so its connection is freed right away.
+  */
+static void dispatchQueued(const QUrl &url, bool multiplexed)
+{
+    forever {
+        QWebSchedulerEntry entry;
+        {
+            QMutexLocker locker(schedulerMutex());
+            if (!takeNext(hostState(url, multiplexed), &entry))
+                return;
+        }
+
+        if (!entry.dispatcher()) {
+            QMutexLocker locker(schedulerMutex());
+            --hostState(url, multiplexed).running;
+        }
+    }
+}
+
+/*!
+    Schedules a request to \a url in \a lane. \a dispatcher is called
+    (in current thread) when the request can be sent - right away, if there
+    is a free connection and nobody is waiting - and returns true if it sent
+    the request. Sent requests need to be matched by a call to release(),
+    when they are finished. \a ticket identifies the request for cancel().
+    \a multiplexed requests (HTTP/2) are capped by maxStreamsPerHost().
+
+    Called by QWebMethod for every call.
+  */
+void QWebScheduler::schedule(const QUrl &url, Lane lane, quint64 ticket,
+                             const Dispatcher &dispatcher, bool multiplexed)
+{
+    {
+        QMutexLocker locker(schedulerMutex());
+        QWebSchedulerHost &host = hostState(url, multiplexed);
+
+        // Requests which cannot be sent at once count as queued.
+        QWebSchedulerCounters &counters = schedulerCounters[lane];
+        if (!canRun(host, lane) || !host.lanes[lane].isEmpty())
+            ++counters.queued;
+
+        QWebSchedulerEntry entry;
+        entry.ticket = ticket;
+        entry.dispatcher = dispatcher;
+        entry.queuedSince.start();
+        host.lanes[lane].enqueue(entry);
+
+        ++counters.depth;
+        counters.maxDepth = qMax(counters.maxDepth, counters.depth);
+    }
+
+    dispatchQueued(url, multiplexed);
+}
+
+/*!
+    Frees the connection used by a finished request to \a url (sent
+    as \a multiplexed, if true), and sends next queued requests.
+  */
+void QWebScheduler::release(const QUrl &url, bool multiplexed)
+{
+    {
+        QMutexLocker locker(schedulerMutex());
+        QWebSchedulerHost &host = hostState(url, multiplexed);
+        if (host.running > 0)
+            --host.running;
+    }
+
+    dispatchQueued(url, multiplexed);
+}
+
+/*!
+    Removes request with \a ticket, to \a url (scheduled as \a multiplexed,
+    if true), from the queue. Returns false if it is not queued (it has been
+    sent already).
+  */
+bool QWebScheduler::cancel(const QUrl &url, quint64 ticket, bool multiplexed)
+{
+    QMutexLocker locker(schedulerMutex());
+    QWebSchedulerHost &host = hostState(url, multiplexed);
+
+    for (int lane = Interactive; lane <= Bulk; ++lane) {
+        QQueue<QWebSchedulerEntry> &queue = host.lanes[lane];
+        for (int i = 0; i < queue.size(); ++i) {
+            if (queue.at(i).ticket == ticket) {
+                queue.removeAt(i);
+                --schedulerCounters[lane].depth;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*!
+    Returns maximum number of requests to one host, running at the same
+    time (per thread). Default is 6, like in QNetworkAccessManager.
+  */
+int QWebScheduler::maxConnectionsPerHost()
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerMaxConnections;
+}
+
+/*!
+    Sets maximum number of requests to one host, running at the same time,
+    to \a connections.
+
+    \sa setMaxStreamsPerHost()
+  */
+void QWebScheduler::setMaxConnectionsPerHost(int connections)
+{
+    QMutexLocker locker(schedulerMutex());
+    schedulerMaxConnections = qMax(1, connections);
+}
+
+/*!
+    Returns maximum number of HTTP/2 requests to one host, running at
+    the same time (per thread). Default is 100, the usual limit of
+    concurrent streams of HTTP/2 servers.
+  */
+int QWebScheduler::maxStreamsPerHost()
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerMaxStreams;
+}
+
+/*!
+    Sets maximum number of HTTP/2 requests to one host, running at the same
+    time, to \a streams.
+  */
+void QWebScheduler::setMaxStreamsPerHost(int streams)
+{
+    QMutexLocker locker(schedulerMutex());
+    schedulerMaxStreams = qMax(1, streams);
+}
+
+/*!
+    Returns number of requests to host of \a url (\a multiplexed ones,
+    if true), which are running in current thread.
+  */
+int QWebScheduler::runningCount(const QUrl &url, bool multiplexed)
+{
+    QMutexLocker locker(schedulerMutex());
+    return hostState(url, multiplexed).running;
+}
+
+/*!
+    Returns number of requests currently waiting in \a lane (all hosts
+    and threads).
+  */
+int QWebScheduler::queueDepth(Lane lane)
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerCounters[lane].depth;
+}
+
+/*!
+    Returns the highest queueDepth() of \a lane seen.
+  */
+int QWebScheduler::maxQueueDepth(Lane lane)
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerCounters[lane].maxDepth;
+}
+
+/*!
+    Returns number of requests from \a lane that were sent.
+  */
+quint64 QWebScheduler::dispatchedCount(Lane lane)
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerCounters[lane].dispatched;
+}
+
+/*!
+    Returns number of requests from \a lane that could not be sent right
+    away, and had to wait in the queue.
+  */
+quint64 QWebScheduler::queuedCount(Lane lane)
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerCounters[lane].queued;
+}
+
+/*!
+    Returns total time (in milliseconds) requests from \a lane spent
+    in the queue.
+  */
+qint64 QWebScheduler::totalWaitTime(Lane lane)
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerCounters[lane].totalWait;
+}
+
+/*!
+    Returns the longest time (in milliseconds) a request from \a lane spent
+    in the queue.
+  */
+qint64 QWebScheduler::maxWaitTime(Lane lane)
+{
+    QMutexLocker locker(schedulerMutex());
+    return schedulerCounters[lane].maxWait;
+}
+
+/*!
+    Returns average time (in milliseconds) requests from \a lane spent
+    in the queue, or 0 if none was sent.
+  */
+double QWebScheduler::averageWaitTime(Lane lane)
+{
+    QMutexLocker locker(schedulerMutex());
+    if (schedulerCounters[lane].dispatched == 0)
+        return 0.0;
+    return double(schedulerCounters[lane].totalWait) / schedulerCounters[lane].dispatched;
+}
+
+/*!
+    Zeroes the counters. Queue depths are kept, as requests are still
+    waiting.
+  */
+void QWebScheduler::resetCounters()
+{
+    QMutexLocker locker(schedulerMutex());
+    for (int lane = Interactive; lane <= Bulk; ++lane) {
+        int depth = schedulerCounters[lane].depth;
+        schedulerCounters[lane] = QWebSchedulerCounters();
+        schedulerCounters[lane].depth = depth;
+        schedulerCounters[lane].maxDepth = depth;
+    }
+}
@@ -15,7 +15,10 @@
 **
 ****************************************************************************/
 
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qpointer.h>
 #include "../headers/qwebservice_p.h"
+#include "../headers/qwebmethod_p.h"
 
 /*!
     \class QWebService
@@ -43,6 +46,11 @@
 
     For convenience, QWebService::invokeMethod() and QWebService::replyRead() can also be used.
 
+    Replies of methods which are invoked through QWebService can be cached,
+    see setCacheTtl(). Calls answered from the cache are not sent to the
+    server, but are otherwise just like the others: replyReady() is emitted
+    when control returns to the event loop.
+
     When any of the web methods in QwebService receives a reply, replyReady() signal
     is emitted. It sends reply data and web method name, so that the sender can be easily
     determined.
@@ -84,6 +92,7 @@ QWebService::QWebService(QObject *parent)
     : QObject(parent), d_ptr(new QWebServicePrivate)
 {
     Q_D(QWebService);
+    d->q_ptr = this;
     d->wsdl = new QWsdl(this);
     d->methods = new QMap<QString, QWebMethod *>();
     d->init();
@@ -101,6 +110,7 @@ QWebService::QWebService(QWsdl *_wsdl, QObject *parent)
     : QObject(parent), d_ptr(new QWebServicePrivate)
 {
     Q_D(QWebService);
+    d->q_ptr = this;
     d->methods = new QMap<QString, QWebMethod *>();
     setWsdl(_wsdl);
     d->init();
@@ -119,6 +129,7 @@ QWebService::QWebService(const QString &_hostname, QObject *parent)
     : QObject(parent), d_ptr(new QWebServicePrivate)
 {
     Q_D(QWebService);
+    d->q_ptr = this;
     d->m_hostUrl.setUrl(_hostname);
     d->methods = new QMap<QString, QWebMethod *>();
     setWsdl(new QWsdl(_hostname, this));
@@ -138,6 +149,7 @@ QWebService::QWebService(QWebServicePrivate &dd, QObject *parent) :
     QObject(parent), d_ptr(&dd)
 {
     Q_D(QWebService);
+    d->q_ptr = this;
     d->wsdl = new QWsdl(this);
     d->methods = new QMap<QString, QWebMethod *>();
     d->init();
@@ -309,6 +321,7 @@ void QWebService::addMethod(QWebMethod *newMethod)
 {
     Q_D(QWebService);
     d->methods->insert(newMethod->methodName(), newMethod);
+    d->configureMethod(newMethod);
     connect(newMethod, SIGNAL(replyReady(QByteArray)),
             this, SLOT(receiveReply(QByteArray)));
     emit methodNamesChanged();
@@ -327,6 +340,7 @@ void QWebService::addMethod(const QString &methodName, QWebMethod *newMethod)
 {
     Q_D(QWebService);
     d->methods->insert(methodName, newMethod);
+    d->configureMethod(newMethod);
     connect(newMethod, SIGNAL(replyReady(QByteArray)),
             this, SLOT(receiveReply(QByteArray)));
     emit methodNamesChanged();
@@ -357,11 +371,69 @@ void QWebService::removeMethod(const QString &methodName)
     \code
     QWebService::method("methodName")->invokeMethod(data);
     \endcode
+
+    except that the reply can be taken from the cache, see setCacheTtl().
   */
 bool QWebService::invokeMethod(const QString &methodName, const QByteArray &data)
 {
     Q_D(QWebService);
-    return d->methods->value(methodName)->invokeMethod(data);
+    return d->invokeCached(methodName, data).isValid();
+}
+
+/*!
+    Invokes a web method, specified by given \a methodName, with
+    parameters \a params (if not empty, they replace parameters
+    of the method - request is serialized right away, so calls with
+    different parameters can be in flight at once). Returns handle of
+    the call, or an invalid handle if there is no such method. Errors
+    of sending finish the call. The reply can be taken from the cache,
+    see setCacheTtl().
+
+    \sa QWebMethod::invoke(), invokeFuture()
+  */
+QWebMethodCall QWebService::invoke(const QString &methodName,
+                                   const QMap<QString, QVariant> &params)
+{
+    Q_D(QWebService);
+    QWebMethod *method = d->methods->value(methodName);
+    if (method == 0)
+        return QWebMethodCall();
+
+    if (!params.isEmpty())
+        method->setParameters(params);
+
+    return d->invokeCached(methodName, QByteArray());
+}
+
+/*!
+    Invokes a web method, like invoke(), with \a methodName and \a params,
+    and returns a QFuture of the call. Unlike replyReady(), the future
+    refers to this very call, so there is no need to find out which method
+    sent the reply. Invalid method names give a finished future holding
+    an invalid call.
+
+    \sa QWebMethod::invokeFuture(), QWebMethodCall::result()
+  */
+QFuture<QWebMethodCall> QWebService::invokeFuture(const QString &methodName,
+                                                  const QMap<QString, QVariant> &params)
+{
+    return invoke(methodName, params).future();
+}
+
+/*!
+    Invokes a batch of \a items (web method names with parameters),
+    with at most \a maxInFlight calls at the same time (0 or less means
+    no limit). Returns the batch, owned by this web service; it can be
+    deleted once it is finished. Calls are sent when control returns
+    to the event loop, so batch signals can be connected first.
+
+    \sa QWebBatch
+  */
+QWebBatch *QWebService::invokeBatch(const QList<QWebBatch::Item> &items, int maxInFlight)
+{
+    QWebBatch *batch = new QWebBatch(this, items, maxInFlight, this);
+    QMetaObject::invokeMethod(batch, "start", Qt::QueuedConnection);
+    return batch;
 }
 
 /*!
@@ -437,6 +509,7 @@ void QWebService::setWsdl(QWsdl *newWsdl)
     setName(d->wsdl->webServiceName());
     foreach (QString s, d->wsdl->methods()->keys()) {
         d->methods->insert(s, d->wsdl->methods()->value(s));
+        d->configureMethod(d->methods->value(s));
         connect(d->methods->value(s), SIGNAL(replyReady(QByteArray)),
                 this, SLOT(receiveReply(QByteArray)));
     }
@@ -467,6 +540,7 @@ void QWebService::resetWsdl(QWsdl *newWsdl)
 //        d->methods = d->wsdl->methods();
         foreach (QString s, d->wsdl->methods()->keys()) {
             d->methods->insert(s, d->wsdl->methods()->value(s));
+            d->configureMethod(d->methods->value(s));
             connect(d->methods->value(s), SIGNAL(replyReady(QByteArray)),
                     this, SLOT(receiveReply(QByteArray)));
         }
@@ -474,6 +548,393 @@ void QWebService::resetWsdl(QWsdl *newWsdl)
     }
 }
 
+/*!
+    Returns HTTP version used by methods of this web service.
+
+    \sa setHttpTransport()
+  */
+QWebMethod::HttpTransport QWebService::httpTransport() const
+{
+    Q_D(const QWebService);
+    return d->httpTransport;
+}
+
+/*!
+    Sets HTTP version (\a transport) of all methods of this web service,
+    including ones added later. With HTTP/2, concurrent calls of all
+    methods going to the same host share one connection.
+
+    \sa QWebMethod::setHttpTransport()
+  */
+void QWebService::setHttpTransport(QWebMethod::HttpTransport transport)
+{
+    Q_D(QWebService);
+    d->httpTransport = transport;
+    foreach (QWebMethod *method, *d->methods)
+        method->setHttpTransport(transport);
+}
+
+/*!
+    Returns scheduling priority of methods of this web service.
+
+    \sa setPriority()
+  */
+QWebMethod::Priority QWebService::priority() const
+{
+    Q_D(const QWebService);
+    return d->priority;
+}
+
+/*!
+    Sets scheduling \a priority of all methods of this web service,
+    including ones added later. Use QWebMethod::Bulk for services doing
+    background work, so that they do not hold up interactive calls
+    to the same host.
+
+    \sa QWebMethod::setPriority(), QWebScheduler
+  */
+void QWebService::setPriority(QWebMethod::Priority priority)
+{
+    Q_D(QWebService);
+    d->priority = priority;
+    foreach (QWebMethod *method, *d->methods)
+        method->setPriority(priority);
+}
+
+/*!
+    Returns retry policy of methods of this web service.
+
+    \sa setRetryPolicy()
+  */
+QWebRetryPolicy QWebService::retryPolicy() const
+{
+    Q_D(const QWebService);
+    return d->retryPolicy;
+}
+
+/*!
+    Sets retry \a policy of all methods of this web service, including
+    ones added later. Policy applies only to methods marked as idempotent,
+    for example:
+    \code
+    service->setRetryPolicy(QWebRetryPolicy(4, 100));
+    service->method("getBands")->setIdempotent(true);
+    \endcode
+
+    \sa QWebMethod::setRetryPolicy(), QWebMethod::setIdempotent()
+  */
+void QWebService::setRetryPolicy(const QWebRetryPolicy &policy)
+{
+    Q_D(QWebService);
+    d->retryPolicy = policy;
+    foreach (QWebMethod *method, *d->methods)
+        method->setRetryPolicy(policy);
+}
+
+/*!
+    Returns default timeout of calls of this web service, in milliseconds
+    (0 means no timeout).
+
+    \sa setTimeout()
+  */
+int QWebService::timeout() const
+{
+    Q_D(const QWebService);
+    return d->timeout;
+}
+
+/*!
+    Sets default timeout of calls of all methods of this web service,
+    including ones added later, to \a msecs milliseconds.
+
+    \sa QWebMethod::setTimeout()
+  */
+void QWebService::setTimeout(int msecs)
+{
+    Q_D(QWebService);
+    d->timeout = msecs;
+    foreach (QWebMethod *method, *d->methods)
+        method->setTimeout(msecs);
+}
+
+/*!
+    Cancels unfinished calls of all methods of this web service.
+
+    \sa QWebMethod::cancelPendingCalls()
+  */
+void QWebService::cancelPendingCalls()
+{
+    Q_D(QWebService);
+    foreach (QWebMethod *method, *d->methods)
+        method->cancelPendingCalls();
+}
+
+/*!
+    Returns time (in milliseconds) for which replies of method
+    \a methodName are cached, or 0 if they are not cached.
+
+    \sa setCacheTtl()
+  */
+int QWebService::cacheTtl(const QString &methodName) const
+{
+    Q_D(const QWebService);
+    return d->cacheTtls.value(methodName, 0);
+}
+
+/*!
+    Enables caching of replies of method \a methodName, for \a msecs
+    milliseconds (0 or less disables caching). Caching is opt-in, and
+    is meant for idempotent methods only - reading a list of bands can be
+    cached, adding a band can not.
+
+    Replies are cached by method name, host and the serialized request,
+    so calls with different parameters do not share replies. Only
+    successful replies are stored. Cache applies to invokeMethod(),
+    invoke(), invokeFuture() and invokeBatch(); calls made directly
+    through QWebMethod always go to the server.
+
+    \code
+    service->setCacheTtl("getBands", 60000);
+    service->invokeMethod("getBands"); // Sent to the server.
+    service->invokeMethod("getBands"); // Answered from the cache.
+    \endcode
+
+    \sa setCacheBudget(), clearCache(), QWebMethodCall::isFromCache()
+  */
+void QWebService::setCacheTtl(const QString &methodName, int msecs)
+{
+    Q_D(QWebService);
+    if (msecs > 0)
+        d->cacheTtls.insert(methodName, msecs);
+    else
+        d->cacheTtls.remove(methodName);
+}
+
+/*!
+    Returns maximum size (in bytes) of replies held by the cache.
+    Default is 4 MiB.
+
+    \sa setCacheBudget()
+  */
+int QWebService::cacheBudget() const
+{
+    Q_D(const QWebService);
+    return d->cache.maxCost();
+}
+
+/*!
+    Sets maximum size of cached replies to \a bytes. When the cache
+    is full, least recently used replies are dropped. Replies bigger
+    than the whole budget are not cached.
+
+    \sa cacheSize()
+  */
+void QWebService::setCacheBudget(int bytes)
+{
+    Q_D(QWebService);
+    d->cache.setMaxCost(qMax(bytes, 0));
+}
+
+/*!
+    Returns size (in bytes) of replies held by the cache, including
+    expired ones that were not dropped yet.
+
+    \sa cacheBudget()
+  */
+int QWebService::cacheSize() const
+{
+    Q_D(const QWebService);
+    return d->cache.totalCost();
+}
+
+/*!
+    Returns number of calls answered from the cache.
+
+    \sa cacheMissCount()
+  */
+quint64 QWebService::cacheHitCount() const
+{
+    Q_D(const QWebService);
+    return d->cacheHits;
+}
+
+/*!
+    Returns number of calls of cached methods which had to be sent to
+    the server.
+
+    \sa cacheHitCount()
+  */
+quint64 QWebService::cacheMissCount() const
+{
+    Q_D(const QWebService);
+    return d->cacheMisses;
+}
+
+/*!
+    Drops all cached replies. Hit and miss counters are not reset.
+
+    \sa setCacheTtl()
+  */
+void QWebService::clearCache()
+{
+    Q_D(QWebService);
+    d->cache.clear();
+}
+
+/*!
+    Returns true if identical calls of methods of this web service are
+    coalesced.
+
+    \sa setCoalescing()
+  */
+bool QWebService::isCoalescing() const
+{
+    Q_D(const QWebService);
+    return d->coalescing;
+}
+
+/*!
+    Enables (when \a coalescing is true) coalescing of identical calls
+    in all methods of this web service, including ones added later: while
+    a request is in flight, identical calls wait for its reply instead
+    of sending their own. Coalescing works together with the result cache
+    (see setCacheTtl()) - the cache answers calls after the reply has
+    arrived, coalescing while it is awaited.
+
+    \sa QWebMethod::setCoalescing(), coalescedCallCount()
+  */
+void QWebService::setCoalescing(bool coalescing)
+{
+    Q_D(QWebService);
+    d->coalescing = coalescing;
+    foreach (QWebMethod *method, *d->methods)
+        method->setCoalescing(coalescing);
+}
+
+/*!
+    Returns number of calls of all methods, which waited for a request
+    sent by an identical call.
+
+    \sa QWebMethod::coalescedCallCount()
+  */
+quint64 QWebService::coalescedCallCount() const
+{
+    Q_D(const QWebService);
+    quint64 result = 0;
+    foreach (QWebMethod *method, *d->methods)
+        result += method->coalescedCallCount();
+    return result;
+}
+
+/*!
+    Returns true if compression is enabled for methods of this web service.
+
+    \sa setCompressionEnabled(), QWebMethod::isCompressionEnabled()
+  */
+bool QWebService::isCompressionEnabled() const
+{
+    Q_D(const QWebService);
+    return d->compressionEnabled;
+}
+
+/*!
+    Enables (when \a enabled is true) or disables request and reply
+    compression in all methods of this web service, including ones added
+    later.
+
+    \sa QWebMethod::setCompressionEnabled()
+  */
+void QWebService::setCompressionEnabled(bool enabled)
+{
+    Q_D(QWebService);
+    d->compressionEnabled = enabled;
+    foreach (QWebMethod *method, *d->methods)
+        method->setCompressionEnabled(enabled);
+}
+
+/*!
+    Returns the size (in bytes) from which request bodies are compressed.
+
+    \sa setCompressionThreshold()
+  */
+int QWebService::compressionThreshold() const
+{
+    Q_D(const QWebService);
+    return d->compressionThreshold;
+}
+
+/*!
+    Sets compression threshold (in \a bytes) of all methods of this
+    web service, including ones added later.
+
+    \sa QWebMethod::setCompressionThreshold()
+  */
+void QWebService::setCompressionThreshold(int bytes)
+{
+    Q_D(QWebService);
+    d->compressionThreshold = bytes;
+    foreach (QWebMethod *method, *d->methods)
+        method->setCompressionThreshold(bytes);
+}
+
+/*!
+    Returns number of request bytes sent by all methods, as they were sent.
+
+    \sa QWebMethod::bytesSent()
+  */
+qint64 QWebService::bytesSent() const
+{
+    Q_D(const QWebService);
+    qint64 result = 0;
+    foreach (QWebMethod *method, *d->methods)
+        result += method->bytesSent();
+    return result;
+}
+
+/*!
+    Returns number of request bytes sent by all methods, before compression.
+
+    \sa QWebMethod::uncompressedBytesSent()
+  */
+qint64 QWebService::uncompressedBytesSent() const
+{
+    Q_D(const QWebService);
+    qint64 result = 0;
+    foreach (QWebMethod *method, *d->methods)
+        result += method->uncompressedBytesSent();
+    return result;
+}
+
+/*!
+    Returns number of reply bytes received by all methods, as they
+    were received.
+
+    \sa QWebMethod::bytesReceived()
+  */
+qint64 QWebService::bytesReceived() const
+{
+    Q_D(const QWebService);
+    qint64 result = 0;
+    foreach (QWebMethod *method, *d->methods)
+        result += method->bytesReceived();
+    return result;
+}
+
+/*!
+    Returns number of reply bytes received by all methods, after
+    decompression.
+
+    \sa QWebMethod::uncompressedBytesReceived()
+  */
+qint64 QWebService::uncompressedBytesReceived() const
+{
+    Q_D(const QWebService);
+    qint64 result = 0;
+    foreach (QWebMethod *method, *d->methods)
+        result += method->uncompressedBytesReceived();
+    return result;
+}
+
 /*!
     Returns true if object is in error state.
   */
@@ -505,11 +966,107 @@ QString QWebService::errorInfo() const
 void QWebServicePrivate::init()
 {
     errorState = false;
+    cache.setMaxCost(4 * 1024 * 1024);
+    cacheClock.start();
+    cacheHits = 0;
+    cacheMisses = 0;
 
     if (wsdl->isErrorState())
         return;
 }
 
+/*!
+    \internal
+
+    Applies web service wide settings to \a method.
+  */
+void QWebServicePrivate::configureMethod(QWebMethod *method)
+{
+    if (method == 0)
+        return;
+
+    method->setHttpTransport(httpTransport);
+    method->setPriority(priority);
+    method->setRetryPolicy(retryPolicy);
+    method->setTimeout(timeout);
+    method->setCoalescing(coalescing);
+    method->setCompressionEnabled(compressionEnabled);
+    method->setCompressionThreshold(compressionThreshold);
+}
+
+/*!
+    \internal
+
+    Invokes method \a methodName with \a requestData (or its parameters,
+    if \a requestData is empty). If replies of the method are cached,
+    returns a call answered from the cache when possible, or stores
+    the reply once the call is finished.
+  */
+QWebMethodCall QWebServicePrivate::invokeCached(const QString &methodName,
+                                                const QByteArray &requestData)
+{
+    Q_Q(QWebService);
+    QWebMethod *method = methods->value(methodName);
+    if (method == 0)
+        return QWebMethodCall();
+
+    int ttl = cacheTtls.value(methodName, 0);
+    if (ttl <= 0)
+        return method->invoke(requestData);
+
+    // Key needs the serialized request, so it is prepared here
+    // and sent as it is.
+    QByteArray body = requestData;
+    if (body.isEmpty()) {
+        method->d_func()->prepareRequestData();
+        body = method->d_func()->data;
+    }
+
+    QString key = methodName + QLatin1Char('\n') + method->hostUrl().toString()
+            + QLatin1Char('\n') + QString::fromLatin1(
+                QCryptographicHash::hash(body, QCryptographicHash::Sha1).toHex());
+
+    QWebCacheEntry *entry = cache.object(key);
+    if (entry != 0) {
+        if (entry->expires > cacheClock.elapsed()) {
+            ++cacheHits;
+            return method->d_func()->cachedCall(body, entry->reply);
+        }
+        cache.remove(key);
+    }
+
+    ++cacheMisses;
+    QWebMethodCall call = method->invoke(body);
+    if (call.isValid()) {
+        QPointer<QWebService> service(q);
+        call.then([service, key, ttl](const QWebMethodCall &finished) {
+            if (service.isNull() || finished.isErrorState())
+                return;
+            if ((finished.httpStatusCode() < 200) || (finished.httpStatusCode() > 299))
+                return;
+            service->d_func()->storeReply(key, finished.replyReadRaw(), ttl);
+        });
+    }
+    return call;
+}
+
+/*!
+    \internal
+
+    Caches \a reply under \a key for \a ttl milliseconds. Replies that
+    do not fit the budget are not cached.
+  */
+void QWebServicePrivate::storeReply(const QString &key, const QByteArray &reply, int ttl)
+{
+    if (reply.isEmpty() || (reply.size() > cache.maxCost()))
+        return;
+
+    QWebCacheEntry *entry = new QWebCacheEntry;
+    entry->reply = reply;
+    entry->expires = cacheClock.elapsed() + ttl;
+    cache.insert(key, entry, reply.size());
+}
+
 /*!
     \internal
 
@@ -161,25 +161,34 @@ bool QWebServiceMethod::invokeMethod(const QMap<QString, QVariant> &params)
     Protocol can optionally be specified by \a protocol (default is SOAP 1.2),
     as well as HTTP \a method (default is POST).
 
-    Returns with web service reply, once it is received. This is a blocking method.
+    Returns with web service reply, once it is received. This is a blocking method:
+    it waits (in a local event loop, see QWebMethod::invokeAndWait()) for at most
+    \a msecs milliseconds. On error or timeout, returns an empty byte array,
+    and - if \a errorInfo is not null - stores error message in it.
   */
 QByteArray QWebServiceMethod::invokeMethod(const QUrl &url,
                                           const QString &methodName,
                                           const QString &targetNamespace,
                                           const QMap<QString, QVariant> &params,
                                           Protocol protocol, HttpMethod httpMethod,
-                                          QObject *parent)
+                                          QObject *parent, int msecs,
+                                          QString *errorInfo)
 {
     QWebServiceMethod qsm(url.toString(), methodName, targetNamespace, params,
                           protocol, httpMethod, parent);
 
-    qsm.invokeMethod();
-    // TODO: ADD ERROR HANDLING!
-    forever {
-        if (qsm.isReplyReady()) {
-            return qsm.d_func()->reply;
-        } else {
-            qApp->processEvents();
-        }
-    }
+    QWebMethodCall call = qsm.invokeAndWait(msecs);
+    QString error;
+    if (!call.isValid())
+        error = qsm.errorInfo();
+    else if (call.isErrorState())
+        error = call.errorInfo();
+
+    if (errorInfo != 0)
+        *errorInfo = error;
+
+    if (!error.isEmpty() || !call.isValid())
+        return QByteArray();
+
+    return call.replyReadRaw();
 }
@@ -92,6 +92,7 @@ QWsdl::QWsdl(QObject *parent) :
     QObject(parent), d_ptr(new QWsdlPrivate)
 {
     Q_D(QWsdl);
+    d->q_ptr = this;
     d->init();
 }
 
@@ -103,6 +104,7 @@ QWsdl::QWsdl(const QString &wsdlFile, QObject *parent) :
     QObject(parent), d_ptr(new QWsdlPrivate)
 {
     Q_D(QWsdl);
+    d->q_ptr = this;
     d->m_wsdlFilePath = wsdlFile;
     d->init();
     parse();
@@ -118,6 +120,7 @@ QWsdl::QWsdl(QWsdlPrivate &dd, QObject *parent) :
     QObject(parent), d_ptr(&dd)
 {
     Q_D(QWsdl);
+    d->q_ptr = this;
     d->init();
 }
 
@@ -293,6 +296,18 @@ bool QWsdl::isErrorState() const
     return d->errorState;
 }
 
+/*!
+    \internal
+
+    Passes the finished WSDL download to fileReplyFinished().
+  */
+void QWsdl::networkReplyFinished()
+{
+    QNetworkReply *rply = qobject_cast<QNetworkReply *>(sender());
+    if (rply != 0)
+        fileReplyFinished(rply);
+}
+
 /*!
     Asynchronous public return slot. Reads WSDL reply (\a rply)
     from server (used in case URL was specified in wsdl file path).
@@ -308,6 +323,8 @@ void QWsdl::fileReplyFinished(QNetworkReply *rply)
         file.remove();
 
     if (!file.open(QFile::WriteOnly)) {
+        d->replyReceived = true;
+        rply->deleteLater();
         d->enterErrorState(
                     QString(QLatin1String("Error: cannot write WSDL file from "
                                           "remote location. Reason: ")
@@ -373,6 +390,8 @@ bool QWsdl::parse()
     }
 
     prepareFile();
+    if (d->errorState)
+        return false;
 
     QFile file(d->m_wsdlFilePath);
     if (!file.open(QFile::ReadOnly | QFile::Text)) {
@@ -416,7 +435,8 @@ bool QWsdl::parse()
     \internal
 
     If the host path is not a local file, but URL, QWsdl will download
-    it into a temporary file, then read, and delete at exit.
+    it into a temporary file, then read, and delete at exit. Download
+    is given up after 30 seconds.
   */
 void QWsdl::prepareFile()
 {
@@ -426,20 +446,23 @@ void QWsdl::prepareFile()
 
     if (!QFile::exists(d->m_wsdlFilePath) && filePath.isValid()) {
         d->m_hostUrl = filePath;
-        QNetworkAccessManager *manager = new QNetworkAccessManager();
-        QObject::connect(manager, SIGNAL(finished(QNetworkReply*)),
-                this, SLOT(fileReplyFinished(QNetworkReply*)));
-        manager->get(QNetworkRequest(filePath));
-
-        forever {
-            if (d->replyReceived == true) {
-                return;
-            } else {
-                QCoreApplication::instance()->processEvents();
-            }
+        QNetworkAccessManager *manager = QWebNetworkPool::acquire();
+        QWebNetworkPool::registerRequest(manager, filePath);
+        QNetworkReply *reply = manager->get(QNetworkRequest(filePath));
+        // Manager is shared, so the reply is tracked directly.
+        QObject::connect(reply, SIGNAL(finished()),
+                         this, SLOT(networkReplyFinished()));
+
+        // Waits in a local event loop, which does not use CPU time.
+        if (!QWebNetworkPool::waitForFinished(reply)) {
+            QObject::disconnect(reply, 0, this, 0);
+            reply->abort();
+            reply->deleteLater();
+            d->replyReceived = true;
+            d->enterErrorState(QLatin1String("Error: WSDL download timed out."));
         }
 
-        delete manager;
+        QWebNetworkPool::release(manager);
     }
 }
 
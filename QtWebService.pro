@@ -10,5 +10,7 @@ RCC_DIR = $${BUILD_DIRECTORY}
 SUBDIRS += \
     QWebService \
     qtwsdlconvert \
+    qtwsbench \
     tests \
+    benchmarks \
     examples
@@ -0,0 +1,16 @@
+include(../../buildInfo.pri)
+
+QT += testlib
+# Coroutines (see qwebcoroutine.h).
+CONFIG += c++2a
+
+include(../../libraryIncludes.pri)
+
+DESTDIR = $${BENCHMARKS_DIRECTORY}/QWebCoroutine
+OBJECTS_DIR = $${BENCHMARKS_DIRECTORY}/QWebCoroutine
+MOC_DIR = $${BENCHMARKS_DIRECTORY}/QWebCoroutine
+
+SOURCES += tst_bench_qwebcoroutine.cpp
+
+include(../../tests/shared/shared.pri)
+include(../shared/shared.pri)
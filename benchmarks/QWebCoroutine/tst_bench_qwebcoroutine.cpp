@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebCoroutine benchmark suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <qwebmethod.h>
+#include <qwebcoroutine.h>
+#include <standinserver.h>
+#include <benchmarkmain.h>
+
+/**
+  This benchmark compares the overhead of awaiting web method calls in
+  C++20 coroutines with handling them in a slot. Does not require Internet
+  connection - calls go to a stand-in server on loopback interface.
+  */
+class BenchQWebCoroutine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fanOut_data();
+    void fanOut();
+
+#ifdef QWEBSERVICE_HAS_COROUTINES
+private:
+    static QWebTask awaitOne(QWebMethod *method, int *succeeded);
+#endif
+};
+
+#ifdef QWEBSERVICE_HAS_COROUTINES
+QWebTask BenchQWebCoroutine::awaitOne(QWebMethod *method, int *succeeded)
+{
+    QWebMethodCall call = co_await method->invoke();
+    if (!call.isErrorState())
+        ++*succeeded;
+}
+#endif
+
+/*
+  10000 calls sent at once, each awaited in its own coroutine, or
+  handled by a slot connected to callFinished().
+  */
+void BenchQWebCoroutine::fanOut_data()
+{
+    QTest::addColumn<bool>("coroutines");
+
+    QTest::newRow("coroutines") << true;
+    QTest::newRow("callFinished() signal") << false;
+}
+
+/*
+  Reports calls per second (as events).
+  */
+void BenchQWebCoroutine::fanOut()
+{
+#ifndef QWEBSERVICE_HAS_COROUTINES
+    QSKIP("Compiler does not support C++20 coroutines.");
+#else
+    QFETCH(bool, coroutines);
+
+    const int callCount = 10000;
+
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod method(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method.setMethodName(QLatin1String("standIn"));
+
+    int succeeded = 0;
+    connect(&method, &QWebMethod::callFinished, [&succeeded, coroutines](const QWebMethodCall &call) {
+        if (!coroutines && !call.isErrorState())
+            ++succeeded;
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < callCount; i++) {
+        if (coroutines)
+            awaitOne(&method, &succeeded);
+        else
+            method.invoke();
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(succeeded, callCount, 60000);
+
+    QTest::setBenchmarkResult((callCount * 1000.0) / qMax<qint64>(1, timer.elapsed()),
+                              QTest::Events);
+#endif
+}
+
+BENCHMARK_MAIN(BenchQWebCoroutine)
+#include "tst_bench_qwebcoroutine.moc"
@@ -0,0 +1,14 @@
+include(../../buildInfo.pri)
+
+QT += testlib
+
+include(../../libraryIncludes.pri)
+
+DESTDIR = $${BENCHMARKS_DIRECTORY}/QWebMethod
+OBJECTS_DIR = $${BENCHMARKS_DIRECTORY}/QWebMethod
+MOC_DIR = $${BENCHMARKS_DIRECTORY}/QWebMethod
+
+SOURCES += tst_bench_qwebmethod.cpp
+
+include(../../tests/shared/shared.pri)
+include(../shared/shared.pri)
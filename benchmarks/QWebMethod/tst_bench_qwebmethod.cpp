@@ -0,0 +1,555 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebMethod benchmark suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <qwsdl.h>
+#include <qwebmethodinternals_p.h>
+#include <standinserver.h>
+#include <benchmarkmain.h>
+
+#include <ctime>
+
+/**
+  This benchmark measures request serialization, reply parsing and upload
+  memory use of QWebMethod. Does not require Internet connection - uploads go to
+  a stand-in server on loopback interface.
+  */
+class BenchQWebMethod : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void prepareRequestData_data();
+    void prepareRequestData();
+    void serializeByProtocol_data();
+    void serializeByProtocol();
+    void replyReadParsed_data();
+    void replyReadParsed();
+    void convertReplyToUtf_data();
+    void convertReplyToUtf();
+    void uploadPeakMemory_data();
+    void uploadPeakMemory();
+    void transportThroughput_data();
+    void transportThroughput();
+    void synchronousCallCpuTime_data();
+    void synchronousCallCpuTime();
+
+private:
+    qint64 peakResidentSize();
+    void resetPeakResidentSize();
+
+    QByteArray legacyRequestData(const QString &methodName,
+                                 const QString &targetNamespace,
+                                 const QMap<QString, QVariant> &parameters,
+                                 QWebMethod::Protocol protocol);
+    QMap<QString, QVariant> sampleParameters(const QMap<QString, QVariant> &types);
+    QByteArray sampleReply(int protocol, int records);
+
+    QWsdl *wsdl;
+};
+
+/*
+  Reads band_ws WSDL, which is the source of operations used in benchmarks.
+  */
+void BenchQWebMethod::initTestCase()
+{
+    wsdl = new QWsdl(QString("../../../examples/wsdl/band_ws.asmx"), this);
+    QCOMPARE(wsdl->isErrorState(), bool(false));
+}
+
+/*
+  Each operation of band_ws is serialized by the old (QString based)
+  and the new (precompiled envelope) code.
+  */
+void BenchQWebMethod::prepareRequestData_data()
+{
+    QTest::addColumn<QString>("operation");
+    QTest::addColumn<bool>("legacy");
+
+    foreach (const QString &operation, wsdl->methodNames()) {
+        QTest::newRow(QString(operation + QLatin1String(" old")).toLatin1())
+                << operation << true;
+        QTest::newRow(QString(operation + QLatin1String(" new")).toLatin1())
+                << operation << false;
+    }
+}
+
+void BenchQWebMethod::prepareRequestData()
+{
+    QFETCH(QString, operation);
+    QFETCH(bool, legacy);
+
+    QWebMethod *source = wsdl->methods()->value(operation);
+    QMap<QString, QVariant> parameters
+            = sampleParameters(source->parameterNamesTypes());
+    QWebMethod method;
+    method.setHost(source->hostUrl());
+    method.setMethodName(source->methodName());
+    method.setTargetNamespace(source->targetNamespace());
+    method.setParameters(parameters);
+
+    QByteArray data;
+    if (legacy) {
+        QBENCHMARK {
+            data = legacyRequestData(method.methodName(),
+                                     method.targetNamespace(),
+                                     parameters, method.protocol());
+        }
+    } else {
+        QBENCHMARK {
+            data = QWebMethodInternals::requestData(&method, method.protocol());
+        }
+    }
+
+    QVERIFY(!data.isEmpty());
+}
+
+/*
+  Parameters (a mix of strings, numbers, booleans and dates) serialized
+  for each protocol.
+  */
+void BenchQWebMethod::serializeByProtocol_data()
+{
+    QTest::addColumn<int>("protocol");
+    QTest::addColumn<int>("parameterCount");
+
+    QList<QPair<QString, int> > protocols;
+    protocols << qMakePair(QString(QLatin1String("SOAP 1.0")), int(QWebMethod::Soap10))
+              << qMakePair(QString(QLatin1String("SOAP 1.2")), int(QWebMethod::Soap12))
+              << qMakePair(QString(QLatin1String("JSON")), int(QWebMethod::Json))
+              << qMakePair(QString(QLatin1String("XML")), int(QWebMethod::Xml))
+              << qMakePair(QString(QLatin1String("HTTP")), int(QWebMethod::Http))
+              << qMakePair(QString(QLatin1String("REST")), int(QWebMethod::Rest));
+
+    const int counts[] = { 0, 1, 10, 100 };
+
+    for (int i = 0; i < protocols.size(); i++) {
+        for (int j = 0; j < 4; j++) {
+            QTest::newRow(QString(QLatin1String("%1, %2 parameters"))
+                          .arg(protocols.at(i).first).arg(counts[j]).toLatin1())
+                    << protocols.at(i).second << counts[j];
+        }
+    }
+}
+
+void BenchQWebMethod::serializeByProtocol()
+{
+    QFETCH(int, protocol);
+    QFETCH(int, parameterCount);
+
+    QMap<QString, QVariant> types;
+    for (int i = 0; i < parameterCount; i++) {
+        QVariant type;
+        switch (i % 4) {
+        case 0: type = QVariant(QVariant::String); break;
+        case 1: type = QVariant(QVariant::Int); break;
+        case 2: type = QVariant(QVariant::Bool); break;
+        default: type = QVariant(QVariant::DateTime);
+        }
+        types.insert(QString(QLatin1String("parameter%1")).arg(i), type);
+    }
+
+    QWebMethod method;
+    method.setHost(QLatin1String("http://localhost/bench"));
+    method.setMethodName(QLatin1String("benchMethod"));
+    method.setTargetNamespace(QLatin1String("http://tempuri.org/"));
+    method.setParameters(sampleParameters(types));
+
+    // Protocol is passed directly, setProtocol() turns SOAP 1.0 into SOAP 1.2.
+    QByteArray data;
+    QBENCHMARK {
+        data = QWebMethodInternals::requestData(&method,
+                                                QWebMethod::Protocol(protocol));
+    }
+
+    if (parameterCount > 0)
+        QVERIFY(!data.isEmpty());
+}
+
+/*
+  Small (1 record) and big (about 4 MB) SOAP and JSON replies, decoded
+  by replyReadParsed(). Cached result is dropped before each iteration.
+  */
+void BenchQWebMethod::replyReadParsed_data()
+{
+    QTest::addColumn<int>("protocol");
+    QTest::addColumn<int>("records");
+
+    QTest::newRow("SOAP small") << int(QWebMethod::Soap12) << 1;
+    QTest::newRow("SOAP 4 MB") << int(QWebMethod::Soap12) << 20000;
+    QTest::newRow("JSON small") << int(QWebMethod::Json) << 1;
+    QTest::newRow("JSON 4 MB") << int(QWebMethod::Json) << 20000;
+}
+
+void BenchQWebMethod::replyReadParsed()
+{
+    QFETCH(int, protocol);
+    QFETCH(int, records);
+
+    QWebMethod method;
+    method.setProtocol(QWebMethod::Protocol(protocol));
+    method.setMethodName(QLatin1String("getBands"));
+    QByteArray reply = sampleReply(protocol, records);
+
+    QVariant result;
+    QBENCHMARK {
+        QWebMethodInternals::setReply(&method, reply);
+        result = method.replyReadParsed();
+    }
+
+    QVERIFY(result.isValid());
+    QCOMPARE(method.isErrorState(), bool(false));
+}
+
+/*
+  Entity conversion done on XML replies, for small and big (about 4 MB)
+  texts.
+  */
+void BenchQWebMethod::convertReplyToUtf_data()
+{
+    QTest::addColumn<int>("records");
+
+    QTest::newRow("small") << 1;
+    QTest::newRow("4 MB") << 20000;
+}
+
+void BenchQWebMethod::convertReplyToUtf()
+{
+    QFETCH(int, records);
+
+    QWebMethod method;
+    QString text = QString::fromUtf8(sampleReply(QWebMethod::Soap12, records));
+    text.replace(QLatin1Char('<'), QLatin1String("&lt;"));
+    text.replace(QLatin1Char('>'), QLatin1String("&gt;"));
+
+    QString result;
+    QBENCHMARK {
+        result = QWebMethodInternals::convertReplyToUtf(&method, text);
+    }
+
+    QVERIFY(result.size() < text.size());
+}
+
+/*
+  Uploads bodies of increasing size, once streamed from a generator,
+  and once from a QByteArray held in memory. Result is the growth of peak
+  resident set size during the upload.
+  */
+void BenchQWebMethod::uploadPeakMemory_data()
+{
+    QTest::addColumn<int>("megabytes");
+    QTest::addColumn<bool>("streamed");
+
+    QTest::newRow("1 MB streamed") << 1 << true;
+    QTest::newRow("16 MB streamed") << 16 << true;
+    QTest::newRow("64 MB streamed") << 64 << true;
+    QTest::newRow("256 MB streamed") << 256 << true;
+    QTest::newRow("1 MB in memory") << 1 << false;
+    QTest::newRow("16 MB in memory") << 16 << false;
+    QTest::newRow("64 MB in memory") << 64 << false;
+}
+
+void BenchQWebMethod::uploadPeakMemory()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("Peak memory is read from /proc, which is only available on Linux.");
+#endif
+    QFETCH(int, megabytes);
+    QFETCH(bool, streamed);
+
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod method(server.url(QLatin1String("/upload")), QWebMethod::Soap12);
+    QSignalSpy spy(&method, SIGNAL(callFinished(QWebMethodCall)));
+
+    const qint64 size = qint64(megabytes) * 1024 * 1024;
+    const QByteArray piece(64 * 1024, 'x');
+
+    resetPeakResidentSize();
+    qint64 before = peakResidentSize();
+    QWebMethodCall call;
+
+    if (streamed) {
+        qint64 produced = 0;
+        call = method.invoke([&produced, size, &piece]() -> QByteArray {
+            if (produced >= size)
+                return QByteArray();
+            produced += piece.size();
+            return piece;
+        }, size);
+    } else {
+        call = method.invoke(QByteArray(int(size), 'x'));
+    }
+
+    QVERIFY(call.isValid());
+    QTRY_VERIFY_WITH_TIMEOUT(call.isFinished(), 120000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(server.bytesReceived(), size);
+    QCOMPARE(spy.count(), 1);
+
+    QTest::setBenchmarkResult(peakResidentSize() - before, QTest::BytesAllocated);
+}
+
+/*
+  Sends 1000 small SOAP calls, all at once, over HTTP/1.1 and over
+  cleartext HTTP/2, to the stand-in server. Reports calls per second,
+  or number of connections the calls used (both as events).
+  */
+void BenchQWebMethod::transportThroughput_data()
+{
+    QTest::addColumn<int>("transport");
+    QTest::addColumn<bool>("connections");
+
+    QTest::newRow("HTTP/1.1 calls per second") << int(QWebMethod::Http1) << false;
+    QTest::newRow("HTTP/2 calls per second") << int(QWebMethod::Http2Direct) << false;
+    QTest::newRow("HTTP/1.1 connections") << int(QWebMethod::Http1) << true;
+    QTest::newRow("HTTP/2 connections") << int(QWebMethod::Http2Direct) << true;
+}
+
+void BenchQWebMethod::transportThroughput()
+{
+    QFETCH(int, transport);
+    QFETCH(bool, connections);
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 11, 0)
+    if (transport != QWebMethod::Http1)
+        QSKIP("HTTP/2 with prior knowledge requires Qt 5.11.");
+#endif
+
+    const int callCount = 1000;
+
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod method(server.url(QLatin1String("/soap")), QWebMethod::Soap12);
+    method.setMethodName(QLatin1String("standIn"));
+    method.setTargetNamespace(QLatin1String("http://tempuri.org/"));
+    method.setHttpTransport(QWebMethod::HttpTransport(transport));
+    QMap<QString, QVariant> params;
+    params.insert(QLatin1String("value"), QVariant(QLatin1String("small")));
+    method.setParameters(params);
+
+    QSignalSpy spy(&method, SIGNAL(callFinished(QWebMethodCall)));
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < callCount; i++)
+        method.invoke();
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), callCount, 60000);
+
+    qint64 elapsed = timer.elapsed();
+    QCOMPARE(server.requestCount(), callCount);
+
+    if (connections)
+        QTest::setBenchmarkResult(server.connectionCount(), QTest::Events);
+    else
+        QTest::setBenchmarkResult((callCount * 1000.0) / qMax<qint64>(1, elapsed), QTest::Events);
+}
+
+/*
+  Blocking calls to a server answering after 50 ms, waiting in
+  a processEvents() loop (as suggested by old documentation), and
+  in a local event loop (QWebMethod::invokeAndWait()).
+  */
+void BenchQWebMethod::synchronousCallCpuTime_data()
+{
+    QTest::addColumn<bool>("busyLoop");
+
+    QTest::newRow("processEvents loop") << true;
+    QTest::newRow("local event loop") << false;
+}
+
+/*
+  Reports CPU time (clock ticks of the process, per call) used while waiting.
+  */
+void BenchQWebMethod::synchronousCallCpuTime()
+{
+    QFETCH(bool, busyLoop);
+
+    const int callCount = 20;
+
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReplyDelay(50);
+
+    QWebMethod method(server.url(QLatin1String("/soap")), QWebMethod::Soap12);
+    method.setMethodName(QLatin1String("standIn"));
+    method.setTargetNamespace(QLatin1String("http://tempuri.org/"));
+
+    std::clock_t start = std::clock();
+    for (int i = 0; i < callCount; i++) {
+        if (busyLoop) {
+            QWebMethodCall call = method.invoke();
+            while (!call.isFinished())
+                qApp->processEvents();
+            QCOMPARE(call.isErrorState(), bool(false));
+        } else {
+            QWebMethodCall call = method.invokeAndWait(5000);
+            QCOMPARE(call.isErrorState(), bool(false));
+        }
+    }
+    std::clock_t used = std::clock() - start;
+
+    QTest::setBenchmarkResult(qreal(used) / callCount, QTest::CPUTicks);
+}
+
+/*
+  Returns peak resident set size of the process, in bytes (VmHWM
+  from /proc/self/status), or -1 if it cannot be read.
+  */
+qint64 BenchQWebMethod::peakResidentSize()
+{
+    QFile status(QLatin1String("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    foreach (const QByteArray &line, status.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:")) {
+            QByteArray value = line.mid(6).trimmed();
+            value.chop(3); // " kB"
+            return value.trimmed().toLongLong() * 1024;
+        }
+    }
+
+    return -1;
+}
+
+/*
+  Resets peak resident set size to the current one, so that each data row
+  is measured separately.
+  */
+void BenchQWebMethod::resetPeakResidentSize()
+{
+    QFile clearRefs(QLatin1String("/proc/self/clear_refs"));
+    if (clearRefs.open(QIODevice::WriteOnly))
+        clearRefs.write("5");
+}
+
+/*
+  Fills parameters of given \a types with some example values.
+  */
+QMap<QString, QVariant> BenchQWebMethod::sampleParameters(const QMap<QString, QVariant> &types)
+{
+    QMap<QString, QVariant> result;
+
+    QMap<QString, QVariant>::const_iterator i = types.constBegin();
+    for (; i != types.constEnd(); ++i) {
+        QString type = i.value().typeName();
+
+        if (type == QLatin1String("int"))
+            result.insert(i.key(), QVariant(1304));
+        else if (type == QLatin1String("double") || type == QLatin1String("float"))
+            result.insert(i.key(), QVariant(1304.5));
+        else if (type == QLatin1String("bool"))
+            result.insert(i.key(), QVariant(true));
+        else if (type == QLatin1String("QDateTime"))
+            result.insert(i.key(), QVariant(QDateTime(QDate(2011, 11, 11), QTime(11, 11))));
+        else
+            result.insert(i.key(), QVariant(QString("Some sample value")));
+    }
+
+    return result;
+}
+
+/*
+  Returns a reply of given \a protocol (SOAP or JSON), listing \a records
+  bands. Each record takes about 200 bytes.
+  */
+QByteArray BenchQWebMethod::sampleReply(int protocol, int records)
+{
+    QByteArray result;
+
+    if (protocol == QWebMethod::Json) {
+        result = "{\"bands\":[";
+        for (int i = 0; i < records; i++) {
+            if (i > 0)
+                result += ',';
+            result += "{\"id\":" + QByteArray::number(i)
+                    + ",\"name\":\"Band number " + QByteArray::number(i)
+                    + "\",\"founded\":\"1984-05-15T00:00:00\",\"active\":true"
+                    + ",\"rating\":4.75,\"description\":\"Some sample description,"
+                    " long enough to look like a real record of a web service.\"}";
+        }
+        result += "]}";
+        return result;
+    }
+
+    result = "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+            "<soap12:Envelope xmlns:soap12=\"http://www.w3.org/2003/05/soap-envelope\">"
+            "<soap12:Body><getBandsResponse xmlns=\"http://tempuri.org/\">"
+            "<getBandsResult>";
+    for (int i = 0; i < records; i++) {
+        result += "<band><id>" + QByteArray::number(i)
+                + "</id><name>Band number " + QByteArray::number(i)
+                + "</name><founded>1984-05-15T00:00:00</founded><active>true</active>"
+                "<rating>4.75</rating><description>Some sample description, long enough"
+                " to look like a real record.</description></band>";
+    }
+    result += "</getBandsResult></getBandsResponse></soap12:Body></soap12:Envelope>";
+    return result;
+}
+
+/*
+  Serializer used by QWebMethod before envelopes were precompiled, kept here
+  as a reference point.
+  */
+QByteArray BenchQWebMethod::legacyRequestData(const QString &methodName,
+                                              const QString &targetNamespace,
+                                              const QMap<QString, QVariant> &parameters,
+                                              QWebMethod::Protocol protocol)
+{
+    QString header, body, footer;
+    QString endl = QLatin1String("\r\n");
+
+    if (protocol & QWebMethod::Soap12) {
+        header = QString(QLatin1String("<?xml version=\"1.0\" encoding=\"utf-8\"?> ")
+                 + endl + QLatin1String(" <soap12:Envelope "
+                 "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+                 "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" "
+                 "xmlns:soap12=\"http://www.w3.org/2003/05/soap-envelope\"> ") + endl +
+                 QLatin1String(" <soap12:Body> ") + endl);
+
+        footer = QString(QLatin1String("</soap12:Body> ")
+                         + endl
+                         + QLatin1String("</soap12:Envelope>"));
+    }
+
+    body = QString(QLatin1String("\t<") + methodName
+                   + QLatin1String(" xmlns=\"")
+                   + targetNamespace
+                   + QLatin1String("\"> ") + endl);
+
+    foreach (const QString currentKey, parameters.keys()) {
+        QVariant qv = parameters.value(currentKey);
+        body += QString(QLatin1String("\t\t<") + currentKey
+                        + QLatin1String(">")
+                        + qv.toString()
+                        + QLatin1String("</") + currentKey
+                        + QLatin1String("> ") + endl);
+    }
+
+    body += QString(QLatin1String("\t</")
+                    + methodName
+                    + QLatin1String("> ") + endl);
+
+    return QString(header + body + footer).toLatin1();
+}
+
+BENCHMARK_MAIN(BenchQWebMethod)
+#include "tst_bench_qwebmethod.moc"
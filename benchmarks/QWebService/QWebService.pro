@@ -0,0 +1,14 @@
+include(../../buildInfo.pri)
+
+QT += testlib
+
+include(../../libraryIncludes.pri)
+
+DESTDIR = $${BENCHMARKS_DIRECTORY}/QWebService
+OBJECTS_DIR = $${BENCHMARKS_DIRECTORY}/QWebService
+MOC_DIR = $${BENCHMARKS_DIRECTORY}/QWebService
+
+SOURCES += tst_bench_qwebservice.cpp
+
+include(../../tests/shared/shared.pri)
+include(../shared/shared.pri)
@@ -0,0 +1,136 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService benchmark suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <qwebservice.h>
+#include <qwebservice_p.h>
+#include <qwsdl.h>
+#include <standinserver.h>
+#include <benchmarkmain.h>
+
+/*
+  Gives access to private data of QWebService.
+  */
+class BenchWebService : public QWebService
+{
+public:
+    QWebServicePrivate *d() { return d_ptr; }
+};
+
+/**
+  This benchmark measures QWebService operations. Does not require Internet
+  connection - calls go to a stand-in server on loopback interface, and WSDL
+  files are read from examples/wsdl.
+  */
+class BenchQWebService : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void batchThroughput_data();
+    void batchThroughput();
+    void setWsdl_data();
+    void setWsdl();
+};
+
+/*
+  Batches of 1000 calls, with different limits of calls in flight
+  (0 means no limit).
+  */
+void BenchQWebService::batchThroughput_data()
+{
+    QTest::addColumn<int>("maxInFlight");
+
+    QTest::newRow("1 in flight") << 1;
+    QTest::newRow("6 in flight") << 6;
+    QTest::newRow("32 in flight") << 32;
+    QTest::newRow("unlimited") << 0;
+}
+
+/*
+  Reports calls per second (as events), measured over a few batches.
+  */
+void BenchQWebService::batchThroughput()
+{
+    QFETCH(int, maxInFlight);
+
+    const int callCount = 1000;
+
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebService service;
+    QWebMethod *method = new QWebMethod(server.url(QLatin1String("/soap")), QWebMethod::Soap12);
+    method->setMethodName(QLatin1String("standIn"));
+    method->setTargetNamespace(QLatin1String("http://tempuri.org/"));
+    service.addMethod(method);
+
+    QList<QWebBatch::Item> items;
+    for (int i = 0; i < callCount; i++) {
+        QMap<QString, QVariant> params;
+        params.insert(QLatin1String("index"), i);
+        items.append(QWebBatch::Item(QLatin1String("standIn"), params));
+    }
+
+    const int batchCount = 3;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < batchCount; i++) {
+        QWebBatch *batch = service.invokeBatch(items, maxInFlight);
+        QVERIFY(batch->waitForFinished(60000));
+        QCOMPARE(batch->errorCount(), int(0));
+        delete batch;
+    }
+
+    QTest::setBenchmarkResult((batchCount * callCount * 1000.0) / qMax<qint64>(1, timer.elapsed()),
+                              QTest::Events);
+}
+
+/*
+  One row for each file in examples/wsdl.
+  */
+void BenchQWebService::setWsdl_data()
+{
+    QTest::addColumn<QString>("path");
+
+    QDir examples(QLatin1String("../../../examples/wsdl"));
+    foreach (const QString &file, examples.entryList(QDir::Files, QDir::Name))
+        QTest::newRow(file.toLatin1()) << examples.filePath(file);
+}
+
+/*
+  Adds methods of an already parsed WSDL to a new service. The WSDL is
+  detached before the service is destroyed, so that it can be reused.
+  */
+void BenchQWebService::setWsdl()
+{
+    QFETCH(QString, path);
+
+    QWsdl wsdl(path);
+    QCOMPARE(wsdl.isErrorState(), bool(false));
+
+    QBENCHMARK {
+        BenchWebService service;
+        service.setWsdl(&wsdl);
+        QCOMPARE(service.methodNames().size(), wsdl.methodNames().size());
+        service.d()->wsdl = 0;
+    }
+}
+
+BENCHMARK_MAIN(BenchQWebService)
+#include "tst_bench_qwebservice.moc"
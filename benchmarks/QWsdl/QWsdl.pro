@@ -0,0 +1,13 @@
+include(../../buildInfo.pri)
+
+QT += testlib
+
+include(../../libraryIncludes.pri)
+
+DESTDIR = $${BENCHMARKS_DIRECTORY}/QWsdl
+OBJECTS_DIR = $${BENCHMARKS_DIRECTORY}/QWsdl
+MOC_DIR = $${BENCHMARKS_DIRECTORY}/QWsdl
+
+SOURCES += tst_bench_qwsdl.cpp
+
+include(../shared/shared.pri)
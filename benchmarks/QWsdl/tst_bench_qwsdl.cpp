@@ -0,0 +1,61 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWsdl benchmark suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <qwsdl.h>
+#include <benchmarkmain.h>
+
+/**
+  This benchmark measures how long it takes to read WSDL files
+  with QWsdl. Uses files from examples/wsdl.
+  */
+class BenchQWsdl : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+};
+
+/*
+  One row for each file in examples/wsdl.
+  */
+void BenchQWsdl::parse_data()
+{
+    QTest::addColumn<QString>("path");
+
+    QDir examples(QLatin1String("../../../examples/wsdl"));
+    foreach (const QString &file, examples.entryList(QDir::Files, QDir::Name))
+        QTest::newRow(file.toLatin1()) << examples.filePath(file);
+}
+
+/*
+  Constructs QWsdl, which reads and parses the file.
+  */
+void BenchQWsdl::parse()
+{
+    QFETCH(QString, path);
+
+    QBENCHMARK {
+        QWsdl wsdl(path);
+        QCOMPARE(wsdl.isErrorState(), bool(false));
+    }
+}
+
+BENCHMARK_MAIN(BenchQWsdl)
+#include "tst_bench_qwsdl.moc"
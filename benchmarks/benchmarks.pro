@@ -0,0 +1,9 @@
+include(../buildInfo.pri)
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    QWebCoroutine \
+    QWebMethod \
+    QWebService \
+    QWsdl
@@ -0,0 +1,138 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService benchmark suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "benchmarkmain.h"
+
+#include <QtCore/qfile.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qtemporaryfile.h>
+#include <QtCore/qxmlstream.h>
+
+#include <cstdio>
+
+/*
+  Converts QtTest XML log in \a xml to JSON. Every BenchmarkResult becomes
+  one item of "results", with value per iteration, as reported by QtTest.
+  */
+static QJsonObject convertResults(QIODevice *xml)
+{
+    QJsonObject document;
+    QJsonArray results;
+    QString function;
+    QXmlStreamReader reader(xml);
+
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        QXmlStreamAttributes attributes = reader.attributes();
+
+        if (reader.name() == QLatin1String("TestCase")) {
+            document.insert(QLatin1String("testCase"),
+                            attributes.value(QLatin1String("name")).toString());
+        } else if (reader.name() == QLatin1String("TestFunction")) {
+            function = attributes.value(QLatin1String("name")).toString();
+        } else if (reader.name() == QLatin1String("BenchmarkResult")) {
+            QJsonObject result;
+            result.insert(QLatin1String("function"), function);
+            result.insert(QLatin1String("tag"),
+                          attributes.value(QLatin1String("tag")).toString());
+            result.insert(QLatin1String("metric"),
+                          attributes.value(QLatin1String("metric")).toString());
+            result.insert(QLatin1String("value"),
+                          attributes.value(QLatin1String("value")).toDouble());
+            result.insert(QLatin1String("iterations"),
+                          attributes.value(QLatin1String("iterations")).toInt());
+            results.append(result);
+        }
+    }
+
+    if (reader.hasError())
+        qWarning("Benchmark log could not be read: %s", qPrintable(reader.errorString()));
+
+    document.insert(QLatin1String("qtVersion"), QLatin1String(qVersion()));
+    document.insert(QLatin1String("results"), results);
+    return document;
+}
+
+/*
+  Removes "-json <file>" from \a argv, and runs the benchmark with an extra
+  XML logger, when it was given. With "-json -", standard output gets only
+  the JSON document.
+  */
+int execBenchmark(QObject *testObject, int argc, char **argv)
+{
+    QStringList arguments;
+    QString jsonPath;
+    bool loggerChosen = false;
+
+    for (int i = 0; i < argc; i++) {
+        QString argument = QString::fromLocal8Bit(argv[i]);
+
+        if ((argument == QLatin1String("-json")) && (i + 1 < argc)) {
+            jsonPath = QString::fromLocal8Bit(argv[++i]);
+            continue;
+        }
+
+        if (argument == QLatin1String("-o"))
+            loggerChosen = true;
+        arguments.append(argument);
+    }
+
+    if (jsonPath.isEmpty())
+        return QTest::qExec(testObject, argc, argv);
+
+    QTemporaryFile log;
+    if (!log.open()) {
+        qWarning("Cannot create temporary file for benchmark log.");
+        return 1;
+    }
+    log.close();
+
+    // Plain text log is kept on standard output, unless JSON goes there.
+    arguments << QLatin1String("-o") << (log.fileName() + QLatin1String(",xml"));
+    if (!loggerChosen && (jsonPath != QLatin1String("-")))
+        arguments << QLatin1String("-o") << QLatin1String("-,txt");
+
+    int result = QTest::qExec(testObject, arguments);
+
+    if (!log.open()) {
+        qWarning("Cannot read benchmark log: %s", qPrintable(log.fileName()));
+        return 1;
+    }
+
+    QByteArray json = QJsonDocument(convertResults(&log)).toJson();
+
+    QFile output;
+    bool opened = false;
+    if (jsonPath == QLatin1String("-")) {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    } else {
+        output.setFileName(jsonPath);
+        opened = output.open(QIODevice::WriteOnly);
+    }
+
+    if (!opened || (output.write(json) != json.size())) {
+        qWarning("Cannot write benchmark results to: %s", qPrintable(jsonPath));
+        return 1;
+    }
+
+    return result;
+}
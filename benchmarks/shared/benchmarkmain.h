@@ -0,0 +1,50 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService benchmark suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef BENCHMARKMAIN_H
+#define BENCHMARKMAIN_H
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qobject.h>
+#include <QtTest/qtest.h>
+
+/*
+  Runs benchmarks of \a testObject, just like QTest::qExec() does. QtTest
+  options are all accepted, plus:
+
+    -json <file>    writes results to a file ("-" means standard output)
+                    as JSON, so that runs can be compared by scripts.
+
+  QtTest in Qt 5 has no JSON logger, so results are logged as XML
+  to a temporary file, and converted when the run is over. Text output
+  is still printed, unless other loggers were chosen with "-o".
+  */
+int execBenchmark(QObject *testObject, int argc, char **argv);
+
+/*
+  Use instead of QTEST_MAIN() in benchmarks.
+  */
+#define BENCHMARK_MAIN(TestObject) \
+int main(int argc, char *argv[]) \
+{ \
+    QCoreApplication app(argc, argv); \
+    TestObject tc; \
+    QTEST_SET_MAIN_SOURCE_PATH \
+    return execBenchmark(&tc, argc, argv); \
+}
+
+#endif // BENCHMARKMAIN_H
@@ -0,0 +1,7 @@
+# Helpers shared by benchmarks.
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += $$PWD/benchmarkmain.cpp
+
+HEADERS += $$PWD/benchmarkmain.h
@@ -1,6 +1,8 @@
 ROOT_DIRECTORY = $$PWD
 BUILD_DIRECTORY = $${ROOT_DIRECTORY}/build
 TESTS_DIRECTORY = $${BUILD_DIRECTORY}/tests
+BENCHMARKS_DIRECTORY = $${BUILD_DIRECTORY}/benchmarks
 EXAMPLES_DIRECTORY = $${BUILD_DIRECTORY}/examples
 
 QT = core network
+CONFIG += c++11
@@ -0,0 +1,126 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the qtWsBench tool.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qelapsedtimer.h>
+#include <qwsdl.h>
+#include <qwebmethod.h>
+#include "parametergenerator.h"
+
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoadGenerator(const QStringList &appArguments, QObject *parent = 0);
+    ~LoadGenerator();
+
+    bool isErrorState();
+    QString errorInfo();
+    bool run();
+
+    qint64 sentCount() const;
+    qint64 succeededCount() const;
+    qint64 failedCount() const;
+    qint64 skippedCount() const;
+    double throughput() const;
+    double latencyPercentile(double percentile) const;
+    QMap<QString, int> errorBreakdown() const;
+    QString report() const;
+
+signals:
+    void errorEncountered(const QString &errMessage);
+
+private slots:
+    void sendNext();
+    void tick();
+    void stop();
+    void callFinished(const QWebMethodCall &call);
+
+private:
+    struct Target
+    {
+        QString operation;
+        QWebMethod *method;
+        QMap<QString, QVariant> types;
+    };
+
+    bool parseArguments(const QStringList &arguments);
+    bool prepareTargets();
+    void displayHelp();
+    void send(qint64 scheduledAt);
+    void recordCall(const QWebMethodCall &call, qint64 scheduledAt);
+    void finishIfDone();
+    QString textReport() const;
+    QString jsonReport() const;
+
+    bool enterErrorState(const QString &errMessage = QString());
+
+    bool errorState;
+    QString errorMessage;
+
+    // Options
+    QString wsdlPath;
+    QString host;
+    QStringList operations;
+    QString templatePath;
+    QWebMethod::Protocol protocol;
+    QWebMethod::HttpTransport transport;
+    int concurrency;
+    double rate;
+    int duration;
+    qint64 requestLimit;
+    int timeout;
+    int connections;
+    quint32 seed;
+    bool jsonOutput;
+
+    QWsdl *wsdl;
+    ParameterGenerator *generator;
+    QList<Target> targets;
+    int nextTarget;
+
+    // Run state
+    QEventLoop loop;
+    QTimer ticker;
+    QElapsedTimer clock;
+    bool stopping;
+    int inFlight;
+    qint64 sent;
+    qint64 skipped;
+    qint64 elapsed;
+    QHash<quint64, qint64> scheduled;
+
+    // Results
+    QVector<qint64> latencies;
+    qint64 failed;
+    QMap<QString, int> errors;
+    QMap<QString, int> callsPerOperation;
+};
+
+#endif // LOADGENERATOR_H
@@ -0,0 +1,45 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the qtWsBench tool.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef PARAMETERGENERATOR_H
+#define PARAMETERGENERATOR_H
+
+#include <QtCore/qmap.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qvariant.h>
+
+#include <random>
+
+class ParameterGenerator
+{
+public:
+    explicit ParameterGenerator(quint32 seed = 0);
+
+    bool loadTemplate(const QString &path, QString *errorMessage = 0);
+    QMap<QString, QVariant> parameters(const QString &operation,
+                                       const QMap<QString, QVariant> &types);
+    QVariant randomValue(const QVariant &type);
+
+private:
+    int randomInt(int min, int max);
+    QString randomString();
+
+    std::mt19937 engine;
+    QMap<QString, QVariantMap> templates;
+};
+
+#endif // PARAMETERGENERATOR_H
@@ -0,0 +1,20 @@
+include(../buildInfo.pri)
+
+TARGET   = qtwsbench
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+include(../libraryIncludes.pri)
+
+DESTDIR = $${BUILD_DIRECTORY}/qtwsbench
+OBJECTS_DIR = $${BUILD_DIRECTORY}/qtwsbench
+MOC_DIR = $${BUILD_DIRECTORY}/qtwsbench
+
+SOURCES += sources/main.cpp \
+    sources/loadgenerator.cpp \
+    sources/parametergenerator.cpp
+
+HEADERS += headers/loadgenerator.h \
+    headers/parametergenerator.h
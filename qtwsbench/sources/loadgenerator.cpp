@@ -0,0 +1,621 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the qtWsBench tool.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/loadgenerator.h"
+
+#include <qwebscheduler.h>
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+
+#include <algorithm>
+#include <cmath>
+
+/*!
+    \class LoadGenerator
+    \brief Main class of qtwsbench, drives load against a web service.
+
+    Loads a WSDL file, and calls its operations (all, or those chosen
+    with --operation), filling parameters with ParameterGenerator.
+
+    In closed loop mode (default), --concurrency calls are kept in flight:
+    a new call is sent whenever one finishes. In open loop mode (--rate),
+    calls are sent at a fixed rate, no matter how fast the service answers,
+    and latency is measured from the time each call was due, so that
+    a slow service is not hidden by fewer calls being sent. Calls which
+    would exceed --concurrency are skipped, and counted.
+
+    Run stops after --duration seconds or --requests calls, whichever comes
+    first, and waits for calls in flight.
+  */
+
+/*!
+    Uses application's arguments (\a appArguments, without application
+    name) to set up the run, and \a parent to construct the object.
+  */
+LoadGenerator::LoadGenerator(const QStringList &appArguments, QObject *parent) :
+    QObject(parent), errorState(false), protocol(QWebMethod::Soap12),
+    transport(QWebMethod::Http1), concurrency(1), rate(0), duration(10),
+    requestLimit(0), timeout(30000), connections(0), seed(0), jsonOutput(false),
+    wsdl(0), generator(0), nextTarget(0), stopping(false), inFlight(0), sent(0),
+    skipped(0), elapsed(0), failed(0)
+{
+    if (appArguments.isEmpty()
+            || appArguments.contains(QLatin1String("--help"))
+            || appArguments.contains(QLatin1String("-h"))) {
+        displayHelp();
+        return;
+    }
+
+    if (!parseArguments(appArguments))
+        return;
+
+    generator = new ParameterGenerator(seed);
+    if (!templatePath.isEmpty()) {
+        QString message;
+        if (!generator->loadTemplate(templatePath, &message)) {
+            enterErrorState(message);
+            return;
+        }
+    }
+
+    wsdl = new QWsdl(wsdlPath, this);
+    if (wsdl->isErrorState()) {
+        enterErrorState(QLatin1String("WSDL error: ") + wsdl->errorInfo());
+        return;
+    }
+
+    prepareTargets();
+}
+
+/*!
+    Deletes the parameter generator.
+  */
+LoadGenerator::~LoadGenerator()
+{
+    delete generator;
+}
+
+/*!
+    \fn LoadGenerator::errorEncountered(const QString &errMessage)
+
+    Singal emitted when LoadGenerator encounters an error.
+    Carries \a errMessage for convenience.
+  */
+
+/*!
+    Returns true if object is in error state.
+
+    \sa errorInfo()
+  */
+bool LoadGenerator::isErrorState()
+{
+    return errorState;
+}
+
+/*!
+    Returns error message or empty string, when no error was encountered.
+
+    \sa isErrorState()
+  */
+QString LoadGenerator::errorInfo()
+{
+    return errorMessage;
+}
+
+/*!
+    Drives the load, and returns when the run is over (all calls finished).
+    Returns false, if the generator is in error state.
+
+    \sa report()
+  */
+bool LoadGenerator::run()
+{
+    if (errorState) {
+        enterErrorState(QLatin1String("Load generator is in error state and cannot continue."));
+        return false;
+    }
+
+    // Connection cap of QWebScheduler would limit concurrency otherwise.
+    QWebScheduler::setMaxConnectionsPerHost((connections > 0) ? connections
+                                            : qMax(QWebScheduler::maxConnectionsPerHost(),
+                                                   concurrency));
+
+    clock.start();
+    QTimer::singleShot(duration * 1000, this, SLOT(stop()));
+
+    if (rate > 0) {
+        ticker.setTimerType(Qt::PreciseTimer);
+        ticker.setInterval(qBound(1, int(1000 / rate), 100));
+        connect(&ticker, SIGNAL(timeout()), this, SLOT(tick()));
+        ticker.start();
+        tick();
+    } else {
+        for (int i = 0; i < concurrency; i++)
+            sendNext();
+    }
+
+    if (!stopping || (inFlight > 0))
+        loop.exec();
+    return true;
+}
+
+/*!
+    Returns number of calls sent.
+  */
+qint64 LoadGenerator::sentCount() const
+{
+    return sent;
+}
+
+/*!
+    Returns number of calls, which finished without error.
+  */
+qint64 LoadGenerator::succeededCount() const
+{
+    return latencies.size();
+}
+
+/*!
+    Returns number of calls, which finished in error state.
+
+    \sa errorBreakdown()
+  */
+qint64 LoadGenerator::failedCount() const
+{
+    return failed;
+}
+
+/*!
+    Returns number of calls, which were not sent in open loop mode,
+    because --concurrency calls were already in flight.
+  */
+qint64 LoadGenerator::skippedCount() const
+{
+    return skipped;
+}
+
+/*!
+    Returns finished calls per second.
+  */
+double LoadGenerator::throughput() const
+{
+    if (elapsed <= 0)
+        return 0;
+    return (latencies.size() + failed) * 1000000000.0 / elapsed;
+}
+
+/*!
+    Returns latency of successful calls, in milliseconds, at given
+    \a percentile (0 - 100, nearest rank). Returns 0 when no call succeeded.
+  */
+double LoadGenerator::latencyPercentile(double percentile) const
+{
+    if (latencies.isEmpty())
+        return 0;
+
+    QVector<qint64> sorted(latencies);
+    std::sort(sorted.begin(), sorted.end());
+
+    int rank = int(std::ceil(qBound(0.0, percentile, 100.0) / 100.0 * sorted.size()));
+    return sorted.at(qBound(0, rank - 1, sorted.size() - 1)) / 1000000.0;
+}
+
+/*!
+    Returns failed calls, counted by error: HTTP status ("HTTP 503"),
+    or error message (network errors, timeouts).
+  */
+QMap<QString, int> LoadGenerator::errorBreakdown() const
+{
+    return errors;
+}
+
+/*!
+    Returns summary of the run, as text or (with --json) as a JSON document.
+  */
+QString LoadGenerator::report() const
+{
+    return jsonOutput ? jsonReport() : textReport();
+}
+
+/*!
+    \internal
+
+    Closed loop: sends next call, unless the run is stopping.
+  */
+void LoadGenerator::sendNext()
+{
+    if (stopping)
+        return;
+    send(clock.nsecsElapsed());
+}
+
+/*!
+    \internal
+
+    Open loop: sends all calls, which are due by now. Call number n
+    is due n / rate seconds after start.
+  */
+void LoadGenerator::tick()
+{
+    qint64 now = clock.nsecsElapsed();
+    qint64 due = qint64(now / 1000000000.0 * rate) + 1;
+
+    while (!stopping && (sent + skipped < due)) {
+        qint64 scheduledAt = qint64((sent + skipped) * 1000000000.0 / rate);
+        if (inFlight >= concurrency) {
+            ++skipped;
+            continue;
+        }
+        send(scheduledAt);
+    }
+}
+
+/*!
+    \internal
+
+    Stops sending calls. Run finishes when calls in flight are done.
+  */
+void LoadGenerator::stop()
+{
+    stopping = true;
+    ticker.stop();
+    finishIfDone();
+}
+
+/*!
+    \internal
+
+    Records result of a \a call in flight.
+  */
+void LoadGenerator::callFinished(const QWebMethodCall &call)
+{
+    if (!scheduled.contains(call.id()))
+        return;
+
+    qint64 scheduledAt = scheduled.take(call.id());
+    --inFlight;
+    recordCall(call, scheduledAt);
+    finishIfDone();
+}
+
+/*!
+    \internal
+
+    Records result of finished \a call, sent at \a scheduledAt, and sends
+    next call in closed loop mode.
+  */
+void LoadGenerator::recordCall(const QWebMethodCall &call, qint64 scheduledAt)
+{
+    qint64 latency = clock.nsecsElapsed() - scheduledAt;
+    callsPerOperation[call.methodName()]++;
+
+    if (call.isErrorState()) {
+        ++failed;
+        if (call.httpStatusCode() >= 400)
+            errors[QString(QLatin1String("HTTP %1")).arg(call.httpStatusCode())]++;
+        else
+            errors[call.errorInfo()]++;
+    } else {
+        latencies.append(latency);
+    }
+
+    if (rate <= 0) {
+        // Queued, so that calls failing at once do not recurse.
+        QMetaObject::invokeMethod(this, "sendNext", Qt::QueuedConnection);
+    }
+}
+
+/*!
+    \internal
+
+    Sends a call of the next operation (round robin), and records the time
+    (\a scheduledAt, in nanoseconds since start) latency is measured from.
+  */
+void LoadGenerator::send(qint64 scheduledAt)
+{
+    const Target &target = targets.at(nextTarget);
+    nextTarget = (nextTarget + 1) % targets.size();
+
+    target.method->setParameters(generator->parameters(target.operation, target.types));
+    QWebMethodCall call = target.method->invoke();
+    ++sent;
+
+    if (call.isFinished()) {
+        // Call has failed inside invoke(), before it could be tracked.
+        recordCall(call, scheduledAt);
+    } else {
+        ++inFlight;
+        scheduled.insert(call.id(), scheduledAt);
+    }
+
+    if ((requestLimit > 0) && (sent >= requestLimit))
+        stop();
+}
+
+/*!
+    \internal
+
+    Quits the run, when it is stopping and no calls are in flight.
+  */
+void LoadGenerator::finishIfDone()
+{
+    if (!stopping || (inFlight > 0))
+        return;
+
+    if (elapsed == 0)
+        elapsed = clock.nsecsElapsed();
+    loop.quit();
+}
+
+/*!
+    \internal
+
+    Reads application's command line.
+  */
+bool LoadGenerator::parseArguments(const QStringList &arguments)
+{
+    foreach (const QString &s, arguments) {
+        QString value = s.section(QLatin1Char('='), 1);
+        bool ok = true;
+
+        if (s == QLatin1String("--soap") || s == QLatin1String("--soap12")) {
+            protocol = QWebMethod::Soap12;
+        } else if (s == QLatin1String("--json")) {
+            protocol = QWebMethod::Json;
+        } else if (s == QLatin1String("--xml")) {
+            protocol = QWebMethod::Xml;
+        } else if (s == QLatin1String("--http")) {
+            protocol = QWebMethod::Http;
+        } else if (s.startsWith(QLatin1String("--transport="))) {
+            if (value == QLatin1String("http1"))
+                transport = QWebMethod::Http1;
+            else if (value == QLatin1String("http2"))
+                transport = QWebMethod::Http2;
+            else if (value == QLatin1String("h2c"))
+                transport = QWebMethod::Http2Direct;
+            else
+                ok = false;
+        } else if (s.startsWith(QLatin1String("--host="))) {
+            host = value;
+        } else if (s.startsWith(QLatin1String("--operation="))) {
+            operations += value.split(QLatin1Char(','), QString::SkipEmptyParts);
+        } else if (s.startsWith(QLatin1String("--template="))) {
+            templatePath = value;
+        } else if (s.startsWith(QLatin1String("--concurrency="))) {
+            concurrency = value.toInt(&ok);
+            ok = ok && (concurrency > 0);
+        } else if (s.startsWith(QLatin1String("--rate="))) {
+            rate = value.toDouble(&ok);
+            ok = ok && (rate > 0);
+        } else if (s.startsWith(QLatin1String("--duration="))) {
+            duration = value.toInt(&ok);
+            ok = ok && (duration > 0);
+        } else if (s.startsWith(QLatin1String("--requests="))) {
+            requestLimit = value.toLongLong(&ok);
+            ok = ok && (requestLimit > 0);
+        } else if (s.startsWith(QLatin1String("--timeout="))) {
+            timeout = value.toInt(&ok);
+            ok = ok && (timeout >= 0);
+        } else if (s.startsWith(QLatin1String("--connections="))) {
+            connections = value.toInt(&ok);
+            ok = ok && (connections > 0);
+        } else if (s.startsWith(QLatin1String("--seed="))) {
+            seed = value.toUInt(&ok);
+        } else if (s == QLatin1String("--json-report")) {
+            jsonOutput = true;
+        } else if (s.startsWith(QLatin1String("-"))) {
+            return enterErrorState(QLatin1String("Unrecognised option: ") + s);
+        } else if (wsdlPath.isEmpty()) {
+            QFileInfo file(s);
+            wsdlPath = file.exists() ? file.absoluteFilePath() : s;
+        } else {
+            return enterErrorState(QLatin1String("Unexpected argument: ") + s);
+        }
+
+        if (!ok)
+            return enterErrorState(QLatin1String("Invalid value: ") + s);
+    }
+
+    if (wsdlPath.isEmpty())
+        return enterErrorState(QLatin1String("WSDL file or URL is missing."));
+
+    return true;
+}
+
+/*!
+    \internal
+
+    Creates a web method for each operation to call. SOAP calls go to
+    the host (from WSDL, or --host), other protocols to host path followed
+    by operation name.
+  */
+bool LoadGenerator::prepareTargets()
+{
+    QMap<QString, QWebMethod *> *methods = wsdl->methods();
+
+    if (operations.isEmpty())
+        operations = methods->keys();
+
+    foreach (const QString &operation, operations) {
+        QWebMethod *source = methods->value(operation);
+        if (source == 0)
+            return enterErrorState(QLatin1String("No such operation in WSDL: ") + operation);
+
+        QUrl url = host.isEmpty() ? source->hostUrl() : QUrl(host);
+        if (url.scheme().isEmpty() || url.host().isEmpty()) {
+            return enterErrorState(QLatin1String("WSDL has no usable endpoint for ")
+                                   + operation + QLatin1String(", use --host="));
+        }
+
+        if (!(protocol & QWebMethod::Soap)) {
+            QString path = url.path();
+            if (!path.endsWith(QLatin1Char('/')))
+                path += QLatin1Char('/');
+            url.setPath(path + operation);
+        }
+
+        Target target;
+        target.operation = operation;
+        target.types = source->parameterNamesTypes();
+        target.method = new QWebMethod(url, protocol, QWebMethod::Post, this);
+        target.method->setMethodName(operation);
+        target.method->setTargetNamespace(source->targetNamespace());
+        target.method->setHttpTransport(transport);
+        target.method->setTimeout(timeout);
+        connect(target.method, SIGNAL(callFinished(QWebMethodCall)),
+                this, SLOT(callFinished(QWebMethodCall)));
+        targets.append(target);
+    }
+
+    if (targets.isEmpty())
+        return enterErrorState(QLatin1String("WSDL has no operations."));
+
+    return true;
+}
+
+/*!
+    \internal
+
+    Displays help.
+  */
+void LoadGenerator::displayHelp()
+{
+    QString helpMessage = QLatin1String(
+    "qtwsbench [options] <WSDL file or URL>\n\n"
+    "Possible options:\n"
+    "    --help (-h),\n"
+    "    --soap12 (--soap), --json, --xml, --http,\n"
+    "    --transport={http1, http2, h2c},\n"
+    "    --host=, (URL of the service, overrides WSDL),\n"
+    "    --operation=, (can be repeated, or comma separated; defaults to all),\n"
+    "    --template=, (JSON file with parameter values),\n"
+    "    --concurrency=, (calls in flight),\n"
+    "    --rate=, (calls per second; open loop),\n"
+    "    --duration=, (seconds), --requests=, (calls to send),\n"
+    "    --timeout=, (milliseconds per call), --connections=, (per host),\n"
+    "    --seed=, (of random parameter values),\n"
+    "    --json-report.\n\n"
+    "Default switches are: \n"
+    "--soap12, --transport=http1, --concurrency=1, --duration=10, --timeout=30000.\n"
+    "JSON, XML and HTTP calls go to host path followed by operation name.\n"
+    "Example use: qtwsbench --host=http://127.0.0.1:8080/band_ws.asmx --rate=200 "
+    "--concurrency=64 ../examples/wsdl/band_ws.asmx\n");
+    enterErrorState(helpMessage);
+}
+
+/*!
+    \internal
+
+    Returns report as text.
+  */
+QString LoadGenerator::textReport() const
+{
+    QString result;
+    QString mode = (rate > 0) ?
+                QString(QLatin1String("open loop, %1 calls/s, at most %2 in flight"))
+                .arg(rate).arg(concurrency)
+              : QString(QLatin1String("closed loop, %1 in flight")).arg(concurrency);
+
+    result += QString(QLatin1String("qtwsbench: %1, %2 operation(s), %3\n"))
+            .arg(wsdl->webServiceName()).arg(targets.size()).arg(mode);
+    result += QString(QLatin1String("Calls:      %1 sent, %2 succeeded, %3 failed, %4 skipped\n"))
+            .arg(sent).arg(latencies.size()).arg(failed).arg(skipped);
+    result += QString(QLatin1String("Duration:   %1 s\n")).arg(elapsed / 1000000000.0, 0, 'f', 2);
+    result += QString(QLatin1String("Throughput: %1 calls/s\n")).arg(throughput(), 0, 'f', 1);
+    result += QString(QLatin1String("Latency:    min %1 ms, p50 %2 ms, p90 %3 ms, p99 %4 ms, "
+                                    "p99.9 %5 ms, max %6 ms\n"))
+            .arg(latencyPercentile(0), 0, 'f', 2)
+            .arg(latencyPercentile(50), 0, 'f', 2)
+            .arg(latencyPercentile(90), 0, 'f', 2)
+            .arg(latencyPercentile(99), 0, 'f', 2)
+            .arg(latencyPercentile(99.9), 0, 'f', 2)
+            .arg(latencyPercentile(100), 0, 'f', 2);
+
+    if (!errors.isEmpty()) {
+        result += QLatin1String("Errors:\n");
+        QMap<QString, int>::const_iterator i = errors.constBegin();
+        for (; i != errors.constEnd(); ++i)
+            result += QString(QLatin1String("    %1: %2\n")).arg(i.key()).arg(i.value());
+    }
+
+    result += QLatin1String("Operations:\n");
+    QMap<QString, int>::const_iterator i = callsPerOperation.constBegin();
+    for (; i != callsPerOperation.constEnd(); ++i)
+        result += QString(QLatin1String("    %1: %2\n")).arg(i.key()).arg(i.value());
+
+    return result;
+}
+
+/*!
+    \internal
+
+    Returns report as JSON document. Times are in milliseconds.
+  */
+QString LoadGenerator::jsonReport() const
+{
+    QJsonObject latency;
+    latency.insert(QLatin1String("min"), latencyPercentile(0));
+    latency.insert(QLatin1String("p50"), latencyPercentile(50));
+    latency.insert(QLatin1String("p90"), latencyPercentile(90));
+    latency.insert(QLatin1String("p99"), latencyPercentile(99));
+    latency.insert(QLatin1String("p99.9"), latencyPercentile(99.9));
+    latency.insert(QLatin1String("max"), latencyPercentile(100));
+
+    QJsonObject errorCounts;
+    QMap<QString, int>::const_iterator i = errors.constBegin();
+    for (; i != errors.constEnd(); ++i)
+        errorCounts.insert(i.key(), i.value());
+
+    QJsonObject operationCounts;
+    for (i = callsPerOperation.constBegin(); i != callsPerOperation.constEnd(); ++i)
+        operationCounts.insert(i.key(), i.value());
+
+    QJsonObject result;
+    result.insert(QLatin1String("service"), wsdl->webServiceName());
+    result.insert(QLatin1String("mode"), (rate > 0) ? QLatin1String("open")
+                                                    : QLatin1String("closed"));
+    result.insert(QLatin1String("concurrency"), concurrency);
+    result.insert(QLatin1String("rate"), rate);
+    result.insert(QLatin1String("sent"), double(sent));
+    result.insert(QLatin1String("succeeded"), latencies.size());
+    result.insert(QLatin1String("failed"), double(failed));
+    result.insert(QLatin1String("skipped"), double(skipped));
+    result.insert(QLatin1String("duration"), elapsed / 1000000.0);
+    result.insert(QLatin1String("throughput"), throughput());
+    result.insert(QLatin1String("latency"), latency);
+    result.insert(QLatin1String("errors"), errorCounts);
+    result.insert(QLatin1String("operations"), operationCounts);
+
+    return QString::fromUtf8(QJsonDocument(result).toJson());
+}
+
+/*!
+    \internal
+
+    Enters into error state with message \a errMessage.
+  */
+bool LoadGenerator::enterErrorState(const QString &errMessage)
+{
+    errorState = true;
+    errorMessage += errMessage + QLatin1String("\n");
+    emit errorEncountered(errMessage);
+    return false;
+}
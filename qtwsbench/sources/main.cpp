@@ -0,0 +1,41 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the qtWsBench tool.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include <QtCore/qcoreapplication.h>
+#include "../headers/loadgenerator.h"
+
+#include <cstdio>
+
+/**
+  * qtwsbench's main routine.
+  */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    LoadGenerator generator(a.arguments().mid(1));
+    if (!generator.isErrorState())
+        generator.run();
+
+    if (generator.isErrorState()) {
+        fputs(generator.errorInfo().toLocal8Bit().constData(), stderr);
+        return 1;
+    }
+
+    fputs(generator.report().toLocal8Bit().constData(), stdout);
+    return 0;
+}
@@ -0,0 +1,167 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the qtWsBench tool.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "../headers/parametergenerator.h"
+
+#include <QtCore/qdatetime.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qstringlist.h>
+
+/*!
+    \class ParameterGenerator
+    \brief Fills parameters of web methods, for qtwsbench.
+
+    Values are taken from a template (see loadTemplate()). Parameters
+    missing from the template get random values of the right type.
+  */
+
+/*!
+    Constructs the generator. Random values are reproducible, when
+    \a seed is not 0.
+  */
+ParameterGenerator::ParameterGenerator(quint32 seed) :
+    engine(seed ? seed : std::random_device()())
+{
+}
+
+/*!
+    Reads template from JSON file at \a path. Template is an object,
+    with operation names as keys, and objects of parameter values
+    as values. Values under "*" key are used by all operations:
+
+    \code
+    { "*": { "genre": "rock" }, "getBandName": { "bandId": 7 } }
+    \endcode
+
+    Returns false, and sets \a errorMessage, if the file cannot be read.
+  */
+bool ParameterGenerator::loadTemplate(const QString &path, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage)
+            *errorMessage = QLatin1String("Cannot read template file: ") + path;
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        if (errorMessage) {
+            *errorMessage = QLatin1String("Template is not a JSON object: ")
+                    + parseError.errorString();
+        }
+        return false;
+    }
+
+    templates.clear();
+    QVariantMap operations = document.object().toVariantMap();
+    QVariantMap::const_iterator i = operations.constBegin();
+    for (; i != operations.constEnd(); ++i)
+        templates.insert(i.key(), i.value().toMap());
+
+    return true;
+}
+
+/*!
+    Returns parameters of \a operation, with names and types
+    given in \a types (see QWebMethod::parameterNamesTypes()).
+  */
+QMap<QString, QVariant> ParameterGenerator::parameters(const QString &operation,
+                                                       const QMap<QString, QVariant> &types)
+{
+    QMap<QString, QVariant> result;
+    QVariantMap common = templates.value(QLatin1String("*"));
+    QVariantMap own = templates.value(operation);
+
+    QMap<QString, QVariant>::const_iterator i = types.constBegin();
+    for (; i != types.constEnd(); ++i) {
+        if (own.contains(i.key()))
+            result.insert(i.key(), own.value(i.key()));
+        else if (common.contains(i.key()))
+            result.insert(i.key(), common.value(i.key()));
+        else
+            result.insert(i.key(), randomValue(i.value()));
+    }
+
+    return result;
+}
+
+/*!
+    Returns a random value of given \a type. Unknown types get
+    a random string.
+  */
+QVariant ParameterGenerator::randomValue(const QVariant &type)
+{
+    switch (type.userType()) {
+    case QMetaType::Int:
+    case QMetaType::LongLong:
+        return QVariant(randomInt(-1000000, 1000000));
+    case QMetaType::UInt:
+    case QMetaType::ULongLong:
+        return QVariant(randomInt(0, 1000000));
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return QVariant(randomInt(0, 10000000) / 100.0);
+    case QMetaType::Bool:
+        return QVariant(randomInt(0, 1) == 1);
+    case QMetaType::QChar:
+        return QVariant(QChar(QLatin1Char(char('a' + randomInt(0, 25)))));
+    case QMetaType::QDate:
+        return QVariant(QDate::currentDate().addDays(-randomInt(0, 3650)));
+    case QMetaType::QTime:
+        return QVariant(QTime(0, 0).addSecs(randomInt(0, 86399)));
+    case QMetaType::QDateTime:
+        return QVariant(QDateTime::currentDateTime().addSecs(-randomInt(0, 315360000)));
+    case QMetaType::QStringList: {
+        QStringList list;
+        for (int i = randomInt(1, 5); i > 0; --i)
+            list.append(randomString());
+        return QVariant(list);
+    }
+    default:
+        return QVariant(randomString());
+    }
+}
+
+/*!
+    \internal
+
+    Returns a random number from \a min to \a max (inclusive).
+  */
+int ParameterGenerator::randomInt(int min, int max)
+{
+    return std::uniform_int_distribution<int>(min, max)(engine);
+}
+
+/*!
+    \internal
+
+    Returns a random alphanumeric string, 4 to 16 characters long.
+  */
+QString ParameterGenerator::randomString()
+{
+    static const char characters[] =
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    QString result;
+    for (int i = randomInt(4, 16); i > 0; --i)
+        result += QLatin1Char(characters[randomInt(0, int(sizeof(characters)) - 2)]);
+    return result;
+}
@@ -326,20 +326,9 @@ bool MethodGenerator::createSubclassedMethodSource(QWebMethod *mtd)
             toInsert += tempS + "parent);" + flags->endLine();
         }
         toInsert += flags->endLine() + flags->tab()
-                + "qsm.invokeMethod();" + flags->endLine()
+                + "qsm.invokeAndWait();" + flags->endLine()
                 + flags->tab() + "// TODO: ADD ERROR HANDLING!" + flags->endLine()
-                + flags->tab() + "forever" + flags->endLine()
-                + flags->tab() + "{" + flags->endLine()
-                + flags->tab() + flags->tab() + "if (qsm.isReplyReady())" + flags->endLine()
-                + flags->tab() + flags->tab() + flags->tab() + "return qsm.replyRead();"
-                + flags->endLine()
-                + flags->tab() + flags->tab() + "else" + flags->endLine()
-                + flags->tab() + flags->tab() + "{" + flags->endLine()
-                + flags->tab() + flags->tab() + flags->tab()
-                + "QCoreApplication::instance()->processEvents();"
-                + flags->endLine()
-                + flags->tab() + flags->tab() + "}" + flags->endLine()
-                + flags->tab() + "}" + flags->endLine()
+                + flags->tab() + "return qsm.replyRead();" + flags->endLine()
                 + "}";
 
         methodSource.insert(beginIndex, toInsert);
@@ -623,17 +612,10 @@ bool MethodGenerator::createMethodSource(QWebMethod *mtd)
         }
         tempS.chop(2);
 
-        // Add waiting loop.
+        // Wait for the reply in a local event loop.
         body += tempS + ");" + flags->endLine()
-                + flags->tab() + "qsm.invokeMethod();" + flags->endLine()
-                + flags->tab() + "forever {" + flags->endLine()
-                + flags->tab() + flags->tab() + "if (qsm.isReplyReady()) {" + flags->endLine()
-                + flags->tab() + flags->tab() + flags->tab() + "return qsm.replyRead();" + flags->endLine()
-                + flags->tab() + flags->tab() + "} else {" + flags->endLine()
-                + flags->tab() + flags->tab() + flags->tab()
-                + "QCoreApplication::instance()->processEvents();" + flags->endLine()
-                + flags->tab() + flags->tab() + "}"  +flags->endLine()
-                + flags->tab() + "}" + flags->endLine()
+                + flags->tab() + "qsm.invokeAndWait();" + flags->endLine()
+                + flags->tab() + "return qsm.replyRead();" + flags->endLine()
                 + "}" + flags->endLine();
         methodSource.insert(beginIndex, flags->endLine() + body);
     }
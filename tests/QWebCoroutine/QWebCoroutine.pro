@@ -0,0 +1,15 @@
+include(../../buildInfo.pri)
+
+QT += testlib
+# Coroutines (see qwebcoroutine.h).
+CONFIG += c++2a
+
+include(../../libraryIncludes.pri)
+
+DESTDIR = $${TESTS_DIRECTORY}/QWebCoroutine
+OBJECTS_DIR = $${TESTS_DIRECTORY}/QWebCoroutine
+MOC_DIR = $${TESTS_DIRECTORY}/QWebCoroutine
+
+SOURCES += tst_qwebcoroutine.cpp
+
+include(../shared/shared.pri)
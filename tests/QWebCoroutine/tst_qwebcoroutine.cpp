@@ -0,0 +1,135 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService test suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <qwebmethod.h>
+#include <qwebservice.h>
+#include <qwebcoroutine.h>
+#include <standinserver.h>
+
+/**
+  This test checks awaiting web method calls in C++20 coroutines. Does not
+  require Internet connection - calls go to a stand-in server.
+  */
+class TestQWebCoroutine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void awaitTest();
+    void fanOutTest();
+
+#ifdef QWEBSERVICE_HAS_COROUTINES
+private:
+    static QWebTask awaitCalls(QWebMethod *method, QWebService *service,
+                               QStringList *results);
+    static QWebTask awaitOne(QWebMethod *method, int *succeeded, int *finished);
+#endif
+};
+
+#ifdef QWEBSERVICE_HAS_COROUTINES
+/*
+  Awaits calls one after another: of a web method, of a web service,
+  and one that fails. Results (or errors) are appended to \a results.
+  */
+QWebTask TestQWebCoroutine::awaitCalls(QWebMethod *method, QWebService *service,
+                                       QStringList *results)
+{
+    QWebMethodCall call = co_await method->invoke();
+    results->append(call.result().toString());
+
+    call = co_await service->invoke(QLatin1String("standIn"));
+    results->append(call.result().toString());
+
+    QWebMethod broken(QUrl(QLatin1String("http://127.0.0.1:1/")), QWebMethod::Soap12);
+    call = co_await broken.invoke();
+    results->append(call.isErrorState() ? QLatin1String("error") : QLatin1String("no error"));
+}
+
+QWebTask TestQWebCoroutine::awaitOne(QWebMethod *method, int *succeeded, int *finished)
+{
+    QWebMethodCall call = co_await method->invoke();
+    if (!call.isErrorState())
+        ++*succeeded;
+    ++*finished;
+}
+#endif
+
+void TestQWebCoroutine::awaitTest()
+{
+#ifndef QWEBSERVICE_HAS_COROUTINES
+    QSKIP("Compiler does not support C++20 coroutines.");
+#else
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    QWebMethod *serviceMethod = new QWebMethod(server.url(), QWebMethod::Soap12,
+                                               QWebMethod::Post);
+    serviceMethod->setMethodName("standIn");
+    QWebService service;
+    service.addMethod(serviceMethod);
+
+    QStringList results;
+    awaitCalls(method, &service, &results);
+    // Coroutine is suspended on the first call.
+    QCOMPARE(results.size(), int(0));
+
+    for (int i = 0; (i < 50) && (results.size() < 3); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(results, QStringList() << "OK" << "OK" << "error");
+    delete method;
+#endif
+}
+
+/*
+  Fans out calls, each awaited in its own coroutine, and checks that
+  all of them are finished. Overhead is measured by benchmarks/QWebCoroutine.
+  */
+void TestQWebCoroutine::fanOutTest()
+{
+#ifndef QWEBSERVICE_HAS_COROUTINES
+    QSKIP("Compiler does not support C++20 coroutines.");
+#else
+    const int callCount = 50;
+
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod method(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method.setMethodName("standIn");
+
+    int succeeded = 0;
+    int finished = 0;
+    for (int i = 0; i < callCount; i++)
+        awaitOne(&method, &succeeded, &finished);
+    // Coroutines are suspended on their calls.
+    QCOMPARE(finished, int(0));
+
+    for (int i = 0; (i < 100) && (finished < callCount); i++)
+        QTest::qWait(50);
+
+    QCOMPARE(finished, callCount);
+    QCOMPARE(succeeded, callCount);
+    QCOMPARE(method.pendingCallCount(), int(0));
+#endif
+}
+
+QTEST_MAIN(TestQWebCoroutine)
+#include "tst_qwebcoroutine.moc"
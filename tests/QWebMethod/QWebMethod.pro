@@ -1,6 +1,6 @@
 include(../../buildInfo.pri)
 
-QT += testlib
+QT += testlib concurrent
 
 include(../../libraryIncludes.pri)
 
@@ -9,3 +9,5 @@ OBJECTS_DIR = $${TESTS_DIRECTORY}/QWebMethod
 MOC_DIR = $${TESTS_DIRECTORY}/QWebMethod
 
 SOURCES += tst_qwebmethod.cpp
+
+include(../shared/shared.pri)
@@ -16,7 +16,15 @@
 ****************************************************************************/
 
 #include <QtTest/QtTest>
+#include <QtConcurrent/QtConcurrent>
 #include <qwebmethod.h>
+#include <qwebservicemethod.h>
+#include <qwebnetworkpool.h>
+#include <qwebscheduler.h>
+#include <qwebmetrics.h>
+#include <qwsdl.h>
+#include <qwebcompression_p.h>
+#include <standinserver.h>
 
 /**
   This test checks QWebMethod in operation (requires Internet connection or a working local web service)
@@ -30,6 +38,26 @@ private slots:
     void gettersTest();
     void settersTest();
     void qpropertyTest();
+    void networkPoolTest();
+    void concurrentCallsTest();
+    void requestSerializationTest();
+    void streamingUploadTest();
+    void incrementalParsingTest();
+    void replyDecodingTest();
+    void jsonDecodingTest();
+    void compressionTest();
+    void http2Test();
+    void synchronousInvokeTest();
+    void futureTest();
+    void schedulerTest();
+    void retryTest();
+    void hedgingTest();
+    void timeoutTest();
+    void coalescingTest();
+    void metricsTest();
+    void timingTest();
+    void standInServerTest();
+    void deleteFromSlotTest();
     void asynchronousSendingTest();
 
 private:
@@ -153,9 +181,1189 @@ void TestQWebMethod::qpropertyTest()
     delete method;
 }
 
+/*
+  Checks that web methods share one network manager per thread,
+  and that they can opt out of sharing.
+  */
+void TestQWebMethod::networkPoolTest()
+{
+    int initialReferences = QWebNetworkPool::referenceCount();
+
+    QWebMethod *method1 = new QWebMethod(0, QWebMethod::Soap12, QWebMethod::Post);
+    QWebMethod *method2 = new QWebMethod(0, QWebMethod::Soap12, QWebMethod::Post);
+    QCOMPARE(method1->isNetworkManagerShared(), bool(true));
+    QCOMPARE(method2->isNetworkManagerShared(), bool(true));
+    QCOMPARE(QWebNetworkPool::referenceCount(), int(initialReferences + 2));
+    QCOMPARE(QWebNetworkPool::managerCount(), int(1));
+
+    method2->setNetworkManagerShared(false);
+    QCOMPARE(method2->isNetworkManagerShared(), bool(false));
+    QCOMPARE(QWebNetworkPool::referenceCount(), int(initialReferences + 1));
+
+    method2->setNetworkManagerShared(true);
+    QCOMPARE(QWebNetworkPool::referenceCount(), int(initialReferences + 2));
+
+    delete method1;
+    delete method2;
+    QCOMPARE(QWebNetworkPool::referenceCount(), int(initialReferences));
+
+    // A thread started again (same QThread address) does not get
+    // the manager left behind by its finished run.
+    QThread worker;
+    QList<QNetworkAccessManager *> managers;
+    connect(&worker, &QThread::started, [&managers]() {
+        managers.append(QWebNetworkPool::acquire());
+        QThread::currentThread()->quit();
+    });
+
+    worker.start();
+    QVERIFY(worker.wait(5000));
+    worker.start();
+    QVERIFY(worker.wait(5000));
+
+    QCOMPARE(managers.size(), int(2));
+    QVERIFY(managers.at(0) != managers.at(1));
+    QCOMPARE(QWebNetworkPool::isShared(managers.at(0)), bool(true));
+
+    foreach (QNetworkAccessManager *manager, managers)
+        QWebNetworkPool::release(manager);
+    QCOMPARE(QWebNetworkPool::isShared(managers.at(0)), bool(false));
+}
+
+/*
+  Checks that many calls can be in flight on one web method, and that
+  each of them gets its own result. Does not need a working server -
+  connection to a closed local port fails quickly.
+  */
+void TestQWebMethod::concurrentCallsTest()
+{
+    QWebMethod *method = new QWebMethod(QUrl("http://127.0.0.1:1/"),
+                                        QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("getProviderList");
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+
+    QWebMethodCall call1 = method->invoke();
+    QWebMethodCall call2 = method->invoke();
+    QCOMPARE(call1.isValid(), bool(true));
+    QCOMPARE(call2.isValid(), bool(true));
+    QVERIFY(call1 != call2);
+    QVERIFY(call1.id() != call2.id());
+    QCOMPARE(call1.methodName(), QString("getProviderList"));
+    QCOMPARE(method->pendingCallCount(), int(2));
+
+    for (int i = 0; (i < 50) && (spy.count() < 2); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(spy.count(), int(2));
+    QCOMPARE(method->pendingCallCount(), int(0));
+    QCOMPARE(call1.isFinished(), bool(true));
+    QCOMPARE(call2.isFinished(), bool(true));
+    QCOMPARE(call1.isErrorState(), bool(true));
+
+    delete method;
+}
+
+/*
+  Checks that parameters are escaped, encoded in UTF-8, and that nested
+  maps and lists are serialized. Checks Content-Type of HTTP requests.
+  */
+void TestQWebMethod::requestSerializationTest()
+{
+    QWebMethod *method = new QWebMethod(QUrl("http://127.0.0.1:1/"),
+                                        QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("bookABand");
+    method->setTargetNamespace("http://tempuri.org/");
+
+    QMap<QString, QVariant> address;
+    address.insert("city", QVariant(QString::fromUtf8("Kraków")));
+    QMap<QString, QVariant> params;
+    params.insert("name", QVariant("Rock & <Roll>"));
+    params.insert("address", QVariant(address));
+    params.insert("dates", QVariant(QStringList() << "a" << "b"));
+    method->setParameters(params);
+
+    QByteArray body = method->invoke().requestData();
+    QVERIFY(body.startsWith("<?xml version=\"1.0\" encoding=\"utf-8\"?><soap12:Envelope"));
+    QVERIFY(body.contains("<bookABand xmlns=\"http://tempuri.org/\">"));
+    QVERIFY(body.contains("<name>Rock &amp; &lt;Roll&gt;</name>"));
+    QVERIFY(body.contains(QString::fromUtf8("<address><city>Kraków</city></address>").toUtf8()));
+    QVERIFY(body.contains("<dates><string>a</string><string>b</string></dates>"));
+    QVERIFY(!body.contains('\t'));
+    QVERIFY(body.endsWith("</bookABand></soap12:Body></soap12:Envelope>"));
+
+    method->setProtocol(QWebMethod::Json);
+    body = method->invoke().requestData();
+    QVERIFY(body.startsWith("{"));
+    QVERIFY(body.contains("\"address\":{\"city\":"));
+
+    StandInServer server;
+    QVERIFY(server.listen());
+    method->setHost(server.url());
+    method->setProtocol(QWebMethod::Http);
+    QWebMethodCall call = method->invoke();
+    QTRY_VERIFY_WITH_TIMEOUT(call.isFinished(), 5000);
+    QVERIFY(server.lastRequestHeader().contains(
+                "Content-Type: application/x-www-form-urlencoded\r\n"));
+
+    delete method;
+}
+
+/*
+  Checks that request bodies streamed from a device and from a generator
+  reach the server complete.
+  */
+void TestQWebMethod::streamingUploadTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+
+    QBuffer buffer;
+    buffer.setData(QByteArray(100000, 'a'));
+    buffer.open(QIODevice::ReadOnly);
+    QWebMethodCall deviceCall = method->invoke(&buffer);
+    QCOMPARE(deviceCall.isValid(), bool(true));
+    QCOMPARE(deviceCall.requestData().isEmpty(), bool(true));
+
+    int pieces = 0;
+    QWebMethodCall generatorCall = method->invoke([&pieces]() -> QByteArray {
+        return (pieces++ < 10) ? QByteArray(10000, 'b') : QByteArray();
+    }, 100000);
+    QCOMPARE(generatorCall.isValid(), bool(true));
+
+    for (int i = 0; (i < 50) && (spy.count() < 2); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(spy.count(), int(2));
+    QCOMPARE(deviceCall.isErrorState(), bool(false));
+    QCOMPARE(generatorCall.isErrorState(), bool(false));
+    QCOMPARE(server.bytesReceived(), qint64(200000));
+    QVERIFY(server.lastRequestHeader().contains("100000"));
+
+    QWebMethodCall invalidCall = method->invoke(static_cast<QIODevice *>(0));
+    QCOMPARE(invalidCall.isValid(), bool(false));
+    QCOMPARE(method->isErrorState(), bool(true));
+
+    delete method;
+}
+
+/*
+  Checks that items of XML and JSON replies are reported one by one
+  in incremental parsing mode.
+  */
+void TestQWebMethod::incrementalParsingTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReply("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                    "<soap12:Envelope xmlns:soap12=\"http://www.w3.org/2003/05/soap-envelope\">"
+                    "<soap12:Body><getBandsResponse xmlns=\"http://tempuri.org/\">"
+                    "<band><name>Rock &amp; Roll</name><members>4</members></band>"
+                    "<band><name><![CDATA[Blues]]></name><members>3</members></band>"
+                    "</getBandsResponse></soap12:Body></soap12:Envelope>");
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("getBands");
+    QCOMPARE(method->isIncrementalParsing(), bool(false));
+    method->setIncrementalParsing(true);
+    QCOMPARE(method->property("incrementalParsing").toBool(), bool(true));
+
+    QSignalSpy itemSpy(method, SIGNAL(replyItemReceived(QWebMethodCall,QString,QVariant)));
+    QSignalSpy finishedSpy(method, SIGNAL(callFinished(QWebMethodCall)));
+
+    QWebMethodCall call = method->invoke();
+    for (int i = 0; (i < 50) && (finishedSpy.count() < 1); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(finishedSpy.count(), int(1));
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.replyReadRaw().isEmpty(), bool(true));
+    QCOMPARE(itemSpy.count(), int(4));
+    QCOMPARE(itemSpy.at(0).at(1).toString(), QString("name"));
+    QCOMPARE(itemSpy.at(0).at(2).toString(), QString("Rock & Roll"));
+    QCOMPARE(itemSpy.at(1).at(1).toString(), QString("members"));
+    QCOMPARE(itemSpy.at(2).at(2).toString(), QString("Blues"));
+
+    server.setReply("[{\"name\": \"a, [b]\"}, 2, \"three\"]", "application/json");
+    method->setProtocol(QWebMethod::Json);
+    itemSpy.clear();
+    call = method->invoke();
+    for (int i = 0; (i < 50) && (finishedSpy.count() < 2); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(itemSpy.count(), int(3));
+    QCOMPARE(itemSpy.at(0).at(2).toMap().value("name").toString(), QString("a, [b]"));
+    QCOMPARE(itemSpy.at(1).at(2).toInt(), int(2));
+    QCOMPARE(itemSpy.at(2).at(2).toString(), QString("three"));
+
+    server.setReply("{\"broken\": ", "application/json");
+    call = method->invoke();
+    for (int i = 0; (i < 50) && (finishedSpy.count() < 3); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(call.isErrorState(), bool(true));
+
+    delete method;
+}
+
+/*
+  Checks that SOAP replies are decoded into values of types given
+  in return value map.
+  */
+void TestQWebMethod::replyDecodingTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReply("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                    "<soap:Envelope xmlns:soap=\"http://schemas.xmlsoap.org/soap/envelope/\">"
+                    "<soap:Header><session>1</session></soap:Header>"
+                    "<soap:Body><getBandResponse xmlns=\"http://tempuri.org/\">"
+                    "<members>4</members><rating>4.5</rating><active>true</active>"
+                    "<founded>1962-07-12T00:00:00</founded>"
+                    "<albums><string>Aftermath</string><string>Let It Bleed</string></albums>"
+                    "<sales><int>10</int><int>20</int></sales>"
+                    "<label><name>Decca &amp; co.</name></label>"
+                    "</getBandResponse></soap:Body></soap:Envelope>");
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("getBand");
+
+    QMap<QString, QVariant> returnValue;
+    returnValue.insert("members", QVariant(int()));
+    returnValue.insert("rating", QVariant(double()));
+    returnValue.insert("active", QVariant(bool()));
+    returnValue.insert("founded", QVariant(QDateTime()));
+    returnValue.insert("albums", QVariant(QStringList()));
+    returnValue.insert("sales", QVariant(QList<QVariant>()));
+    method->setReturnValue(returnValue);
+
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+    method->invoke();
+    for (int i = 0; (i < 50) && (spy.count() < 1); i++)
+        QTest::qWait(100);
+    QCOMPARE(spy.count(), int(1));
+
+    QVariantMap result = method->replyReadParsed().toMap();
+    QCOMPARE(result.value("members").userType(), int(QMetaType::Int));
+    QCOMPARE(result.value("members").toInt(), int(4));
+    QCOMPARE(result.value("rating").toDouble(), double(4.5));
+    QCOMPARE(result.value("active").userType(), int(QMetaType::Bool));
+    QCOMPARE(result.value("active").toBool(), bool(true));
+    QCOMPARE(result.value("founded").toDateTime(), QDateTime(QDate(1962, 7, 12), QTime(0, 0)));
+    QCOMPARE(result.value("albums").toStringList(),
+             QStringList() << "Aftermath" << "Let It Bleed");
+    QCOMPARE(result.value("sales").toList().at(1).toInt(), int(20));
+    QCOMPARE(result.value("label").toMap().value("name").toString(), QString("Decca & co."));
+    QVERIFY(!result.contains("session"));
+    QCOMPARE(method->replyReadParsed().toMap(), result);
+
+    server.setReply("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                    "<soap12:Envelope xmlns:soap12=\"http://www.w3.org/2003/05/soap-envelope\">"
+                    "<soap12:Body><soap12:Fault><soap12:Reason>"
+                    "<soap12:Text>No such band</soap12:Text>"
+                    "</soap12:Reason></soap12:Fault></soap12:Body></soap12:Envelope>");
+    method->invoke();
+    for (int i = 0; (i < 50) && (spy.count() < 2); i++)
+        QTest::qWait(100);
+
+    method->replyReadParsed();
+    QCOMPARE(method->isErrorState(), bool(true));
+    QVERIFY(method->errorInfo().contains("No such band"));
+
+    delete method;
+}
+
+/*
+  Checks JSON reply decoding, and picking values with JSON pointers,
+  both before and after the whole document is parsed, and that
+  malformed replies put the method in error state.
+  */
+void TestQWebMethod::jsonDecodingTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReply("{\"count\": 2, \"a/b\": true, \"dup\": 1, \"bands\": ["
+                    "{\"name\": \"The \\\"Stones\\\"\", \"members\": [\"Mick\", \"Keith\"]},"
+                    "{\"name\": \"Beatles\", \"members\": []}], \"dup\": 5}",
+                    "application/json");
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Json, QWebMethod::Post);
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+    method->invoke();
+    for (int i = 0; (i < 50) && (spy.count() < 1); i++)
+        QTest::qWait(100);
+    QCOMPARE(spy.count(), int(1));
+
+    // Not parsed yet.
+    QCOMPARE(method->replyValue("/count").toInt(), int(2));
+    QCOMPARE(method->replyValue("/a~1b").toBool(), bool(true));
+    QCOMPARE(method->replyValue("/bands/0/name").toString(), QString("The \"Stones\""));
+    QCOMPARE(method->replyValue("/bands/0/members/1").toString(), QString("Keith"));
+    QCOMPARE(method->replyValue("/bands/1/name").toString(), QString("Beatles"));
+    QCOMPARE(method->replyValue("/bands/2").isValid(), bool(false));
+    QCOMPARE(method->replyValue("/missing").isValid(), bool(false));
+    QCOMPARE(method->replyValue("/dup").toInt(), int(5));
+
+    QJsonDocument document = method->replyReadJson();
+    QCOMPARE(document.isObject(), bool(true));
+    QCOMPARE(method->replyValue("/bands/0/members/1").toString(), QString("Keith"));
+    QCOMPARE(method->replyValue("/bands/2").isValid(), bool(false));
+    QCOMPARE(method->replyValue("/dup").toInt(), int(5));
+    QCOMPARE(method->replyReadParsed().toMap().value("count").toInt(), int(2));
+    QCOMPARE(method->isErrorState(), bool(false));
+
+    delete method;
+
+    // Malformed replies: pointer, and the reply that is served.
+    QList<QPair<QString, QByteArray> > malformed;
+    malformed << qMakePair(QString("/a"), QByteArray("{\"a\": tru}"))
+              << qMakePair(QString("/a"), QByteArray("{\"a\": \"trunc"))
+              << qMakePair(QString("/a"), QByteArray("{\"a\": [1, 2"))
+              << qMakePair(QString("/a"), QByteArray("{\"\\x\": 1, \"a\": 2}"))
+              << qMakePair(QString(), QByteArray("<?xml version=\"1.0\"?><a>1</a>"));
+
+    for (int i = 0; i < malformed.size(); i++) {
+        server.setReply(malformed.at(i).second, "application/json");
+
+        method = new QWebMethod(server.url(), QWebMethod::Json, QWebMethod::Post);
+        QSignalSpy malformedSpy(method, SIGNAL(callFinished(QWebMethodCall)));
+        method->invoke();
+        for (int j = 0; (j < 50) && (malformedSpy.count() < 1); j++)
+            QTest::qWait(100);
+        QCOMPARE(malformedSpy.count(), int(1));
+
+        QCOMPARE(method->replyValue(malformed.at(i).first).isValid(), bool(false));
+        QCOMPARE(method->replyReadJson().isNull(), bool(true));
+        QCOMPARE(method->isErrorState(), bool(true));
+        delete method;
+    }
+}
+
+/*
+  Checks that big request bodies are gzipped, compressed replies are
+  decompressed, and byte counters are updated.
+  */
+void TestQWebMethod::compressionTest()
+{
+    QByteArray replyBody("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                         "<soap12:Envelope xmlns:soap12=\"http://www.w3.org/2003/05/soap-envelope\">"
+                         "<soap12:Body><echoResponse xmlns=\"http://tempuri.org/\"><echoResult>");
+    replyBody += QByteArray(5000, 'r');
+    replyBody += "</echoResult></echoResponse></soap12:Body></soap12:Envelope>";
+    QByteArray compressedReply = QWebCompressor::gzip(replyBody);
+
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReply(compressedReply);
+    server.setReplyHeader("Content-Encoding", "gzip");
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("echo");
+    method->setTargetNamespace("http://tempuri.org/");
+    QMap<QString, QVariant> params;
+    params.insert("text", QVariant(QString(5000, QChar('p'))));
+    method->setParameters(params);
+    method->setCompressionEnabled(true);
+    method->setCompressionThreshold(100);
+
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+    QWebMethodCall call = method->invoke();
+    for (int i = 0; (i < 50) && (spy.count() < 1); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(call.isErrorState(), bool(false));
+    QVERIFY(server.lastRequestHeader().contains("Content-Encoding: gzip"));
+    QVERIFY(server.lastRequestHeader().contains("Accept-Encoding: gzip, deflate"));
+
+    QWebDecompressor decompressor;
+    QByteArray request = decompressor.decompress(server.lastRequestBody());
+    QVERIFY(request.startsWith("<?xml"));
+    QVERIFY(request.contains(QByteArray(5000, 'p')));
+    QCOMPARE(method->bytesSent(), qint64(server.lastRequestBody().size()));
+    QCOMPARE(method->uncompressedBytesSent(), qint64(request.size()));
+    QVERIFY(method->bytesSent() * 10 < method->uncompressedBytesSent());
+
+    QCOMPARE(call.replyReadRaw(), replyBody);
+    QCOMPARE(method->bytesReceived(), qint64(compressedReply.size()));
+    QCOMPARE(method->uncompressedBytesReceived(), qint64(replyBody.size()));
+    QCOMPARE(method->replyReadParsed().toString(), QString(5000, QChar('r')));
+
+    // Below threshold, body is sent as it is.
+    method->resetByteCounters();
+    method->setCompressionThreshold(100000);
+    call = method->invoke();
+    for (int i = 0; (i < 50) && (spy.count() < 2); i++)
+        QTest::qWait(100);
+
+    QVERIFY(!server.lastRequestHeader().contains("Content-Encoding"));
+    QCOMPARE(method->bytesSent(), method->uncompressedBytesSent());
+    QCOMPARE(call.replyReadRaw(), replyBody);
+
+    delete method;
+}
+
+/*
+  Checks that concurrent calls over cleartext HTTP/2 share one connection.
+  */
+void TestQWebMethod::http2Test()
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 11, 0)
+    QSKIP("HTTP/2 with prior knowledge requires Qt 5.11.");
+#else
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    QCOMPARE(method->httpTransport(), QWebMethod::Http1);
+    method->setHttpTransport(QWebMethod::Http2Direct);
+    QCOMPARE(method->httpTransport(), QWebMethod::Http2Direct);
+
+    QWebNetworkPool::resetCounters();
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+    QList<QWebMethodCall> calls;
+    for (int i = 0; i < 10; i++)
+        calls.append(method->invoke());
+
+    for (int i = 0; (i < 50) && (spy.count() < 10); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(spy.count(), int(10));
+    foreach (const QWebMethodCall &call, calls) {
+        QCOMPARE(call.isErrorState(), bool(false));
+        QCOMPARE(call.isHttp2Used(), bool(true));
+        QVERIFY(call.replyReadRaw().contains("standInResult"));
+    }
+
+    QCOMPARE(server.connectionCount(), int(1));
+    QCOMPARE(server.http2StreamCount(), int(10));
+    QCOMPARE(QWebNetworkPool::http2StreamCount(), quint64(10));
+    QCOMPARE(QWebNetworkPool::http2ConnectionCount(), int(1));
+    QCOMPARE(QWebNetworkPool::streamsPerConnection(), double(10.0));
+
+    delete method;
+#endif
+}
+
+/*
+  Checks blocking calls: successful one, one that times out, and one
+  that fails, both with QWebMethod::invokeAndWait() and static
+  QWebServiceMethod::invokeMethod().
+  */
+void TestQWebMethod::synchronousInvokeTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+
+    QWebMethodCall call = method->invokeAndWait(5000);
+    QVERIFY(call.isValid());
+    QCOMPARE(call.isFinished(), bool(true));
+    QCOMPARE(call.isErrorState(), bool(false));
+    QVERIFY(call.replyReadRaw().contains("standInResult"));
+    QCOMPARE(spy.count(), int(1));
+    QCOMPARE(method->pendingCallCount(), int(0));
+
+    server.setReplyDelay(2000);
+    QTime timer;
+    timer.start();
+    call = method->invokeAndWait(200);
+    QVERIFY(timer.elapsed() < 1500);
+    QCOMPARE(call.isFinished(), bool(true));
+    QCOMPARE(call.isErrorState(), bool(true));
+    QCOMPARE(call.errorInfo(), QString("Request timed out."));
+    QCOMPARE(spy.count(), int(2));
+    QCOMPARE(method->pendingCallCount(), int(0));
+
+    server.setReplyDelay(0);
+    QString errorInfo;
+    QMap<QString, QVariant> params;
+    QByteArray reply = QWebServiceMethod::invokeMethod(
+                server.url(), "standIn", "http://tempuri.org/", params,
+                QWebMethod::Soap12, QWebMethod::Post, 0, 5000, &errorInfo);
+    QVERIFY(reply.contains("standInResult"));
+    QVERIFY(errorInfo.isEmpty());
+
+    QUrl closedPort = server.url();
+    server.close();
+    reply = QWebServiceMethod::invokeMethod(
+                closedPort, "standIn", "http://tempuri.org/", params,
+                QWebMethod::Soap12, QWebMethod::Post, 0, 5000, &errorInfo);
+    QVERIFY(reply.isEmpty());
+    QVERIFY(!errorInfo.isEmpty());
+
+    delete method;
+}
+
+/*
+  Checks futures and continuations of calls: results are consumed
+  in a QtConcurrent worker, a web method is used from a non-GUI thread,
+  and futures of dropped calls do not hang, but complete after
+  the web method is destroyed.
+  */
+void TestQWebMethod::futureTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+
+    QList<QFuture<QWebMethodCall> > futures;
+    for (int i = 0; i < 100; i++)
+        futures.append(method->invokeFuture());
+
+    int continued = 0;
+    method->invoke().then([&continued](const QWebMethodCall &call) {
+        if (call.result().toString() == QLatin1String("OK"))
+            continued++;
+    });
+
+    QFuture<int> okCount = QtConcurrent::run([futures]() {
+        int ok = 0;
+        foreach (const QFuture<QWebMethodCall> &future, futures) {
+            if (future.result().result().toString() == QLatin1String("OK"))
+                ok++;
+        }
+        return ok;
+    });
+
+    for (int i = 0; (i < 50) && !(okCount.isFinished() && (continued == 1)); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(okCount.result(), int(100));
+    QCOMPARE(continued, int(1));
+
+    // Finished calls give finished futures, and run continuations at once.
+    QWebMethodCall finished = futures.first().result();
+    QVERIFY(finished.future().isFinished());
+    finished.then([&continued](const QWebMethodCall &) { continued++; });
+    QCOMPARE(continued, int(2));
+
+    QUrl url = server.url();
+    QFuture<QString> fromWorker = QtConcurrent::run([url]() {
+        QWebMethod workerMethod(url, QWebMethod::Soap12, QWebMethod::Post);
+        workerMethod.setMethodName("standIn");
+        QWebMethodCall call = workerMethod.invoke();
+        QFuture<QWebMethodCall> future = call.future();
+        call.waitForFinished(5000);
+        return future.result().result().toString();
+    });
+
+    for (int i = 0; (i < 50) && !fromWorker.isFinished(); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(fromWorker.result(), QString("OK"));
+
+    // Dropped calls are completed after the web method is destroyed.
+    server.setReplyDelay(2000);
+    QPointer<QWebMethod> guard(method);
+    QWebMethodCall droppedCall = method->invoke();
+    QFuture<QWebMethodCall> dropped = droppedCall.future();
+    int continuationRuns = 0;
+    bool methodGone = false;
+    droppedCall.then([&continuationRuns, &methodGone, guard](const QWebMethodCall &) {
+        ++continuationRuns;
+        methodGone = guard.isNull();
+    });
+    delete method;
+    QCOMPARE(droppedCall.isFinished(), bool(true));
+    QCOMPARE(continuationRuns, int(0));
+    for (int i = 0; (i < 50) && !dropped.isFinished(); i++)
+        QTest::qWait(10);
+    QCOMPARE(dropped.isFinished(), bool(true));
+    QCOMPARE(dropped.result().isErrorState(), bool(true));
+    QCOMPARE(continuationRuns, int(1));
+    QCOMPARE(methodGone, bool(true));
+}
+
+/*
+  Checks per-host scheduling: number of running requests is capped,
+  bulk calls leave a connection for interactive ones, and queued
+  interactive calls are sent before queued bulk calls.
+  */
+void TestQWebMethod::schedulerTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReplyDelay(200);
+
+    QWebScheduler::setMaxConnectionsPerHost(2);
+    QWebScheduler::resetCounters();
+
+    QWebMethod *bulk = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    bulk->setMethodName("standIn");
+    bulk->setPriority(QWebMethod::Bulk);
+    QCOMPARE(bulk->priority(), QWebMethod::Bulk);
+
+    QWebMethod *interactive = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    interactive->setMethodName("standIn");
+
+    QStringList order;
+    int maxRunning = 0;
+    QUrl url = server.url();
+    for (int i = 0; i < 4; i++) {
+        bulk->invoke().then([&order, &maxRunning, url](const QWebMethodCall &) {
+            order.append("bulk");
+            maxRunning = qMax(maxRunning, QWebScheduler::runningCount(url));
+        });
+    }
+
+    // Bulk lane never takes the last connection.
+    QCOMPARE(QWebScheduler::runningCount(url), int(1));
+    QCOMPARE(bulk->pendingCallCount(), int(4));
+
+    for (int i = 0; i < 2; i++) {
+        interactive->invoke().then([&order, &maxRunning, url](const QWebMethodCall &) {
+            order.append("interactive");
+            maxRunning = qMax(maxRunning, QWebScheduler::runningCount(url));
+        });
+    }
+
+    QCOMPARE(QWebScheduler::runningCount(url), int(2));
+
+    for (int i = 0; (i < 50) && (order.size() < 6); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(order.size(), int(6));
+    QVERIFY(maxRunning <= 2);
+    QVERIFY(order.lastIndexOf("interactive") < order.lastIndexOf("bulk"));
+    QCOMPARE(QWebScheduler::runningCount(url), int(0));
+    QCOMPARE(QWebScheduler::queueDepth(QWebScheduler::Bulk), int(0));
+    QVERIFY(QWebScheduler::queuedCount(QWebScheduler::Bulk) >= 3);
+    QVERIFY(QWebScheduler::queuedCount(QWebScheduler::Interactive) >= 1);
+    QVERIFY(QWebScheduler::maxWaitTime(QWebScheduler::Bulk) > 0);
+
+    // Queued calls of a deleted web method are dropped, and free their place.
+    for (int i = 0; i < 4; i++)
+        bulk->invoke();
+    delete bulk;
+    QCOMPARE(QWebScheduler::queueDepth(QWebScheduler::Bulk), int(0));
+    QCOMPARE(QWebScheduler::runningCount(url), int(0));
+
+    QWebScheduler::setMaxConnectionsPerHost(6);
+    delete interactive;
+}
+
+/*
+  Checks retries of idempotent calls: transient errors are retried
+  with the same request body, other errors and non-idempotent methods
+  are not, and backoff delays stay within their bounds.
+  */
+void TestQWebMethod::retryTest()
+{
+    QWebRetryPolicy policy(5, 100, 300);
+    for (int attempt = 1; attempt <= 5; attempt++) {
+        int delay = policy.delay(attempt);
+        QVERIFY(delay >= 0);
+        QVERIFY(delay <= qMin(100 << (attempt - 1), 300));
+    }
+    QVERIFY(policy.isRetryableHttpStatus(503));
+    QVERIFY(!policy.isRetryableHttpStatus(404));
+    QVERIFY(policy.isRetryableFaultCode("soap:Server"));
+    QVERIFY(!policy.isRetryableFaultCode("env:Sender"));
+
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    method->setRetryPolicy(QWebRetryPolicy(3, 10));
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+
+    // Not idempotent - failure is reported at once.
+    server.setFailures(1, 503);
+    QWebMethodCall call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(true));
+    QCOMPARE(call.attemptCount(), int(1));
+    QCOMPARE(server.requestCount(), int(1));
+
+    method->setIdempotent(true);
+    server.setFailures(2, 503);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.attemptCount(), int(3));
+    QCOMPARE(call.result().toString(), QString("OK"));
+    QCOMPARE(server.requestCount(), int(4));
+    QCOMPARE(server.lastRequestBody(), call.requestData());
+    QCOMPARE(spy.count(), int(2));
+
+    server.setFailures(5, 502);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(true));
+    QCOMPARE(call.attemptCount(), int(3));
+    QCOMPARE(call.httpStatusCode(), int(502));
+    server.setFailures(0);
+
+    QByteArray fault("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                     "<env:Envelope xmlns:env=\"http://www.w3.org/2003/05/soap-envelope\">"
+                     "<env:Body><env:Fault><env:Code><env:Value>env:%1</env:Value></env:Code>"
+                     "<env:Reason><env:Text>Failed</env:Text></env:Reason>"
+                     "</env:Fault></env:Body></env:Envelope>");
+
+    server.setFailures(1, 500, QString(fault).arg("Sender").toUtf8());
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(true));
+    QCOMPARE(call.attemptCount(), int(1));
+
+    server.setFailures(1, 500, QString(fault).arg("Receiver").toUtf8());
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.attemptCount(), int(2));
+
+    // Closed port refuses connections, which is retried, too.
+    QUrl closedPort = server.url();
+    server.close();
+    method->setHost(closedPort);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(true));
+    QCOMPARE(call.attemptCount(), int(3));
+    QCOMPARE(method->pendingCallCount(), int(0));
+
+    delete method;
+}
+
+/*
+  Checks hedged requests: a late reply is raced by a hedge sent
+  to another endpoint, the first reply wins and the other request
+  is dropped. Budget and idempotency limit hedging, and hedges use
+  connections of QWebScheduler.
+  */
+void TestQWebMethod::hedgingTest()
+{
+    StandInServer slow;
+    QVERIFY(slow.listen());
+    slow.setReplyDelay(1500);
+    StandInServer fast;
+    QVERIFY(fast.listen());
+
+    QWebMethod *method = new QWebMethod(slow.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    method->setHedgingDelay(100);
+    method->setHedgingBudget(100);
+    method->setHedgingEndpoints(QList<QUrl>() << fast.url());
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+
+    // Not idempotent - no hedge.
+    QTime timer;
+    timer.start();
+    QWebMethodCall call = method->invokeAndWait(5000);
+    QVERIFY(timer.elapsed() >= 1000);
+    QCOMPARE(call.isHedged(), bool(false));
+    QCOMPARE(fast.requestCount(), int(0));
+
+    method->setIdempotent(true);
+    timer.restart();
+    call = method->invokeAndWait(5000);
+    QVERIFY(timer.elapsed() < 1000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.isHedged(), bool(true));
+    QCOMPARE(call.result().toString(), QString("OK"));
+    QCOMPARE(fast.requestCount(), int(1));
+    QCOMPARE(method->hedgedCallCount(), quint64(1));
+    QCOMPARE(method->hedgeWinCount(), quint64(1));
+
+    // Losing request is aborted, and does not finish the call again.
+    // Connections of both hosts are given back to QWebScheduler.
+    QTest::qWait(2000);
+    QCOMPARE(spy.count(), int(2));
+    QCOMPARE(method->pendingCallCount(), int(0));
+    QCOMPARE(QWebScheduler::runningCount(slow.url()), int(0));
+    QCOMPARE(QWebScheduler::runningCount(fast.url()), int(0));
+
+    // Hedges wait for a free connection of their host.
+    QWebScheduler::setMaxConnectionsPerHost(1);
+    fast.setReplyDelay(1000);
+    QWebMethod *occupant = new QWebMethod(fast.url(), QWebMethod::Soap12, QWebMethod::Post);
+    occupant->setMethodName("standIn");
+    QWebMethodCall occupying = occupant->invoke();
+    call = method->invoke();
+    QTest::qWait(500);
+    QCOMPARE(fast.requestCount(), int(2));
+    QCOMPARE(QWebScheduler::runningCount(fast.url()), int(1));
+    QVERIFY(occupying.waitForFinished(5000));
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.isHedged(), bool(true));
+    QCOMPARE(fast.requestCount(), int(3));
+    QCOMPARE(method->hedgeWinCount(), quint64(1));
+    QTest::qWait(100);
+    QCOMPARE(QWebScheduler::runningCount(fast.url()), int(0));
+    QCOMPARE(QWebScheduler::runningCount(slow.url()), int(0));
+    QWebScheduler::setMaxConnectionsPerHost(6);
+    fast.setReplyDelay(0);
+    delete occupant;
+
+    // Original request fails before the hedge replies - the hedge wins.
+    slow.setReplyDelay(300);
+    slow.setFailures(1);
+    fast.setReplyDelay(600);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.isHedged(), bool(true));
+    QCOMPARE(call.result().toString(), QString("OK"));
+    QCOMPARE(method->hedgedCallCount(), quint64(3));
+    QCOMPARE(method->hedgeWinCount(), quint64(2));
+    slow.setReplyDelay(1500);
+    fast.setReplyDelay(0);
+
+    // Fast replies are not hedged.
+    method->setHost(fast.url());
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isHedged(), bool(false));
+
+    // With no budget left, late calls wait for their reply.
+    method->setHost(slow.url());
+    method->setHedgingBudget(0);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.isHedged(), bool(false));
+    QCOMPARE(method->hedgedCallCount(), quint64(3));
+
+    delete method;
+}
+
+/*
+  Checks default timeouts, per-call deadlines and cancellation of calls:
+  explicit, by owner's destruction, and of all pending calls.
+  */
+void TestQWebMethod::timeoutTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReplyDelay(2000);
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    QSignalSpy spy(method, SIGNAL(callFinished(QWebMethodCall)));
+    QSignalSpy timeoutSpy(method, SIGNAL(timeoutChanged()));
+
+    method->setTimeout(200);
+    QCOMPARE(method->timeout(), int(200));
+    QCOMPARE(timeoutSpy.count(), int(1));
+
+    QTime timer;
+    timer.start();
+    QWebMethodCall call = method->invoke();
+    QVERIFY(call.waitForFinished(5000));
+    QVERIFY(timer.elapsed() < 1500);
+    QCOMPARE(call.isErrorState(), bool(true));
+    QCOMPARE(call.errorInfo(), QString("Request timed out."));
+
+    method->setTimeout(0);
+    timer.restart();
+    call = method->invoke();
+    call.setDeadline(QDateTime::currentDateTime().addMSecs(300));
+    QVERIFY(call.waitForFinished(5000));
+    QVERIFY(timer.elapsed() < 1500);
+    QCOMPARE(call.errorInfo(), QString("Request timed out."));
+
+    call = method->invoke();
+    QVERIFY(!call.requestData().isEmpty());
+    call.cancel();
+    QCOMPARE(call.isFinished(), bool(true));
+    QCOMPARE(call.isErrorState(), bool(true));
+    QVERIFY(call.requestData().isEmpty());
+    QCOMPARE(spy.count(), int(3));
+
+    QObject *owner = new QObject;
+    call = method->invoke().cancelWith(owner);
+    QVERIFY(method->invokeMethodFor(owner));
+    QCOMPARE(method->pendingCallCount(), int(2));
+    delete owner;
+    QCOMPARE(call.isFinished(), bool(true));
+    QCOMPARE(method->pendingCallCount(), int(0));
+
+    for (int i = 0; i < 3; i++)
+        method->invoke();
+    QCOMPARE(method->pendingCallCount(), int(3));
+    method->cancelPendingCalls();
+    QCOMPARE(method->pendingCallCount(), int(0));
+    QCOMPARE(spy.count(), int(8));
+
+    delete method;
+}
+
+/*
+  Checks coalescing of identical calls: they share one request and its
+  reply, different bodies get their own requests, and canceling one
+  waiting call leaves the others (and the request) alone.
+  */
+void TestQWebMethod::coalescingTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReplyDelay(300);
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    QCOMPARE(method->isCoalescing(), bool(false));
+    method->setCoalescing(true);
+    QCOMPARE(method->isCoalescing(), bool(true));
+    QSignalSpy callSpy(method, SIGNAL(callFinished(QWebMethodCall)));
+    QSignalSpy replySpy(method, SIGNAL(replyReady(QByteArray)));
+
+    QList<QWebMethodCall> calls;
+    for (int i = 0; i < 10; i++)
+        calls.append(method->invoke());
+    QWebMethodCall other = method->invoke("<other/>");
+    QCOMPARE(method->pendingCallCount(), int(11));
+    QCOMPARE(method->coalescedCallCount(), quint64(9));
+
+    calls.at(0).cancel();
+    QCOMPARE(calls.at(0).isErrorState(), bool(true));
+
+    for (int i = 1; i < calls.size(); i++)
+        QVERIFY(calls.at(i).waitForFinished(5000));
+    QVERIFY(other.waitForFinished(5000));
+    QCOMPARE(server.requestCount(), int(2));
+    QCOMPARE(callSpy.count(), int(11));
+    QCOMPARE(replySpy.count(), int(2));
+
+    for (int i = 1; i < calls.size(); i++) {
+        QCOMPARE(calls.at(i).isErrorState(), bool(false));
+        QCOMPARE(calls.at(i).result().toString(), QString("OK"));
+        // Reply buffer is shared, not copied.
+        QVERIFY(calls.at(i).replyReadRaw().constData()
+                == calls.at(1).replyReadRaw().constData());
+    }
+
+    // Finished requests are not joined.
+    QWebMethodCall call = method->invoke();
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(server.requestCount(), int(3));
+    QCOMPARE(method->coalescedCallCount(), quint64(9));
+
+    // Request is aborted when nobody waits for it.
+    call = method->invoke();
+    QWebMethodCall joined = method->invoke();
+    call.cancel();
+    joined.cancel();
+    QCOMPARE(method->pendingCallCount(), int(0));
+    QCOMPARE(joined.errorInfo(), QString("Call was aborted."));
+
+    delete method;
+}
+
+/*
+  Checks metrics of calls: counts, in-flight gauge, bytes, errors,
+  latency percentiles and OpenMetrics export.
+  */
+void TestQWebMethod::metricsTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReplyDelay(50);
+    QString host = QString("http://127.0.0.1:%1").arg(server.serverPort());
+
+    QWebMetrics::reset();
+    QCOMPARE(QWebMetrics::isEnabled(), bool(true));
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("metered");
+
+    QList<QWebMethodCall> calls;
+    for (int i = 0; i < 5; i++)
+        calls.append(method->invoke());
+    QCOMPARE(QWebMetrics::inFlightCount("metered"), int(5));
+    QVERIFY(QWebMetrics::methodNames().contains("metered"));
+    QVERIFY(QWebMetrics::hosts().contains(host));
+
+    foreach (QWebMethodCall call, calls)
+        QVERIFY(call.waitForFinished(5000));
+
+    QCOMPARE(QWebMetrics::callCount("metered"), quint64(5));
+    QCOMPARE(QWebMetrics::callCount("metered", host), quint64(5));
+    QCOMPARE(QWebMetrics::callCount("metered", "http://elsewhere"), quint64(0));
+    QCOMPARE(QWebMetrics::inFlightCount("metered"), int(0));
+    QCOMPARE(QWebMetrics::errorCount("metered"), quint64(0));
+    QCOMPARE(QWebMetrics::requestBytes("metered"), qint64(5 * calls.at(0).requestData().size()));
+    QCOMPARE(QWebMetrics::responseBytes("metered"), qint64(5 * calls.at(0).replyReadRaw().size()));
+
+    double median = QWebMetrics::latencyPercentile(50, "metered");
+    QVERIFY(median >= 45);
+    QVERIFY(median < 5000);
+    QVERIFY(QWebMetrics::latencyPercentile(99.9, "metered") >= median);
+
+    server.setFailures(1, 500);
+    QWebMethodCall failed = method->invoke();
+    QVERIFY(failed.waitForFinished(5000));
+    QCOMPARE(QWebMetrics::errorCount("metered"), quint64(1));
+
+    QByteArray exported = QWebMetrics::toOpenMetrics();
+    QByteArray labels = "{method=\"metered\",host=\"" + host.toLatin1() + "\"}";
+    QVERIFY(exported.contains("# TYPE qwebservice_calls counter\n"));
+    QVERIFY(exported.contains("qwebservice_calls_total" + labels + " 6\n"));
+    QVERIFY(exported.contains("qwebservice_call_errors_total" + labels + " 1\n"));
+    QVERIFY(exported.contains("qwebservice_call_duration_seconds_count" + labels + " 6\n"));
+    QVERIFY(exported.contains(",quantile=\"0.999\"}"));
+    QVERIFY(exported.endsWith("# EOF\n"));
+
+    // Disabled metrics are not recorded.
+    QWebMetrics::setEnabled(false);
+    QVERIFY(method->invoke().waitForFinished(5000));
+    QWebMetrics::setEnabled(true);
+    QCOMPARE(QWebMetrics::callCount("metered"), quint64(6));
+
+    QWebMetrics::reset();
+    QCOMPARE(QWebMetrics::callCount("metered"), quint64(0));
+    QCOMPARE(QWebMetrics::latencyPercentile(50, "metered"), double(0));
+
+    delete method;
+}
+
+/*
+  Checks timing of phases of a call (also a retried one), phase
+  histograms and the slow call log.
+  */
+void TestQWebMethod::timingTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+    server.setReplyDelay(100);
+    QWebMetrics::reset();
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("timed");
+
+    QWebMethodCall call = method->invoke();
+    QVERIFY(call.timing().serializeTime() >= 0);
+    QCOMPARE(call.timing().totalTime(), qint64(-1));
+    QVERIFY(call.waitForFinished(5000));
+
+    QWebCallTiming timing = call.timing();
+    QCOMPARE(timing.retryTime(), qint64(-1));
+    QVERIFY(timing.queueTime() >= 0);
+    // Plain HTTP, no TLS handshake.
+    QCOMPARE(timing.connectTime(), qint64(-1));
+    QVERIFY(timing.serverTime() >= 90000);
+    QVERIFY(timing.timeToFirstByte() >= timing.serverTime());
+    QVERIFY(timing.downloadTime() >= 0);
+    QVERIFY(timing.totalTime() >= timing.serializeTime() + timing.queueTime()
+            + timing.serverTime());
+    QCOMPARE(timing.parseTime(), qint64(-1));
+
+    QCOMPARE(call.result().toString(), QString("OK"));
+    QVERIFY(call.timing().parseTime() >= 0);
+
+    // Retried call: earlier attempt and retry delay are not queueing.
+    method->setIdempotent(true);
+    method->setRetryPolicy(QWebRetryPolicy(2, 300, 300));
+    server.setFailures(1, 503);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.attemptCount(), int(2));
+    timing = call.timing();
+    QVERIFY(timing.retryTime() >= 90000);
+    QVERIFY(timing.queueTime() < 90000);
+    QVERIFY(timing.totalTime() >= timing.serializeTime() + timing.retryTime()
+            + timing.queueTime() + timing.serverTime());
+
+    QVERIFY(QWebMetrics::phasePercentile(QWebMetrics::Server, 50, "timed") >= 90);
+    QVERIFY(QWebMetrics::phasePercentile(QWebMetrics::Queue, 50, "timed") < 90);
+    QCOMPARE(QWebMetrics::phasePercentile(QWebMetrics::Connect, 50, "timed"), double(0));
+    QVERIFY(QWebMetrics::toOpenMetrics().contains(
+                "qwebservice_call_phase_duration_seconds_count{method=\"timed\""));
+
+    QCOMPARE(QWebMetrics::slowCallThreshold(), int(0));
+    QWebMetrics::setSlowCallThreshold(50);
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("^Slow call of timed"));
+    QVERIFY(method->invoke().waitForFinished(5000));
+    QWebMetrics::setSlowCallThreshold(0);
+
+    delete method;
+}
+
+/*
+  Checks the stand-in server: replies derived from WSDL, in the protocol
+  of the request, served by worker threads, in chunks, padded, and
+  replaced with injected errors.
+  */
+void TestQWebMethod::standInServerTest()
+{
+    QWsdl wsdl(QString("../../../examples/wsdl/band_ws.asmx"));
+    QCOMPARE(wsdl.isErrorState(), bool(false));
+
+    StandInServer server;
+    server.setThreadCount(4);
+    server.setWsdl(&wsdl);
+    server.setChunkSize(16);
+    server.setReplyJitter(20);
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url("/band_ws.asmx"), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("getBandName");
+    method->setTargetNamespace("http://tempuri.org/");
+    method->setReturnValue(wsdl.methods()->value("getBandName")->returnValueNameType());
+
+    QList<QWebMethodCall> calls;
+    for (int i = 0; i < 20; i++)
+        calls.append(method->invoke());
+
+    foreach (QWebMethodCall call, calls) {
+        QVERIFY(call.waitForFinished(5000));
+        QCOMPARE(call.isErrorState(), bool(false));
+        QCOMPARE(call.result().toString(), QString("Some sample value"));
+    }
+    QCOMPARE(server.requestCount(), int(20));
+
+    // Operation of a JSON request is the last segment of its path.
+    QWebMethod *json = new QWebMethod(server.url("/band_ws.asmx/getBandName"), QWebMethod::Json, QWebMethod::Post);
+    QWebMethodCall call = json->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(call.result().toMap().value("getBandNameResult").toString(), QString("Some sample value"));
+
+    server.setReplySize(100000);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(false));
+    QVERIFY(call.replyReadRaw().size() >= 100000);
+    QCOMPARE(call.result().toString(), QString("Some sample value"));
+
+    server.setFailureRate(1.0, 500);
+    call = method->invokeAndWait(5000);
+    QCOMPARE(call.isErrorState(), bool(true));
+    QCOMPARE(call.httpStatusCode(), int(500));
+    QCOMPARE(server.failureCount(), int(1));
+
+    delete json;
+    delete method;
+}
+
 /*
   Checks QWebMethod operation when using the default sendmethod(QByteArray)
   */
+/*
+  Checks that a web method can be deleted from a slot connected to its
+  callFinished() signal, and the call is still completed.
+  */
+void TestQWebMethod::deleteFromSlotTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    QPointer<QWebMethod> guard(method);
+    connect(method, &QWebMethod::callFinished, [method]() { delete method; });
+
+    QWebMethodCall call = method->invoke();
+    int continuationRuns = 0;
+    call.then([&continuationRuns](const QWebMethodCall &) { ++continuationRuns; });
+    for (int i = 0; (i < 50) && !guard.isNull(); i++)
+        QTest::qWait(100);
+
+    QCOMPARE(guard.isNull(), bool(true));
+    QCOMPARE(call.isFinished(), bool(true));
+    QCOMPARE(call.isErrorState(), bool(false));
+    QCOMPARE(continuationRuns, int(1));
+}
+
 void TestQWebMethod::asynchronousSendingTest()
 {
     QWebMethod *method = new QWebMethod(0, QWebMethod::Soap12, QWebMethod::Post);
@@ -9,3 +9,5 @@ OBJECTS_DIR = $${TESTS_DIRECTORY}/QWebService
 MOC_DIR = $${TESTS_DIRECTORY}/QWebService
 
 SOURCES += tst_qwebservice.cpp
+
+include(../shared/shared.pri)
@@ -17,6 +17,7 @@
 
 #include <QtTest>
 #include <qwebservice.h>
+#include <standinserver.h>
 
 /**
   This test case checks both QWebService (and QWebService) functionality.
@@ -32,6 +33,8 @@ private slots:
     void settersTest();
     void qpropertyTest();
     void methodManagementTest();
+    void batchTest();
+    void cacheTest();
 };
 
 /*
@@ -186,5 +189,175 @@ void TestQWebService::methodManagementTest()
     delete reader;
 }
 
+/*
+  Invokes a batch against a stand-in server: results come in input order,
+  calls in flight stay within the limit, a missing method fails
+  only its own item, and items without parameters are sent without them.
+  */
+void TestQWebService::batchTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebService service;
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    service.addMethod(method);
+
+    QList<QWebBatch::Item> items;
+    for (int i = 0; i < 20; i++) {
+        QMap<QString, QVariant> params;
+        params.insert("index", i);
+        items.append(QWebBatch::Item("standIn", params));
+    }
+    items.insert(5, QWebBatch::Item("missing", QMap<QString, QVariant>()));
+
+    QWebBatch *batch = service.invokeBatch(items, 4);
+    QCOMPARE(batch->count(), int(21));
+    QCOMPARE(batch->maxInFlight(), int(4));
+
+    int maxInFlight = 0;
+    connect(batch, &QWebBatch::itemFinished, [batch, &maxInFlight]() {
+        maxInFlight = qMax(maxInFlight, batch->inFlightCount() + 1);
+    });
+    QSignalSpy itemSpy(batch, SIGNAL(itemFinished(int,QWebMethodCall)));
+
+    QVERIFY(batch->waitForFinished(10000));
+    QCOMPARE(itemSpy.count(), int(21));
+    QCOMPARE(batch->finishedCount(), int(21));
+    QCOMPARE(batch->errorCount(), int(1));
+    QVERIFY(maxInFlight <= 4);
+    QCOMPARE(server.requestCount(), int(20));
+
+    QList<QWebMethodCall> results = batch->results();
+    QCOMPARE(results.size(), int(21));
+    for (int i = 0; i < results.size(); i++) {
+        QCOMPARE(results.at(i).isFinished(), bool(true));
+        QCOMPARE(results.at(i).methodName(), items.at(i).first);
+        if (i == 5) {
+            QCOMPARE(results.at(i).isErrorState(), bool(true));
+        } else {
+            QCOMPARE(results.at(i).isErrorState(), bool(false));
+            QCOMPARE(results.at(i).result().toString(), QString("OK"));
+        }
+    }
+
+    // Serialized parameters follow the items.
+    QVERIFY(results.at(0).requestData().contains("<index>0</index>"));
+    QVERIFY(results.at(20).requestData().contains("<index>19</index>"));
+
+    delete batch;
+
+    // Items without parameters do not reuse those of previous items.
+    QMap<QString, QVariant> params;
+    params.insert("index", 42);
+    items.clear();
+    items << QWebBatch::Item("standIn", params)
+          << QWebBatch::Item("standIn", QMap<QString, QVariant>())
+          << QWebBatch::Item("standIn", params)
+          << QWebBatch::Item("standIn", QMap<QString, QVariant>());
+
+    batch = service.invokeBatch(items, 2);
+    QVERIFY(batch->waitForFinished(10000));
+    QCOMPARE(batch->errorCount(), int(0));
+
+    results = batch->results();
+    QCOMPARE(results.size(), int(4));
+    for (int i = 0; i < results.size(); i++) {
+        QCOMPARE(results.at(i).requestData().contains("<index>42</index>"),
+                 bool(!items.at(i).second.isEmpty()));
+    }
+
+    delete batch;
+}
+
+/*
+  Checks the result cache: repeated calls are answered without a request
+  (but still asynchronously), different parameters or hosts, expired
+  entries and replies over the budget miss the cache.
+  */
+void TestQWebService::cacheTest()
+{
+    StandInServer server;
+    QVERIFY(server.listen());
+
+    QWebService service;
+    QWebMethod *method = new QWebMethod(server.url(), QWebMethod::Soap12, QWebMethod::Post);
+    method->setMethodName("standIn");
+    service.addMethod(method);
+    QCOMPARE(service.cacheTtl("standIn"), int(0));
+    QCOMPARE(service.cacheBudget(), int(4 * 1024 * 1024));
+
+    service.setCacheTtl("standIn", 60000);
+    QCOMPARE(service.cacheTtl("standIn"), int(60000));
+
+    QMap<QString, QVariant> params;
+    params.insert("index", 1);
+    QWebMethodCall call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(call.isFromCache(), bool(false));
+    QCOMPARE(server.requestCount(), int(1));
+    QCOMPARE(service.cacheMissCount(), quint64(1));
+    QVERIFY(service.cacheSize() > 0);
+
+    QSignalSpy replySpy(&service, SIGNAL(replyReady(QByteArray,QString)));
+    QWebMethodCall cached = service.invoke("standIn", params);
+    QVERIFY(cached.isValid());
+    QCOMPARE(cached.isFromCache(), bool(true));
+    QCOMPARE(cached.isFinished(), bool(false));
+    QCOMPARE(replySpy.count(), int(0));
+    QVERIFY(cached.waitForFinished(5000));
+    QCOMPARE(replySpy.count(), int(1));
+    QCOMPARE(cached.replyReadRaw(), call.replyReadRaw());
+    QCOMPARE(cached.result().toString(), QString("OK"));
+    QCOMPARE(service.cacheHitCount(), quint64(1));
+    QCOMPARE(server.requestCount(), int(1));
+
+    // Different parameters, different key.
+    params.insert("index", 2);
+    call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(call.isFromCache(), bool(false));
+    QCOMPARE(server.requestCount(), int(2));
+    QCOMPARE(service.cacheMissCount(), quint64(2));
+
+    // Expired entries are not used.
+    service.clearCache();
+    QCOMPARE(service.cacheSize(), int(0));
+    service.setCacheTtl("standIn", 50);
+    call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QTest::qWait(100);
+    call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(call.isFromCache(), bool(false));
+    QCOMPARE(server.requestCount(), int(4));
+
+    // Replies bigger than the budget are not stored.
+    service.clearCache();
+    service.setCacheTtl("standIn", 60000);
+    service.setCacheBudget(1);
+    call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(service.cacheSize(), int(0));
+    call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(call.isFromCache(), bool(false));
+    QCOMPARE(server.requestCount(), int(6));
+
+    // Method moved to another host, different key.
+    StandInServer otherServer;
+    QVERIFY(otherServer.listen());
+    service.setCacheBudget(4 * 1024 * 1024);
+    call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(server.requestCount(), int(7));
+    method->setHost(otherServer.url());
+    call = service.invoke("standIn", params);
+    QVERIFY(call.waitForFinished(5000));
+    QCOMPARE(call.isFromCache(), bool(false));
+    QCOMPARE(otherServer.requestCount(), int(1));
+}
+
 QTEST_MAIN(TestQWebService)
 #include "tst_qwebservice.moc"
@@ -0,0 +1,18 @@
+include(../../buildInfo.pri)
+
+QT += testlib
+
+include(../../libraryIncludes.pri)
+
+DESTDIR = $${TESTS_DIRECTORY}/qtwsbench
+OBJECTS_DIR = $${TESTS_DIRECTORY}/qtwsbench
+MOC_DIR = $${TESTS_DIRECTORY}/qtwsbench
+
+SOURCES += tst_qtwsbench.cpp \
+    ../../qtwsbench/sources/loadgenerator.cpp \
+    ../../qtwsbench/sources/parametergenerator.cpp
+
+HEADERS += ../../qtwsbench/headers/loadgenerator.h \
+    ../../qtwsbench/headers/parametergenerator.h
+
+include(../shared/shared.pri)
@@ -0,0 +1,167 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the qtWsBench test suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <qwsdl.h>
+#include <standinserver.h>
+#include "../../qtwsbench/headers/loadgenerator.h"
+#include "../../qtwsbench/headers/parametergenerator.h"
+
+/**
+  This test checks qtwsbench load generator against a stand-in server
+  (does not require Internet connection).
+  */
+class tst_qtwsbench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void argumentsTest();
+    void parametersTest();
+    void closedLoopTest();
+    void openLoopTest();
+
+private:
+    QString wsdlPath;
+};
+
+void tst_qtwsbench::initTestCase()
+{
+    wsdlPath = QString("../../../examples/wsdl/band_ws.asmx");
+}
+
+/*
+  Checks that wrong arguments put load generator in error state.
+  */
+void tst_qtwsbench::argumentsTest()
+{
+    LoadGenerator help(QStringList() << "--help");
+    QCOMPARE(help.isErrorState(), bool(true));
+    QVERIFY(help.errorInfo().startsWith("qtwsbench [options]"));
+
+    LoadGenerator noWsdl(QStringList() << "--concurrency=4");
+    QCOMPARE(noWsdl.isErrorState(), bool(true));
+
+    LoadGenerator badValue(QStringList() << "--rate=fast" << wsdlPath);
+    QCOMPARE(badValue.isErrorState(), bool(true));
+
+    LoadGenerator noOperation(QStringList() << "--host=http://127.0.0.1/"
+                              << "--operation=noSuchOperation" << wsdlPath);
+    QCOMPARE(noOperation.isErrorState(), bool(true));
+    QCOMPARE(noOperation.run(), bool(false));
+}
+
+/*
+  Checks random parameter values of given types, their reproducibility
+  with a seed, and values taken from a template.
+  */
+void tst_qtwsbench::parametersTest()
+{
+    QMap<QString, QVariant> types;
+    types.insert("id", QVariant(QVariant::Int));
+    types.insert("price", QVariant(QVariant::Double));
+    types.insert("active", QVariant(QVariant::Bool));
+    types.insert("date", QVariant(QVariant::DateTime));
+    types.insert("name", QVariant(QVariant::String));
+
+    ParameterGenerator first(42);
+    ParameterGenerator second(42);
+    QMap<QString, QVariant> values = first.parameters("op", types);
+    QCOMPARE(values, second.parameters("op", types));
+
+    QCOMPARE(values.value("id").userType(), int(QMetaType::Int));
+    QCOMPARE(values.value("price").userType(), int(QMetaType::Double));
+    QCOMPARE(values.value("active").userType(), int(QMetaType::Bool));
+    QCOMPARE(values.value("date").userType(), int(QMetaType::QDateTime));
+    QVERIFY(!values.value("name").toString().isEmpty());
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("{ \"*\": { \"name\": \"common\" }, \"op\": { \"id\": 7 } }");
+    file.close();
+
+    QVERIFY(first.loadTemplate(file.fileName()));
+    values = first.parameters("op", types);
+    QCOMPARE(values.value("id").toInt(), int(7));
+    QCOMPARE(values.value("name").toString(), QString("common"));
+    QCOMPARE(first.parameters("other", types).value("name").toString(), QString("common"));
+
+    QCOMPARE(first.loadTemplate("no_such_file.json"), bool(false));
+}
+
+/*
+  Checks closed loop run with a limit of requests.
+  */
+void tst_qtwsbench::closedLoopTest()
+{
+    QWsdl wsdl(wsdlPath);
+    StandInServer server;
+    server.setThreadCount(2);
+    server.setWsdl(&wsdl);
+    QVERIFY(server.listen());
+
+    QStringList arguments;
+    arguments << ("--host=" + server.url("/band_ws.asmx").toString())
+              << "--operation=getBandName,getGenreList"
+              << "--concurrency=4" << "--requests=40" << wsdlPath;
+
+    LoadGenerator generator(arguments);
+    QCOMPARE(generator.isErrorState(), bool(false));
+    QCOMPARE(generator.run(), bool(true));
+
+    QCOMPARE(generator.sentCount(), qint64(40));
+    QCOMPARE(generator.succeededCount(), qint64(40));
+    QCOMPARE(generator.failedCount(), qint64(0));
+    QCOMPARE(server.requestCount(), int(40));
+    QVERIFY(generator.throughput() > 0);
+    QVERIFY(generator.latencyPercentile(50) <= generator.latencyPercentile(100));
+    QVERIFY(generator.report().contains("getGenreList: 20"));
+}
+
+/*
+  Checks open loop run at a fixed rate, and breakdown of errors.
+  */
+void tst_qtwsbench::openLoopTest()
+{
+    QWsdl wsdl(wsdlPath);
+    StandInServer server;
+    server.setWsdl(&wsdl);
+    server.setFailureRate(0.5, 503);
+    QVERIFY(server.listen());
+
+    QStringList arguments;
+    arguments << ("--host=" + server.url("/band_ws.asmx").toString())
+              << "--json" << "--rate=100" << "--concurrency=50" << "--duration=1"
+              << "--json-report" << wsdlPath;
+
+    LoadGenerator generator(arguments);
+    QCOMPARE(generator.isErrorState(), bool(false));
+    QCOMPARE(generator.run(), bool(true));
+
+    QVERIFY(generator.sentCount() + generator.skippedCount() >= 90);
+    QVERIFY(generator.sentCount() + generator.skippedCount() <= 101);
+    QCOMPARE(generator.succeededCount() + generator.failedCount(), generator.sentCount());
+    QCOMPARE(generator.errorBreakdown().value("HTTP 503"), int(server.failureCount()));
+
+    QJsonDocument report = QJsonDocument::fromJson(generator.report().toUtf8());
+    QCOMPARE(report.object().value("mode").toString(), QString("open"));
+    QVERIFY(report.object().value("latency").toObject().contains("p99"));
+}
+
+QTEST_MAIN(tst_qtwsbench)
+#include "tst_qtwsbench.moc"
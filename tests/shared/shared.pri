@@ -0,0 +1,9 @@
+# Helpers shared by tests and benchmarks.
+QT += network
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += $$PWD/standinserver.cpp
+
+HEADERS += $$PWD/standinserver.h
@@ -0,0 +1,829 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService test suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "standinserver.h"
+
+#include <qwebmethod.h>
+#include <qwsdl.h>
+
+#include <QtNetwork/qhostaddress.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qxmlstream.h>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QtCore/qrandom.h>
+#endif
+
+StandInServer::StandInServer(QObject *parent) :
+    QTcpServer(parent), nextThread(0), replyDelay(0), replyJitter(0),
+    replySize(0), chunkSize(0), chunkInterval(0), failures(0), failureRate(0),
+    failureStatus(503), requests(0), received(0), connections(0),
+    http2Streams(0), injectedFailures(0)
+{
+    setReply("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+             "<soap12:Envelope xmlns:soap12=\"http://www.w3.org/2003/05/soap-envelope\">"
+             "<soap12:Body><standInResponse xmlns=\"http://tempuri.org/\">"
+             "<standInResult>OK</standInResult>"
+             "</standInResponse></soap12:Body></soap12:Envelope>");
+}
+
+/*
+  Stops listening and waits for worker threads. Connections served
+  by them are closed.
+  */
+StandInServer::~StandInServer()
+{
+    close();
+    stopThreads();
+}
+
+/*
+  Starts listening on a random port of loopback interface.
+  */
+bool StandInServer::listen()
+{
+    return QTcpServer::listen(QHostAddress::LocalHost, 0);
+}
+
+/*
+  Returns URL of given \a path on this server.
+  */
+QUrl StandInServer::url(const QString &path) const
+{
+    return QUrl(QString(QLatin1String("http://127.0.0.1:%1%2"))
+                .arg(serverPort()).arg(path));
+}
+
+/*
+  Serves connections in \a count worker threads (0 means the thread
+  of the server, which is the default). Should be called before listen().
+  */
+void StandInServer::setThreadCount(int count)
+{
+    stopThreads();
+
+    for (int i = 0; i < count; i++) {
+        QThread *thread = new QThread;
+        thread->start();
+        threads.append(thread);
+    }
+}
+
+/*
+  Sets \a body and \a contentType of the default reply.
+  */
+void StandInServer::setReply(const QByteArray &body, const QByteArray &contentType)
+{
+    QMutexLocker locker(&mutex);
+    replyBody = body;
+    replyContentType = contentType;
+}
+
+/*
+  Sets \a body and \a contentType of reply sent to requests of \a path
+  (query is ignored). Useful for REST services.
+  */
+void StandInServer::setPathReply(const QString &path, const QByteArray &body,
+                                 const QByteArray &contentType)
+{
+    QMutexLocker locker(&mutex);
+    pathReplies.insert(path, qMakePair(body, contentType));
+}
+
+/*
+  Answers operations of \a wsdl with their return values, filled with
+  sample data of the right type.
+
+  SOAP requests name the operation in their body. Other requests should
+  end their path with operation name, unless \a wsdl has only one operation.
+  */
+void StandInServer::setWsdl(QWsdl *wsdl)
+{
+    QHash<QString, Operation> result;
+
+    foreach (QWebMethod *method, wsdl->methods()->values()) {
+        Operation operation;
+        operation.targetNamespace = method->targetNamespace();
+        operation.returnValue = method->returnValueNameType();
+        result.insert(method->methodName(), operation);
+    }
+
+    QMutexLocker locker(&mutex);
+    operations = result;
+}
+
+/*
+  Adds header \a name with \a value to all replies.
+  */
+void StandInServer::setReplyHeader(const QByteArray &name, const QByteArray &value)
+{
+    QMutexLocker locker(&mutex);
+    replyHeaders += name + ": " + value + "\r\n";
+}
+
+/*
+  Delays all replies by \a msecs milliseconds, to simulate a slow server.
+  */
+void StandInServer::setReplyDelay(int msecs)
+{
+    QMutexLocker locker(&mutex);
+    replyDelay = msecs;
+}
+
+/*
+  Adds a random delay, up to \a msecs milliseconds, to the reply delay.
+  */
+void StandInServer::setReplyJitter(int msecs)
+{
+    QMutexLocker locker(&mutex);
+    replyJitter = msecs;
+}
+
+/*
+  Pads replies to at least \a bytes. XML replies are padded with
+  a comment following the document, others with spaces.
+  */
+void StandInServer::setReplySize(int bytes)
+{
+    QMutexLocker locker(&mutex);
+    replySize = bytes;
+}
+
+/*
+  Sends HTTP/1.1 replies with chunked transfer encoding, in chunks
+  of \a bytes (0 turns chunking off). With \a intervalMsecs, chunks
+  are written one by one, with a pause between them.
+  */
+void StandInServer::setChunkSize(int bytes, int intervalMsecs)
+{
+    QMutexLocker locker(&mutex);
+    chunkSize = bytes;
+    chunkInterval = intervalMsecs;
+}
+
+/*
+  Answers next \a count HTTP/1.1 requests with \a status and \a body,
+  instead of the reply, to simulate transient server errors. Status 0
+  closes the connection without a reply.
+  */
+void StandInServer::setFailures(int count, int status, const QByteArray &body)
+{
+    QMutexLocker locker(&mutex);
+    failures = count;
+    failureStatus = status;
+    failureBody = body;
+}
+
+/*
+  Answers a random part (\a rate, between 0 and 1) of HTTP/1.1 requests
+  with \a status and \a body. Status 0 closes the connection without
+  a reply.
+  */
+void StandInServer::setFailureRate(qreal rate, int status, const QByteArray &body)
+{
+    QMutexLocker locker(&mutex);
+    failureRate = rate;
+    failureStatus = status;
+    failureBody = body;
+}
+
+int StandInServer::requestCount() const
+{
+    QMutexLocker locker(&mutex);
+    return requests;
+}
+
+/*
+  Returns number of request body bytes received so far.
+  */
+qint64 StandInServer::bytesReceived() const
+{
+    QMutexLocker locker(&mutex);
+    return received;
+}
+
+QByteArray StandInServer::lastRequestHeader() const
+{
+    QMutexLocker locker(&mutex);
+    return lastHeader;
+}
+
+/*
+  Returns body of last request. Only bodies up to 1 MB are stored.
+  */
+QByteArray StandInServer::lastRequestBody() const
+{
+    QMutexLocker locker(&mutex);
+    return lastBody;
+}
+
+/*
+  Returns number of connections accepted so far.
+  */
+int StandInServer::connectionCount() const
+{
+    QMutexLocker locker(&mutex);
+    return connections;
+}
+
+/*
+  Returns number of requests received as HTTP/2 streams.
+  */
+int StandInServer::http2StreamCount() const
+{
+    QMutexLocker locker(&mutex);
+    return http2Streams;
+}
+
+/*
+  Returns number of requests answered with an error (or dropped),
+  by setFailures() or setFailureRate().
+  */
+int StandInServer::failureCount() const
+{
+    QMutexLocker locker(&mutex);
+    return injectedFailures;
+}
+
+void StandInServer::incomingConnection(qintptr socketDescriptor)
+{
+    mutex.lock();
+    ++connections;
+    mutex.unlock();
+
+    StandInConnection *connection = new StandInConnection(this, socketDescriptor);
+
+    if (threads.isEmpty()) {
+        connection->setParent(this);
+        connection->start();
+        return;
+    }
+
+    QThread *thread = threads.at(nextThread++ % threads.size());
+    connection->moveToThread(thread);
+    connect(thread, SIGNAL(finished()), connection, SLOT(deleteLater()));
+    QMetaObject::invokeMethod(connection, "start", Qt::QueuedConnection);
+}
+
+/*
+  Returns reply to request with \a header and (start of) \a body,
+  and counts the request. HTTP/2 requests (\a http2) always get the default
+  reply.
+  */
+StandInServer::Reply StandInServer::reply(const QByteArray &header,
+                                          const QByteArray &body, bool http2)
+{
+    Reply result;
+    QHash<QString, Operation> known;
+    int size = 0;
+
+    {
+        QMutexLocker locker(&mutex);
+        ++requests;
+        lastHeader = header;
+        lastBody = body;
+
+        result.delay = replyDelay;
+        if (replyJitter > 0)
+            result.delay += boundedRandom(replyJitter + 1);
+
+        result.contentType = replyContentType;
+        result.body = replyBody;
+
+        if (http2) {
+            ++http2Streams;
+            return result;
+        }
+
+        result.headers = replyHeaders;
+        result.chunkSize = chunkSize;
+        result.chunkInterval = chunkInterval;
+
+        bool fail = false;
+        if (failures > 0) {
+            --failures;
+            fail = true;
+        } else if (failureRate > 0) {
+            fail = (boundedRandom(10000) < qRound(failureRate * 10000));
+        }
+
+        if (fail) {
+            ++injectedFailures;
+            result.status = failureStatus;
+            result.drop = (failureStatus == 0);
+            result.body = failureBody;
+            return result;
+        }
+
+        QString path = QUrl(QString::fromLatin1(header.split(' ').value(1))).path();
+        if (pathReplies.contains(path)) {
+            result.body = pathReplies.value(path).first;
+            result.contentType = pathReplies.value(path).second;
+        } else {
+            known = operations;
+        }
+        size = replySize;
+    }
+
+    // Operation replies are built out of the lock, from a copy of operations.
+    QString operation = requestedOperation(header, body, known);
+    if (!operation.isEmpty()) {
+        result.body = operationReply(operation, known.value(operation), header,
+                                     &result.contentType);
+    }
+
+    pad(result.body, result.contentType, size);
+    return result;
+}
+
+void StandInServer::addReceived(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    received += bytes;
+}
+
+/*
+  Stops worker threads. Connections living in them are deleted when
+  threads finish.
+  */
+void StandInServer::stopThreads()
+{
+    foreach (QThread *thread, threads) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+    threads.clear();
+}
+
+/*
+  Returns reply of operation \a name, in protocol of request with \a header.
+  Sets \a contentType of the reply.
+  */
+QByteArray StandInServer::operationReply(const QString &name, const Operation &operation,
+                                         const QByteArray &header, QByteArray *contentType)
+{
+    QByteArray requestType = headerValue(header, "content-type").toLower();
+    bool soapAction = hasHeader(header, "soapaction");
+    QByteArray result;
+
+    if (requestType.contains("json")) {
+        *contentType = "application/json; charset=utf-8";
+        QVariantMap values;
+        QMap<QString, QVariant>::const_iterator i = operation.returnValue.constBegin();
+        for (; i != operation.returnValue.constEnd(); ++i)
+            values.insert(i.key(), sampleValue(i.value()));
+        return QJsonDocument::fromVariant(values).toJson(QJsonDocument::Compact);
+    }
+
+    QXmlStreamWriter writer(&result);
+    writer.writeStartDocument();
+
+    QString envelope;
+    if (requestType.contains("soap") || soapAction) {
+        // SOAP 1.0 requests carry SOAPAction header.
+        if (soapAction) {
+            *contentType = "text/xml; charset=utf-8";
+            envelope = QLatin1String("http://schemas.xmlsoap.org/soap/envelope/");
+        } else {
+            *contentType = "application/soap+xml; charset=utf-8";
+            envelope = QLatin1String("http://www.w3.org/2003/05/soap-envelope");
+        }
+        writer.writeNamespace(envelope, QLatin1String("soap"));
+        writer.writeStartElement(envelope, QLatin1String("Envelope"));
+        writer.writeStartElement(envelope, QLatin1String("Body"));
+    } else {
+        *contentType = "application/xml; charset=utf-8";
+    }
+
+    writer.writeDefaultNamespace(operation.targetNamespace);
+    writer.writeStartElement(operation.targetNamespace, name + QLatin1String("Response"));
+
+    QMap<QString, QVariant>::const_iterator i = operation.returnValue.constBegin();
+    for (; i != operation.returnValue.constEnd(); ++i) {
+        QVariant value = sampleValue(i.value());
+        writer.writeTextElement(operation.targetNamespace, i.key(),
+                                (value.type() == QVariant::DateTime) ?
+                                    value.toDateTime().toString(Qt::ISODate)
+                                  : value.toString());
+    }
+
+    writer.writeEndDocument();
+    return result;
+}
+
+/*
+  Returns name of the operation requested by \a header and \a body,
+  or an empty string, if it is not one of \a operations.
+  */
+QString StandInServer::requestedOperation(const QByteArray &header, const QByteArray &body,
+                                          const QHash<QString, Operation> &operations)
+{
+    if (operations.isEmpty())
+        return QString();
+
+    QByteArray requestType = headerValue(header, "content-type").toLower();
+    if (requestType.contains("soap") || hasHeader(header, "soapaction")) {
+        // Operation is the first element in SOAP Body.
+        QXmlStreamReader reader(body);
+        bool inBody = false;
+        while (!reader.atEnd()) {
+            if (reader.readNext() != QXmlStreamReader::StartElement)
+                continue;
+            if (inBody) {
+                QString name = reader.name().toString();
+                return operations.contains(name) ? name : QString();
+            }
+            inBody = (reader.name() == QLatin1String("Body"));
+        }
+        return QString();
+    }
+
+    QString path = QUrl(QString::fromLatin1(header.split(' ').value(1))).path();
+    QString name = path.section(QLatin1Char('/'), -1);
+    if (operations.contains(name))
+        return name;
+    if (operations.size() == 1)
+        return operations.constBegin().key();
+    return QString();
+}
+
+/*
+  Returns value of header field \a name (lower case), or an empty QByteArray.
+  */
+QByteArray StandInServer::headerValue(const QByteArray &header, const QByteArray &name)
+{
+    foreach (const QByteArray &line, header.split('\n')) {
+        int colon = line.indexOf(':');
+        if (colon < 0)
+            continue;
+
+        if (line.left(colon).trimmed().toLower() == name)
+            return line.mid(colon + 1).trimmed();
+    }
+
+    return QByteArray();
+}
+
+/*
+  Returns true, if \a header has a field \a name (lower case), even if empty.
+  */
+bool StandInServer::hasHeader(const QByteArray &header, const QByteArray &name)
+{
+    return header.toLower().contains("\n" + name + ':');
+}
+
+/*
+  Returns an example value of given \a type (see QWebMethod::returnValueNameType()).
+  */
+QVariant StandInServer::sampleValue(const QVariant &type)
+{
+    switch (type.userType()) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return QVariant(1304);
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return QVariant(1304.5);
+    case QMetaType::Bool:
+        return QVariant(true);
+    case QMetaType::QDateTime:
+        return QVariant(QDateTime(QDate(2011, 11, 11), QTime(11, 11)));
+    default:
+        return QVariant(QString(QLatin1String("Some sample value")));
+    }
+}
+
+/*
+  Pads \a body of \a contentType to \a size bytes.
+  */
+void StandInServer::pad(QByteArray &body, const QByteArray &contentType, int size)
+{
+    int missing = size - body.size();
+    if (missing <= 0)
+        return;
+
+    if (contentType.contains("xml") && (missing >= 7)) {
+        body += "<!--";
+        body += QByteArray(missing - 7, 'x');
+        body += "-->";
+    } else {
+        body += QByteArray(missing, ' ');
+    }
+}
+
+/*
+  Returns a random number from 0 to \a bound - 1.
+  */
+int StandInServer::boundedRandom(int bound)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    return int(QRandomGenerator::global()->bounded(quint32(bound)));
+#else
+    return qrand() % bound;
+#endif
+}
+
+StandInConnection::StandInConnection(StandInServer *server, qintptr socketDescriptor) :
+    QObject(0), server(server), descriptor(socketDescriptor), socket(0),
+    headerDone(false), remaining(0), protocolKnown(false), http2(false)
+{
+}
+
+/*
+  Opens the socket, in the thread of the connection.
+  */
+void StandInConnection::start()
+{
+    socket = new QTcpSocket(this);
+    socket->setSocketDescriptor(descriptor);
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readClient()));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+}
+
+void StandInConnection::readClient()
+{
+    if (!protocolKnown) {
+        QByteArray start = socket->peek(http2Preface().size());
+        if (!http2Preface().startsWith(start)) {
+            protocolKnown = true;
+        } else if (start.size() == http2Preface().size()) {
+            protocolKnown = true;
+            http2 = true;
+            socket->read(start.size());
+            // Server's connection preface is an empty SETTINGS frame.
+            socket->write(http2Frame(0x4, 0, 0));
+        } else {
+            return;
+        }
+    }
+
+    if (http2) {
+        readHttp2();
+        return;
+    }
+
+    while (socket->bytesAvailable() > 0) {
+        if (!headerDone) {
+            if (!socket->canReadLine())
+                return;
+
+            QByteArray line = socket->readLine();
+            header += line;
+
+            if (line == "\r\n") {
+                processHeader();
+                if (remaining == 0)
+                    sendReply();
+            }
+            continue;
+        }
+
+        // Body is consumed in pieces and dropped, so that large uploads
+        // do not inflate memory use of the test process.
+        QByteArray chunk = socket->read(qMin<qint64>(remaining, 64 * 1024));
+        remaining -= chunk.size();
+        server->addReceived(chunk.size());
+
+        if (body.size() + chunk.size() <= 1024 * 1024)
+            body += chunk;
+
+        if (remaining == 0)
+            sendReply();
+    }
+}
+
+void StandInConnection::clientDisconnected()
+{
+    deleteLater();
+}
+
+/*
+  Reads HTTP/2 frames sent by the client. Each stream is answered as soon
+  as its request (headers and body) is complete.
+  */
+void StandInConnection::readHttp2()
+{
+    buffer += socket->readAll();
+
+    while (buffer.size() >= 9) {
+        const uchar *frameHeader = reinterpret_cast<const uchar *>(buffer.constData());
+        quint32 length = (quint32(frameHeader[0]) << 16) | (quint32(frameHeader[1]) << 8)
+                | frameHeader[2];
+        quint8 type = frameHeader[3];
+        quint8 flags = frameHeader[4];
+        quint32 streamId = ((quint32(frameHeader[5]) << 24) | (quint32(frameHeader[6]) << 16)
+                            | (quint32(frameHeader[7]) << 8) | frameHeader[8]) & 0x7fffffff;
+
+        if (quint32(buffer.size()) < 9 + length)
+            return;
+
+        QByteArray payload = buffer.mid(9, length);
+        buffer.remove(0, 9 + length);
+
+        if (type == 0x0) { // DATA
+            qint64 size = payload.size();
+            if ((flags & 0x8) && !payload.isEmpty()) // PADDED
+                size -= 1 + uchar(payload.at(0));
+            server->addReceived(size);
+
+            if (length > 0) {
+                QByteArray increment(4, 0);
+                increment[0] = char((length >> 24) & 0x7f);
+                increment[1] = char((length >> 16) & 0xff);
+                increment[2] = char((length >> 8) & 0xff);
+                increment[3] = char(length & 0xff);
+                socket->write(http2Frame(0x8, 0, 0, increment));
+                socket->write(http2Frame(0x8, 0, streamId, increment));
+            }
+
+            if (flags & 0x1)
+                endedStreams.insert(streamId);
+        } else if (type == 0x1) { // HEADERS
+            streams.insert(streamId, (flags & 0x4) != 0);
+            if (flags & 0x1)
+                endedStreams.insert(streamId);
+        } else if (type == 0x9) { // CONTINUATION
+            if (flags & 0x4)
+                streams.insert(streamId, true);
+        } else if (type == 0x4) { // SETTINGS
+            if (!(flags & 0x1))
+                socket->write(http2Frame(0x4, 0x1, 0));
+        } else if (type == 0x6) { // PING
+            if (!(flags & 0x1))
+                socket->write(http2Frame(0x6, 0x1, 0, payload));
+        }
+
+        if (streams.value(streamId, false) && endedStreams.contains(streamId)) {
+            streams.remove(streamId);
+            endedStreams.remove(streamId);
+            sendHttp2Reply(streamId);
+        }
+    }
+}
+
+/*
+  Answers HTTP/2 stream \a streamId. Response headers are encoded
+  with HPACK static table references and literals only.
+  */
+void StandInConnection::sendHttp2Reply(quint32 streamId)
+{
+    StandInServer::Reply reply = server->reply(QByteArray(), QByteArray(), true);
+
+    QByteArray contentLength = QByteArray::number(reply.body.size());
+    QByteArray headers;
+    headers += char(0x88); // :status 200
+    headers += char(0x0f); // content-type, literal value
+    headers += char(0x10);
+    headers += char(reply.contentType.size());
+    headers += reply.contentType;
+    headers += char(0x0f); // content-length, literal value
+    headers += char(0x0d);
+    headers += char(contentLength.size());
+    headers += contentLength;
+
+    if (reply.body.isEmpty()) {
+        writeReply(QList<QByteArray>() << http2Frame(0x1, 0x4 | 0x1, streamId, headers),
+                   reply.delay, 0);
+        return;
+    }
+
+    QByteArray frames = http2Frame(0x1, 0x4, streamId, headers);
+
+    for (int position = 0; position < reply.body.size(); position += 16384) {
+        QByteArray piece = reply.body.mid(position, 16384);
+        bool last = (position + piece.size() >= reply.body.size());
+        frames += http2Frame(0x0, last ? 0x1 : 0x0, streamId, piece);
+    }
+
+    writeReply(QList<QByteArray>() << frames, reply.delay, 0);
+}
+
+/*
+  Writes reply \a pieces to the socket, first one after \a delay, and each
+  of the others \a interval milliseconds later.
+  */
+void StandInConnection::writeReply(const QList<QByteArray> &pieces, int delay, int interval)
+{
+    if (pieces.isEmpty())
+        return;
+
+    if (delay > 0) {
+        QTimer::singleShot(delay, this, [this, pieces, interval]() {
+            writeReply(pieces, 0, interval);
+        });
+        return;
+    }
+
+    if (interval <= 0) {
+        foreach (const QByteArray &piece, pieces)
+            socket->write(piece);
+        return;
+    }
+
+    socket->write(pieces.first());
+    writeReply(pieces.mid(1), interval, interval);
+}
+
+/*
+  Returns HTTP/2 client connection preface.
+  */
+QByteArray StandInConnection::http2Preface()
+{
+    return QByteArray("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
+}
+
+/*
+  Returns HTTP/2 frame of given \a type, with \a flags and \a payload,
+  for stream \a streamId.
+  */
+QByteArray StandInConnection::http2Frame(quint8 type, quint8 flags, quint32 streamId,
+                                         const QByteArray &payload)
+{
+    QByteArray frame(9, 0);
+    frame[0] = char((payload.size() >> 16) & 0xff);
+    frame[1] = char((payload.size() >> 8) & 0xff);
+    frame[2] = char(payload.size() & 0xff);
+    frame[3] = char(type);
+    frame[4] = char(flags);
+    frame[5] = char((streamId >> 24) & 0x7f);
+    frame[6] = char((streamId >> 16) & 0xff);
+    frame[7] = char((streamId >> 8) & 0xff);
+    frame[8] = char(streamId & 0xff);
+    return frame + payload;
+}
+
+/*
+  Reads body length from complete request header.
+  */
+void StandInConnection::processHeader()
+{
+    headerDone = true;
+    remaining = 0;
+    body.clear();
+
+    remaining = StandInServer::headerValue(header, "content-length").toLongLong();
+}
+
+/*
+  Sends the reply, and prepares for next request on the same
+  (kept-alive) connection.
+  */
+void StandInConnection::sendReply()
+{
+    StandInServer::Reply reply = server->reply(header, body);
+
+    header.clear();
+    headerDone = false;
+    remaining = 0;
+    body.clear();
+
+    if (reply.drop) {
+        socket->disconnectFromHost();
+        return;
+    }
+
+    QByteArray status = QByteArray::number(reply.status)
+            + ((reply.status == 200) ? " OK" : " Error");
+    QByteArray response("HTTP/1.1 " + status + "\r\n"
+                        "Connection: keep-alive\r\n"
+                        "Content-Type: " + reply.contentType + "\r\n");
+    QList<QByteArray> pieces;
+
+    if (reply.chunkSize <= 0) {
+        response += "Content-Length: " + QByteArray::number(reply.body.size()) + "\r\n"
+                + reply.headers + "\r\n";
+        response += reply.body;
+        pieces.append(response);
+    } else {
+        response += "Transfer-Encoding: chunked\r\n" + reply.headers + "\r\n";
+        pieces.append(response);
+
+        for (int position = 0; position < reply.body.size(); position += reply.chunkSize) {
+            QByteArray piece = reply.body.mid(position, reply.chunkSize);
+            pieces.append(QByteArray::number(piece.size(), 16) + "\r\n" + piece + "\r\n");
+        }
+        pieces.append("0\r\n\r\n");
+    }
+
+    writeReply(pieces, reply.delay, reply.chunkInterval);
+}
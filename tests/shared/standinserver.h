@@ -0,0 +1,205 @@
+/****************************************************************************
+**
+** Copyright (C) 2011 Tomasz Siekierda
+** All rights reserved.
+** Contact: Tomasz Siekierda (sierdzio@gmail.com)
+**
+** This file is part of the QWebService test suite.
+**
+** This file may be used under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation and
+** appearing in the file LICENSE.txt included in the packaging of this
+** file. Please review the following information to ensure the GNU Lesser
+** General Public License version 2.1 requirements will be met:
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#ifndef STANDINSERVER_H
+#define STANDINSERVER_H
+
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpair.h>
+#include <QtCore/qset.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qvariant.h>
+
+class QThread;
+class QWsdl;
+
+/*
+  Minimal HTTP/1.1 server, used by tests and benchmarks instead of
+  a real web service. Listens on loopback interface, and consumes request
+  bodies without storing them.
+
+  Each request gets the first matching reply of:
+  - a reply set for request's path (setPathReply()),
+  - a reply of requested operation, if a WSDL was loaded (setWsdl()).
+    Protocol of the request (SOAP 1.0, SOAP 1.2, JSON, XML or REST/HTTP)
+    decides the format of the reply,
+  - the default reply (setReply()).
+  Replies can be delayed (with jitter), padded to a size, sent in chunks,
+  or replaced with errors.
+
+  Connections are served in the thread of the server, unless
+  setThreadCount() was used: then they are spread over worker threads,
+  and the server can be used by load tests. All setters and getters
+  are thread safe.
+
+  Connections starting with HTTP/2 connection preface are served with
+  cleartext HTTP/2 (h2c with prior knowledge). Only what is needed to answer
+  requests is implemented: request headers are not decoded, and flow control
+  of replies is ignored, so replies should stay below 64 KB. HTTP/2 requests
+  always get the default reply, and are not failed, padded nor chunked.
+  */
+class StandInServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit StandInServer(QObject *parent = 0);
+    ~StandInServer();
+
+    bool listen();
+    QUrl url(const QString &path = QLatin1String("/")) const;
+    void setThreadCount(int count);
+
+    void setReply(const QByteArray &body,
+                  const QByteArray &contentType = "application/soap+xml; charset=utf-8");
+    void setPathReply(const QString &path, const QByteArray &body,
+                      const QByteArray &contentType = "application/soap+xml; charset=utf-8");
+    void setWsdl(QWsdl *wsdl);
+    void setReplyHeader(const QByteArray &name, const QByteArray &value);
+    void setReplyDelay(int msecs);
+    void setReplyJitter(int msecs);
+    void setReplySize(int bytes);
+    void setChunkSize(int bytes, int intervalMsecs = 0);
+    void setFailures(int count, int status = 503, const QByteArray &body = QByteArray());
+    void setFailureRate(qreal rate, int status = 503, const QByteArray &body = QByteArray());
+
+    int requestCount() const;
+    qint64 bytesReceived() const;
+    QByteArray lastRequestHeader() const;
+    QByteArray lastRequestBody() const;
+    int connectionCount() const;
+    int http2StreamCount() const;
+    int failureCount() const;
+
+protected:
+    void incomingConnection(qintptr socketDescriptor);
+
+private:
+    friend class StandInConnection;
+
+    struct Operation
+    {
+        QString targetNamespace;
+        QMap<QString, QVariant> returnValue;
+    };
+
+    struct Reply
+    {
+        Reply() : status(200), drop(false), delay(0), chunkSize(0),
+            chunkInterval(0) {}
+
+        int status;
+        // Connection is closed instead of sending the reply.
+        bool drop;
+        QByteArray contentType;
+        QByteArray headers;
+        QByteArray body;
+        int delay;
+        int chunkSize;
+        int chunkInterval;
+    };
+
+    Reply reply(const QByteArray &header, const QByteArray &body, bool http2 = false);
+    void addReceived(qint64 bytes);
+    void stopThreads();
+    static QByteArray operationReply(const QString &name, const Operation &operation,
+                                     const QByteArray &header, QByteArray *contentType);
+    static QString requestedOperation(const QByteArray &header, const QByteArray &body,
+                                      const QHash<QString, Operation> &operations);
+    static QByteArray headerValue(const QByteArray &header, const QByteArray &name);
+    static bool hasHeader(const QByteArray &header, const QByteArray &name);
+    static QVariant sampleValue(const QVariant &type);
+    static void pad(QByteArray &body, const QByteArray &contentType, int size);
+    static int boundedRandom(int bound);
+
+    mutable QMutex mutex;
+    QList<QThread *> threads;
+    int nextThread;
+    QByteArray replyBody;
+    QByteArray replyContentType;
+    QByteArray replyHeaders;
+    QHash<QString, QPair<QByteArray, QByteArray> > pathReplies;
+    QHash<QString, Operation> operations;
+    int replyDelay;
+    int replyJitter;
+    int replySize;
+    int chunkSize;
+    int chunkInterval;
+    int failures;
+    qreal failureRate;
+    int failureStatus;
+    QByteArray failureBody;
+    QByteArray lastHeader;
+    QByteArray lastBody;
+    int requests;
+    qint64 received;
+    int connections;
+    int http2Streams;
+    int injectedFailures;
+};
+
+/*
+  Serves one connection of StandInServer, in the thread it lives in.
+  */
+class StandInConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    StandInConnection(StandInServer *server, qintptr socketDescriptor);
+
+public slots:
+    void start();
+
+private slots:
+    void readClient();
+    void clientDisconnected();
+
+private:
+    void processHeader();
+    void sendReply();
+    void readHttp2();
+    void sendHttp2Reply(quint32 streamId);
+    void writeReply(const QList<QByteArray> &pieces, int delay, int interval);
+    static QByteArray http2Preface();
+    static QByteArray http2Frame(quint8 type, quint8 flags, quint32 streamId,
+                                 const QByteArray &payload = QByteArray());
+
+    StandInServer *server;
+    qintptr descriptor;
+    QTcpSocket *socket;
+    QByteArray header;
+    bool headerDone;
+    qint64 remaining;
+    // Start of request body, up to 1 MB.
+    QByteArray body;
+    bool protocolKnown;
+    bool http2;
+    QByteArray buffer;
+    // HTTP/2 streams, which have not been answered yet. Value tells
+    // if request headers are complete.
+    QHash<quint32, bool> streams;
+    QSet<quint32> endedStreams;
+};
+
+#endif // STANDINSERVER_H
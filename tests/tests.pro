@@ -5,7 +5,9 @@ TEMPLATE = subdirs
 SUBDIRS += \
     QWebService \
     QWebMethod \
+    QWebCoroutine \
     QWebServiceMethod \
     QWsdl \
-    qtwsdlconvert
+    qtwsdlconvert \
+    qtwsbench
 